@@ -26,6 +26,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <limits.h>
 #include <stdio.h>
 
 #if	defined(SPEAKER_SCOREBOARD) && defined(CACHE_CONTROL_BLOCKS)
@@ -69,6 +70,11 @@
 #define AST_CONF_PROB_START 0.05
 #define AST_CONF_PROB_CONTINUE 0.02
 
+// members run the fixed point preprocessor ( 0 == OFF, 1 == ON, the F flag turns it on per member )
+#ifndef	AST_CONF_SPEEX_FIXED
+#define AST_CONF_SPEEX_FIXED 0
+#endif
+
 #endif
 
 //
@@ -132,8 +138,12 @@
 // account for friendly offset when allocating buffer for frame
 #define AST_CONF_BUFFER_SIZE (AST_CONF_FRAME_DATA_SIZE + AST_FRIENDLY_OFFSET)
 
-// maximum number of frames queued per member
-#define AST_CONF_MAX_QUEUE 100
+// maximum number of frames queued per member (a power of two)
+#define AST_CONF_MAX_QUEUE 128
+
+#if	AST_CONF_MAX_QUEUE & (AST_CONF_MAX_QUEUE - 1)
+#error AST_CONF_MAX_QUEUE must be a power of two
+#endif
 
 //
 // timer and sleep values
@@ -143,6 +153,101 @@
 // event before we check for outgoing frames
 #define AST_CONF_WAITFOR_LATENCY 40
 
+//
+// mixer thread values
+//
+
+// number of conference mixer threads (conferences are sharded across them)
+#ifndef	AST_CONF_MIXER_THREADS
+#define AST_CONF_MIXER_THREADS 1
+#endif
+
+// mix cost (microseconds per tick) above which a conference
+// is moved to a dedicated mixer thread ( 0 == OFF )
+#ifndef	AST_CONF_DEDICATED_MIXER_COST
+#define AST_CONF_DEDICATED_MIXER_COST 2000
+#endif
+
+// mix cost below which a conference is moved back to a shared mixer thread
+#define AST_CONF_SHARED_MIXER_COST (AST_CONF_DEDICATED_MIXER_COST / 4)
+
+// encoder threads converting a conference's listener frame
+// to its write formats in parallel ( 0 == OFF )
+#ifndef	AST_CONF_ENCODE_THREADS
+#define AST_CONF_ENCODE_THREADS 2
+#endif
+
+// member threads decode their incoming frames and encode their speaker
+// mix, so the mixer only mixes ( 0 == OFF )
+#ifndef	AST_CONF_MEMBER_CODECS
+#define AST_CONF_MEMBER_CODECS 0
+#endif
+
+// threads reading the sounds played to members ahead of their output ( 0 == OFF )
+#ifndef	AST_CONF_SOUND_READERS
+#define AST_CONF_SOUND_READERS 2
+#endif
+
+// frames of a sound read ahead for a member ( refilled at half )
+#define AST_CONF_SOUND_PREFETCH 25
+
+// a lone member hears music on hold decoded and encoded once by the
+// module instead of a generator on its channel ( 0 == OFF )
+#ifndef	AST_CONF_SHARED_MOH
+#define AST_CONF_SHARED_MOH 1
+#endif
+
+// divisor of the conference audio under a ducking announcement ( 4 == -12 db )
+#ifndef	AST_CONF_DUCK_VOLUME
+#define AST_CONF_DUCK_VOLUME 4
+#endif
+
+// incoming frames are held to a depth adapted to the member's arrival jitter ( 0 == OFF )
+#ifndef	AST_CONF_JITTER_BUFFER
+#define AST_CONF_JITTER_BUFFER 1
+#endif
+
+#if	AST_CONF_JITTER_BUFFER
+// largest target depth in frames ( arrival gaps longer than it are pauses, not jitter )
+#define AST_CONF_JB_MAX_DEPTH 10
+
+// frames above the target depth before speech is dropped to catch up
+#define AST_CONF_JB_SLACK 2
+
+// mean amplitude below which frames above the target depth are dropped at once
+#define AST_CONF_JB_QUIET 128
+#endif
+
+// initial size of a conference tick array (it doubles as members join)
+#define AST_CONF_TICK_BLOCK 16
+
+// members ahead of the mixer whose data is prefetched
+#define AST_CONF_TICK_PREFETCH 4
+
+#if	SILDET == 1
+// incoming frames collected for one batched vad call (a multiple of the vad lanes)
+#define AST_CONF_VAD_BATCH 32
+#endif
+
+#if	SILDET == 1 || SILDET == 2
+// energy pre-gate margin in db above a member's noise floor ( 0 == OFF )
+#ifndef	AST_CONF_VAD_GATE
+#define AST_CONF_VAD_GATE 6
+#endif
+
+// mean square level above which frames always reach the preprocessor (amplitude 128)
+#define AST_CONF_VAD_GATE_CEILING (128.0f * 128.0f)
+
+// frames for the noise floor to follow a louder level (about 2 seconds)
+#define AST_CONF_VAD_GATE_RISE 100
+
+// every nth frame gated in a row reaches the preprocessor anyway to keep its noise model adapting
+#define AST_CONF_VAD_GATE_FEED 8
+#endif
+
+// (format, listen volume) pairs a listener frame keeps converted for the listeners at that volume
+#define AST_CONF_VOLUME_FRAMES 8
+
 //
 // format translation values
 //
@@ -169,6 +274,15 @@
 //
 #define AST_CONF_MAX_USERS 0
 
+//
+// Default conference max speakers is zero, that is, unbounded
+//
+#define AST_CONF_MAX_SPEAKERS 0
+
+// percentage by which a mixed speaker's energy is boosted when ranking
+// speakers, so that speakers of similar loudness don't swap every frame
+#define AST_CONF_SPEAKER_HYSTERESIS 50
+
 //
 // Default conference type
 //
@@ -177,10 +291,13 @@
 #define EVENT_FLAG_CONF EVENT_FLAG_USER
 
 typedef struct ast_conference ast_conference;
+typedef struct ast_conf_mixer ast_conf_mixer;
 typedef struct ast_conf_member ast_conf_member;
+typedef struct ast_conf_tick ast_conf_tick;
 typedef struct ast_conf_soundq ast_conf_soundq;
 typedef struct ast_conf_frameq ast_conf_frameq;
 typedef struct conf_frame conf_frame;
+typedef struct ast_conf_sharedframe ast_conf_sharedframe;
 
 const char *argument_delimiter;
 
@@ -195,10 +312,6 @@ struct conference_bucket conference_table[CONFERENCE_TABLE_SIZE];
 AST_LIST_HEAD(channel_bucket, ast_conf_member);
 struct channel_bucket channel_table[CHANNEL_TABLE_SIZE];
 
-#ifdef	CACHE_CONF_FRAMES
-AST_LIST_HEAD_NOLOCK(confFrameList, conf_frame) confFrameList;
-#endif
-
 conf_frame *silent_conf_frame;
 
 #ifdef	CACHE_CONTROL_BLOCKS
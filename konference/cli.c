@@ -19,6 +19,9 @@
 #include "asterisk/autoconfig.h"
 #include "cli.h"
 #include "conference.h"
+#include "member.h"
+#include "slab.h"
+#include "trans.h"
 
 #ifdef AST_CLI_DEFINE
 
@@ -177,6 +180,61 @@ char *conference_list(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a)
 	}
 	return SUCCESS;
 }
+//
+// stats
+//
+static char conference_stats_usage[] =
+	"Usage: konference stats {<conference_name>}\n"
+	"       Display frame queue statistics of conferences or of the members of a conference\n"
+	"       and frame allocator statistics if no conference is specified\n"
+;
+
+#define CONFERENCE_STATS_CHOICES { "konference", "stats", NULL }
+static char conference_stats_summary[] = "Display conference statistics";
+
+#ifndef AST_CLI_DEFINE
+static struct ast_cli_entry cli_stats = {
+	CONFERENCE_STATS_CHOICES,
+	conference_stats,
+	conference_stats_summary,
+	conference_stats_usage
+};
+int conference_stats(int fd, int argc, char *argv[]) {
+#else
+static char conference_stats_command[] = "konference stats";
+char *conference_stats(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a) {
+#if	ASTERISK_SRC_VERSION == 104 || ASTERISK_SRC_VERSION == 106
+	static char *choices[] = CONFERENCE_STATS_CHOICES;
+#else
+	static const char *const choices[] = CONFERENCE_STATS_CHOICES;
+#endif
+	NEWCLI_SWITCH(conference_stats_command,conference_stats_usage)
+#endif
+	if (argc < 2)
+		return SHOWUSAGE;
+
+	if (argc >= 3)
+	{
+		int index;
+		for (index = 2; index < argc; index++)
+		{
+			// get the conference name
+			const char* name = argv[index];
+			stats_members(fd, name);
+		}
+	}
+	else
+	{
+		stats_conferences(fd);
+		slab_stats(fd);
+		trans_path_stats(fd);
+#if	AST_CONF_SOUND_READERS
+		sound_reader_stats(fd);
+#endif
+	}
+	return SUCCESS;
+}
+
 #ifdef	KICK_MEMBER
 //
 // kick member <member id>
@@ -551,14 +609,16 @@ char *conference_unmutechannel(struct ast_cli_entry *e, int cmd, struct ast_cli_
 // play sound
 //
 static char conference_play_sound_usage[] =
-	"Usage: konference play sound <channel> (<sound-file>)+ [mute|tone]\n"
+	"Usage: konference play sound (<channel>|<conference name>) (<sound-file>)+ [mute|tone|duck]\n"
 	"       Play sound(s) (<sound-file>)+ to conference member <channel>\n"
+	"       or to every member of conference <conference name>\n"
 	"       If mute is specified, all other audio is muted while the sound is played back\n"
 	"       If tone is specified, the sound is discarded if another sound is queued\n"
+	"       If duck is specified, the conference audio is lowered while the sound is played back\n"
 ;
 
 #define CONFERENCE_PLAY_SOUND_CHOICES { "konference", "play", "sound", NULL }
-static char conference_play_sound_summary[] = "Play a sound to a conference member";
+static char conference_play_sound_summary[] = "Play a sound to a conference member or conference";
 
 #ifndef AST_CLI_DEFINE
 static struct ast_cli_entry cli_play_sound = {
@@ -590,8 +650,14 @@ char *conference_play_sound(struct ast_cli_entry *e, int cmd, struct ast_cli_arg
 
 	int mute = argc > 5 && !strcmp(argv[argc-1], "mute") ? 1 : 0;
 	int tone = argc > 5 && !strcmp(argv[argc-1], "tone") ? 1 : 0;
+	int duck = argc > 5 && !strcmp(argv[argc-1], "duck") ? 1 : 0;
+	int n = !mute && !tone && !duck ? argc - 4 : argc - 5;
 
-	play_sound_channel(fd, channel, file, mute, tone, !mute && !tone ? argc - 4 : argc - 5);
+	// not a member, the sounds are mixed into the conference audio, decoded once for every member
+	if (play_sound_channel(fd, channel, file, mute, tone, n))
+	{
+		play_sound_conference(fd, channel, file, mute ? AST_CONF_SOUND_MUTE : duck ? AST_CONF_SOUND_DUCK : AST_CONF_SOUND_MIX, tone, n);
+	}
 
 	return SUCCESS;
 }
@@ -600,8 +666,9 @@ char *conference_play_sound(struct ast_cli_entry *e, int cmd, struct ast_cli_arg
 // stop sounds
 //
 static char conference_stop_sounds_usage[] =
-	"Usage: konference stop sounds <channel>\n"
+	"Usage: konference stop sounds (<channel>|<conference name>)\n"
 	"       Stop sounds for conference member <channel>\n"
+	"       or the sounds played to conference <conference name>\n"
 ;
 
 #define CONFERENCE_STOP_SOUNDS_CHOICES { "konference", "stop", "sounds", NULL }
@@ -630,7 +697,10 @@ char *conference_stop_sounds(struct ast_cli_entry *e, int cmd, struct ast_cli_ar
 
 	const char *channel = argv[3];
 
-	stop_sound_channel(fd, channel);
+	if (stop_sound_channel(fd, channel))
+	{
+		stop_sound_conference(fd, channel);
+	}
 
 	return SUCCESS;
 }
@@ -906,6 +976,7 @@ static struct ast_cli_entry app_konference_commands[] = {
 	AST_CLI_DEFINE(conference_version, conference_version_summary),
 	AST_CLI_DEFINE(conference_restart, conference_restart_summary),
 	AST_CLI_DEFINE(conference_list, conference_list_summary),
+	AST_CLI_DEFINE(conference_stats, conference_stats_summary),
 #ifdef	KICK_MEMBER
 	AST_CLI_DEFINE(conference_kick, conference_kick_summary),
 #endif
@@ -939,6 +1010,7 @@ void register_conference_cli(void)
 	ast_cli_register(&cli_version);
 	ast_cli_register(&cli_restart);
 	ast_cli_register(&cli_list);
+	ast_cli_register(&cli_stats);
 #ifdef	KICK_MEMBER
 	ast_cli_register(&cli_kick);
 #endif
@@ -972,6 +1044,7 @@ void unregister_conference_cli(void)
 	ast_cli_unregister(&cli_version);
 	ast_cli_unregister(&cli_restart);
 	ast_cli_unregister(&cli_list);
+	ast_cli_unregister(&cli_stats);
 #ifdef	KICK_MEMBER
 	ast_cli_unregister(&cli_kick);
 #endif
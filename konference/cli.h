@@ -36,6 +36,7 @@ int conference_version(int fd, int argc, char *argv[]);
 int conference_restart(int fd, int argc, char *argv[]);
 
 int conference_list(int fd, int argc, char *argv[]);
+int conference_stats(int fd, int argc, char *argv[]);
 #ifdef	KICK_MEMBER
 int conference_kick(int fd, int argc, char *argv[]);
 #endif
@@ -70,6 +71,7 @@ char *conference_version(struct ast_cli_entry *, int, struct ast_cli_args *);
 char *conference_restart(struct ast_cli_entry *, int, struct ast_cli_args *);
 
 char *conference_list(struct ast_cli_entry *, int, struct ast_cli_args *);
+char *conference_stats(struct ast_cli_entry *, int, struct ast_cli_args *);
 #ifdef	KICK_MEMBER
 char *conference_kick(struct ast_cli_entry *, int, struct ast_cli_args *);
 #endif
@@ -29,6 +29,16 @@
 // struct declarations
 //
 
+// a listener frame converted to a format at a listen volume
+struct conf_volume_frame
+{
+	int format_index;
+	int volume;
+
+	// shared copy for the outgoing queues of the listeners at that format and volume
+	ast_conf_sharedframe* shared;
+};
+
 struct conf_frame
 {
 	// frame audio data
@@ -37,10 +47,12 @@ struct conf_frame
 	// array of converted versions for listeners
 	struct ast_frame* converted[AC_SUPPORTED_FORMATS];
 
-#ifdef	CACHE_CONF_FRAMES
-	// pointer to next frame in cache
-	AST_LIST_ENTRY(conf_frame) frame_list;
-#endif
+	// array of shared copies of the converted versions for outgoing queues
+	ast_conf_sharedframe* shared[AC_SUPPORTED_FORMATS];
+
+	// converted versions for listeners with a listen volume
+	struct conf_volume_frame volume_frames[AST_CONF_VOLUME_FRAMES];
+	int volume_frame_count;
 
 	// pointer to the frame's owner
 	ast_conf_member* member; // who sent this frame
@@ -52,9 +64,30 @@ struct conf_frame
 	// pointer to mixing buffer
 	char* mixed_buffer;
 
-	// conference + speaker volume
+	// slab copy of the frame owned by this conf frame
+	ast_conf_sharedframe* copy;
+
+	// slinear frame decoded from the copy without a translator
+	ast_conf_sharedframe* decoded;
+
+	// conference + speaker volume ( or non-zero when the converted versions are stale )
 	int talk_volume;
 };
 
+// an immutable, reference counted copy of an outgoing frame that is queued
+// to every member receiving the same audio on a tick and released after it
+// is written to the member's channel
+struct ast_conf_sharedframe
+{
+	// frame (must be first), never modified once queued
+	struct ast_frame fr;
+
+	// reference count
+	int refcount;
+
+	// frame data
+	char data[AST_CONF_FRAME_DATA_SIZE];
+};
+
 
 #endif
@@ -20,6 +20,9 @@
 #include "asterisk/autoconfig.h"
 #include "conference.h"
 #include "frame.h"
+#include "slab.h"
+#include "trans.h"
+#include "moh.h"
 #include "asterisk/utils.h"
 
 #include "asterisk/app.h"
@@ -53,6 +56,38 @@ struct ast_format ast_format_g722 = { .id = AST_FORMAT_G722 };
 #endif
 #endif
 
+//
+// struct declarations
+//
+
+struct ast_conf_mixer
+{
+	// mixer index
+	int index;
+
+	// dedicated to a single oversized conference
+	int dedicated;
+
+	// a conference was moved to this mixer
+	int pending;
+
+	// slice of the conference list mixed by this thread
+	ast_conference *conflist;
+
+	// number of conferences in the slice
+	int conference_count;
+
+#ifdef	TIMERFD
+	// timer file descriptor
+	int timerfd;
+#elif	KQUEUE
+	// kqueue file descriptor
+	int kqueuefd;
+	struct kevent inqueue;
+	struct kevent outqueue;
+#endif
+};
+
 //
 // static variables
 //
@@ -63,17 +98,64 @@ static ast_conference *conflist;
 // unique counter for conferences
 static int conference_uniqueint;
 
-#ifdef	TIMERFD
-// timer file descriptor
-static int timerfd = -1;
-#elif	KQUEUE
-// kqueue file descriptor
-static int kqueuefd = -1;
-static struct kevent inqueue;
-static struct kevent outqueue;
+// conference mixer threads
+static ast_conf_mixer mixers[AST_CONF_MIXER_THREADS];
+
+// write format names for the stats
+static const char *format_names[AC_SUPPORTED_FORMATS] = {
+#ifndef	AC_USE_G722
+	[AC_CONF_INDEX] = "slinear",
+#else
+	[AC_CONF_INDEX] = "slinear16",
+#endif
+	[AC_ULAW_INDEX] = "ulaw",
+	[AC_ALAW_INDEX] = "alaw",
+	[AC_GSM_INDEX] = "gsm",
+#ifdef	AC_USE_SPEEX
+	[AC_SPEEX_INDEX] = "speex",
+#endif
+#ifdef	AC_USE_G729A
+	[AC_G729A_INDEX] = "g729a",
+#endif
+#ifdef	AC_USE_G722
+	[AC_SLINEAR_INDEX] = "slinear",
+	[AC_G722_INDEX] = "g722",
+#endif
+};
+
+#if	AST_CONF_ENCODE_THREADS
+// write formats of a listener frame shared out to the encoder threads
+typedef struct encode_batch
+{
+	ast_conference *conf;
+
+	int formats[AC_SUPPORTED_FORMATS];
+	int count;
+
+	// next format to encode and formats not yet encoded
+	int next;
+	int pending;
+
+	// batches waiting for an encoder
+	struct encode_batch *next_batch;
+
+	// signaled when the last format is encoded
+	ast_cond_t done;
+} encode_batch;
+
+// encoder threads
+static pthread_t encoders[AST_CONF_ENCODE_THREADS];
+static int encoder_count;
+static int encoders_stopping;
+
+// batch queue
+static encode_batch *encode_queue;
+static encode_batch *encode_queue_last;
+AST_MUTEX_DEFINE_STATIC(encode_lock);
+static ast_cond_t encode_work;
 #endif
 
-// mutex for synchronizing access to conflist
+// mutex for synchronizing access to conflist and the mixer slices
 AST_MUTEX_DEFINE_STATIC(conflist_lock);
 
 static int conference_count;
@@ -83,13 +165,361 @@ static ast_conference* find_conf(const char* name);
 //static void get_unison_event_server_node_variable(struct ast_channel* channel, char **varval, char *workspace, int wssize);
 static ast_conference* create_conf(char* name, ast_conf_member* member);
 static ast_conference* remove_conf(ast_conference* conf);
-static void add_member(ast_conf_member* member, ast_conference* conf);
+static int add_member(ast_conf_member* member, ast_conference* conf);
+static ast_conf_mixer *select_mixer(void);
+static int start_mixer(ast_conf_mixer *mixer);
+static void stop_mixer(ast_conf_mixer *mixer);
+#if	AST_CONF_DEDICATED_MIXER_COST
+static int move_conf(ast_conference *conf, ast_conf_mixer *mixer);
+#endif
+
+//
+// keep the max_speakers loudest spoken frames and treat
+// the remaining speakers as listeners for this tick
+//
+
+static int speaker_rank(const conf_frame *cf)
+{
+	const ast_conf_member *member = cf->member;
+
+	// always mix spyers, spyees and members whose energy is unknown
+	if (member->spy_partner || member->speech_energy < 0)
+		return INT_MAX;
+
+	// favour the speakers mixed on the previous tick
+	return member->tick->is_mixed ? member->speech_energy + member->speech_energy * AST_CONF_SPEAKER_HYSTERESIS / 100 : member->speech_energy;
+}
+
+static void select_speakers(ast_conference *conf, conf_frame **spoken_frames, int *listener_count, int *speaker_count)
+{
+	conf_frame *selected = NULL, *cf, *loudest;
+	int count;
+
+	// move the loudest frames to the selected list
+	for (count = 0; count < conf->max_speakers && *spoken_frames; ++count)
+	{
+		for (loudest = cf = *spoken_frames; (cf = cf->next); )
+		{
+			if (speaker_rank(cf) > speaker_rank(loudest))
+				loudest = cf;
+		}
+
+		if (loudest->prev)
+			loudest->prev->next = loudest->next;
+		else
+			*spoken_frames = loudest->next;
+		if (loudest->next)
+			loudest->next->prev = loudest->prev;
+
+		loudest->prev = NULL;
+		if ((loudest->next = selected))
+			selected->prev = loudest;
+		selected = loudest;
+
+		loudest->member->tick->is_mixed = 1;
+	}
+
+	// the remaining speakers are listeners this tick
+	for (cf = *spoken_frames; cf; )
+	{
+		cf->member->tick->is_speaking = 0;
+		cf->member->tick->is_mixed = 0;
+
+		(*speaker_count)--;
+		(*listener_count)++;
+
+		cf = delete_conf_frame(cf);
+	}
+
+	*spoken_frames = selected;
+}
+
+//
+// listener frame encode stage
+//
+
+// convert the listener frame to a write format
+static void encode_listener_format(ast_conference *conf, int index)
+{
+	conf_frame *frame = conf->listener_frame;
+	struct timeval start = ast_tvnow();
+	ast_conf_sharedframe *sf;
+
+	if ((sf = encode_frame(index, conf->from_slinear_paths[index], frame->fr, conf->delivery_time)))
+	{
+		// (the frame will be free'd next time through the loop)
+		if (frame->converted[index] && conf->from_slinear_paths[index])
+			ast_frfree(frame->converted[index]);
+		frame->converted[index] = &sf->fr;
+		frame->shared[index] = sf;
+	}
+
+	// update the format's encode cost (microseconds per tick, smoothed)
+	struct timeval encode_time = ast_tvsub(ast_tvnow(), start);
+	conf->encode_cost[index] += (int)(encode_time.tv_sec * 1000000 + encode_time.tv_usec - conf->encode_cost[index]) / 8;
+}
+
+#if	AST_CONF_ENCODE_THREADS
+// take the next format of a batch, with encode_lock held
+static int take_batch_format(encode_batch *batch)
+{
+	int index = batch->formats[batch->next++];
+
+	// all taken, remove the batch from the queue
+	if (batch->next == batch->count)
+	{
+		encode_batch *prev = NULL, *b;
+
+		for (b = encode_queue; b != batch; b = b->next_batch)
+			prev = b;
+
+		if (prev)
+			prev->next_batch = batch->next_batch;
+		else
+			encode_queue = batch->next_batch;
+
+		if (encode_queue_last == batch)
+			encode_queue_last = prev;
+	}
+
+	return index;
+}
+
+static void *encoder_thread(void *data)
+{
+	ast_mutex_lock(&encode_lock);
+
+	while (!encoders_stopping)
+	{
+		encode_batch *batch = encode_queue;
+
+		if (!batch)
+		{
+			ast_cond_wait(&encode_work, &encode_lock);
+			continue;
+		}
+
+		int index = take_batch_format(batch);
+
+		ast_mutex_unlock(&encode_lock);
+
+		encode_listener_format(batch->conf, index);
+
+		ast_mutex_lock(&encode_lock);
+
+		if (!--batch->pending)
+			ast_cond_signal(&batch->done);
+	}
+
+	ast_mutex_unlock(&encode_lock);
+
+	// return this thread's frame magazines
+	slab_thread_cleanup();
+
+	return NULL;
+}
+
+static void start_encoders(void)
+{
+	ast_cond_init(&encode_work, NULL);
+
+	for (encoder_count = 0; encoder_count < AST_CONF_ENCODE_THREADS; ++encoder_count)
+	{
+		if (ast_pthread_create(&encoders[encoder_count], NULL, encoder_thread, NULL))
+		{
+			ast_log(LOG_WARNING, "unable to start encoder thread %d\n", encoder_count);
+			break;
+		}
+	}
+}
+
+static void stop_encoders(void)
+{
+	int i;
+
+	ast_mutex_lock(&encode_lock);
+	encoders_stopping = 1;
+	ast_cond_broadcast(&encode_work);
+	ast_mutex_unlock(&encode_lock);
+
+	for (i = 0; i < encoder_count; ++i)
+		pthread_join(encoders[i], NULL);
+
+	ast_cond_destroy(&encode_work);
+}
+#endif
+
+// encode the listener frame to the write formats of the conference before the
+// members are sent it. g.711 and the conference format are converted here, the
+// formats that need a translator in parallel on the encoder threads
+static void encode_listener_frame(ast_conference *conf)
+{
+	conf_frame *frame = conf->listener_frame;
+	int index;
+#if	AST_CONF_ENCODE_THREADS
+	encode_batch batch = { .conf = conf };
+#endif
+
+	for (index = 0; index < AC_SUPPORTED_FORMATS; ++index)
+	{
+		// formats without members and the speaker's own format
+		if (!conf->write_formats[index] || (frame->converted[index] && !frame->talk_volume))
+			continue;
+
+#if	AST_CONF_ENCODE_THREADS
+#ifndef	AC_USE_G722
+		if (index != AC_CONF_INDEX && index != AC_ULAW_INDEX && index != AC_ALAW_INDEX)
+#else
+		if (index != AC_CONF_INDEX)
+#endif
+		{
+			batch.formats[batch.count++] = index;
+			continue;
+		}
+#endif
+		encode_listener_format(conf, index);
+	}
+
+#if	AST_CONF_ENCODE_THREADS
+	if (batch.count > 1 && encoder_count)
+	{
+		// queue all but the last format for the encoders
+		batch.pending = --batch.count;
+		ast_cond_init(&batch.done, NULL);
+
+		ast_mutex_lock(&encode_lock);
+		if (encode_queue_last)
+			encode_queue_last->next_batch = &batch;
+		else
+			encode_queue = &batch;
+		encode_queue_last = &batch;
+		ast_cond_broadcast(&encode_work);
+		ast_mutex_unlock(&encode_lock);
+
+		// encode the last format meanwhile
+		encode_listener_format(conf, batch.formats[batch.count]);
+
+		// help with formats no encoder has taken yet and wait for the others
+		ast_mutex_lock(&encode_lock);
+		while (batch.next < batch.count)
+		{
+			index = take_batch_format(&batch);
+
+			ast_mutex_unlock(&encode_lock);
+			encode_listener_format(conf, index);
+			ast_mutex_lock(&encode_lock);
+
+			--batch.pending;
+		}
+		while (batch.pending)
+			ast_cond_wait(&batch.done, &encode_lock);
+		ast_mutex_unlock(&encode_lock);
+
+		ast_cond_destroy(&batch.done);
+	}
+	else if (batch.count)
+	{
+		encode_listener_format(conf, batch.formats[0]);
+	}
+#endif
+
+	// the converted frames now carry the talk volume
+	frame->talk_volume = 0;
+}
+
+//
+// process one tick of conference frames
+//
+
+static void process_conference(ast_conference *conf)
+{
+	// conference tick array index
+	int index;
+
+	// reset speaker and listener count
+	int speaker_count = 0;
+	int listener_count = 0;
+
+	// reset pointer lists
+	conf_frame *spoken_frames = NULL;
+
+	// loop over tick array and retrieve incoming frames
+	for (index = 0; index < conf->membercount; ++index)
+	{
+		// prefetch the incoming queue of a member further down the array
+		if (index + AST_CONF_TICK_PREFETCH < conf->membercount)
+			__builtin_prefetch(&conf->ticklist[index + AST_CONF_TICK_PREFETCH].member->incomingq.tail);
+
+		member_process_spoken_frames(conf,&conf->ticklist[index],&spoken_frames,
+					     &listener_count, &speaker_count);
+	}
+
+#if	SILDET == 1
+	// decide on the frames still waiting for the vad
+	member_process_vad_batch(conf, &spoken_frames, &listener_count, &speaker_count);
+#endif
+
+	// limit the number of mixed speakers
+	if (conf->max_speakers && speaker_count > conf->max_speakers)
+	{
+		select_speakers(conf, &spoken_frames, &listener_count, &speaker_count);
+	}
+
+	// mix incoming frames and get batch of outgoing frames
+	conf_frame *send_frames = spoken_frames ? mix_frames(conf, spoken_frames, speaker_count, listener_count) : NULL;
+
+	// overlay the sounds playing in the conference
+	if (conf->playbacks)
+	{
+		send_frames = mix_sounds(conf, send_frames);
+	}
+
+	// convert the listener frame to the members' write formats
+	if (conf->listener_frame)
+	{
+		encode_listener_frame(conf);
+	}
+
+	// loop over tick array and send outgoing frames
+	for (index = 0; index < conf->membercount; ++index)
+	{
+		// prefetch the per tick fields of a member further down the array
+		if (index + AST_CONF_TICK_PREFETCH < conf->membercount)
+			__builtin_prefetch(conf->ticklist[index + AST_CONF_TICK_PREFETCH].member);
+
+		member_process_outgoing_frames(conf, &conf->ticklist[index]);
+	}
+
+	// delete send frames
+	while (send_frames)
+	{
+		if (send_frames->member)
+			send_frames->member->tick->speaker_frame = NULL; // reset speaker frame
+		else
+			conf->listener_frame = NULL; // reset listener frame
+
+		send_frames = delete_conf_frame(send_frames);
+	}
+
+	conf->lone_speaker = NULL;
+
+	// release shared silent frames
+	int c;
+	for (c = 0; c < AC_SUPPORTED_FORMATS; ++c)
+	{
+		if (conf->silent_frames[c])
+		{
+			release_shared_frame(&conf->silent_frames[c]->fr);
+			conf->silent_frames[c] = NULL;
+		}
+	}
+}
 
 //
 // main conference function
 //
 
-static void conference_exec()
+static void conference_exec(ast_conf_mixer *mixer)
 {
 	// thread frequency variable
 	int tf_count = 0;
@@ -108,6 +538,14 @@ static void conference_exec()
 	// set base timestamps
 	base = tf_base = ast_tvnow();
 
+#if	AST_CONF_DEDICATED_MIXER_COST
+	// a mixer started for a moved conference ticks in phase with it
+	ast_mutex_lock(&conflist_lock);
+	if (mixer->conflist && !ast_tvzero(mixer->conflist->delivery_time))
+		base = mixer->conflist->delivery_time;
+	ast_mutex_unlock(&conflist_lock);
+#endif
+
 	// current conference
 	ast_conference *conf = NULL;
 	// last conference list
@@ -123,7 +561,7 @@ static void conference_exec()
 		uint64_t expirations;
 
 		// wait for start of epoch
-		if (read(timerfd, &expirations, sizeof(expirations)) == -1)
+		if (read(mixer->timerfd, &expirations, sizeof(expirations)) == -1)
 		{
 			ast_log(LOG_ERROR, "unable to read timer!? %s\n", strerror(errno));
 		}
@@ -143,22 +581,22 @@ static void conference_exec()
 		{
 #elif	KQUEUE
 		// wait for start of epoch
-		if (kevent(kqueuefd, &inqueue, 1, &outqueue, 1, NULL) == -1)
+		if (kevent(mixer->kqueuefd, &mixer->inqueue, 1, &mixer->outqueue, 1, NULL) == -1)
 		{
 			ast_log(LOG_NOTICE, "unable to read timer!? %s\n", strerror(errno));
 		}
 #ifdef	KQUEUE_EXPIRATIONS
 		// check expirations
-		if (outqueue.data != 1) 
+		if (mixer->outqueue.data != 1) 
 		{
-			ast_log(LOG_NOTICE, "kqueue expirations = %ld!?\n", outqueue.data);
+			ast_log(LOG_NOTICE, "kqueue expirations = %ld!?\n", mixer->outqueue.data);
 		}
 #endif
 		// update expirations
-		tf_expirations += outqueue.data;
-		if (outqueue.data > tf_max_expirations) tf_max_expirations = outqueue.data;
+		tf_expirations += mixer->outqueue.data;
+		if (mixer->outqueue.data > tf_max_expirations) tf_max_expirations = mixer->outqueue.data;
 		// process expirations
-		for (; outqueue.data; outqueue.data--)
+		for (; mixer->outqueue.data; mixer->outqueue.data--)
 		{
 #else
 		// update the current timestamp
@@ -196,9 +634,9 @@ static void conference_exec()
 				|| (tf_frequency >= (float)(AST_CONF_FRAME_INTERVAL + 1)))
 			{
 #if	defined(TIMERFD) || defined(KQUEUE)
-				ast_log(LOG_WARNING, "processed frame frequency variation, tf_count => %d, tf_diff => %ld, tf_frequency => %2.4f, tf_expirations = %d tf_max_expirations = %d\n", tf_count, tf_diff, tf_frequency, tf_expirations, tf_max_expirations);
+				ast_log(LOG_WARNING, "processed frame frequency variation, mixer => %d, tf_count => %d, tf_diff => %ld, tf_frequency => %2.4f, tf_expirations = %d tf_max_expirations = %d\n", mixer->index, tf_count, tf_diff, tf_frequency, tf_expirations, tf_max_expirations);
 #else
-				ast_log(LOG_WARNING, "processed frame frequency variation, tf_count => %d, tf_diff => %ld, tf_frequency => %2.4f\n", tf_count, tf_diff, tf_frequency);
+				ast_log(LOG_WARNING, "processed frame frequency variation, mixer => %d, tf_count => %d, tf_diff => %ld, tf_frequency => %2.4f\n", mixer->index, tf_count, tf_diff, tf_frequency);
 #endif
 			}
 
@@ -218,10 +656,11 @@ static void conference_exec()
 		// increment the timer base (it will be used later to timestamp outgoing frames)
 		base = ast_tvadd(base, epoch);
 
-		// get the first entry
-		if (!ast_mutex_trylock(&conflist_lock))
+		// get the first entry (waiting for the lock if a conference was moved here)
+		if (mixer->pending ? !ast_mutex_lock(&conflist_lock) : !ast_mutex_trylock(&conflist_lock))
 		{
-			conf = lastconflist = conflist;
+			conf = lastconflist = mixer->conflist;
+			mixer->pending = 0;
 			ast_mutex_unlock(&conflist_lock);
 		}
 		else
@@ -246,32 +685,20 @@ static void conference_exec()
 					ast_rwlock_unlock(&conf->lock);
 
 					// get the next conference
-					conf = conf->next;
+					conf = conf->mixer_next;
 
 					continue;
 				}
 
 				conf = remove_conf(conf);
 
-				if (conf == conflist)
-				{
-					// update last conference list
-					lastconflist = conf;
-				}
+				// update last conference list
+				lastconflist = mixer->conflist;
 
-				if (!conference_count)
+				if (!mixer->conference_count)
 				{
-					// release the conference list lock
-					ast_mutex_unlock(&conflist_lock);
-#ifdef	TIMERFD
-					// close timer file
-					close(timerfd);
-#elif	KQUEUE
-					// close kqueue file
-					close(kqueuefd);
-#endif
 					// exit the conference thread
-					pthread_exit(NULL);
+					stop_mixer(mixer);
 				}
 
 				// release the conference list lock
@@ -280,55 +707,77 @@ static void conference_exec()
 				continue; // next conference
 			}
 
+			//
+			// a conference moved from another mixer is skipped until
+			// half an epoch has passed since it was last processed, so
+			// the move neither drops nor duplicates a frame
+			//
+
+			if (ast_tvdiff_ms(base, conf->delivery_time) < AST_CONF_FRAME_INTERVAL / 2)
+			{
+				ast_rwlock_unlock(&conf->lock);
+
+				// get the next conference
+				conf = conf->mixer_next;
+
+				continue;
+			}
+
 			//
 			// process conference frames
 			//
 
-			// conference member
-			ast_conf_member *member;
+			// mix start timestamp
+			struct timeval mix_start = ast_tvnow();
 
 			// update the current delivery time
 			conf->delivery_time = base;
 
-			// reset speaker and listener count
-			int speaker_count = 0;
-			int listener_count = 0;
+			process_conference(conf);
 
-			// reset pointer lists
-			conf_frame *spoken_frames = NULL;
+			// update the conference mix cost (microseconds per tick, smoothed)
+			struct timeval mix_time = ast_tvsub(ast_tvnow(), mix_start);
+			conf->mix_cost += (int)(mix_time.tv_sec * 1000000 + mix_time.tv_usec - conf->mix_cost) / 8;
 
-			// loop over member list and retrieve incoming frames
-			for (member = conf->memberlist; member; member = member->next)
-			{
-				member_process_spoken_frames(conf,member,&spoken_frames,
-							     &listener_count, &speaker_count);
-			}
+			// release conference lock
+			ast_rwlock_unlock(&conf->lock);
 
-			// mix incoming frames and get batch of outgoing frames
-			conf_frame *send_frames = spoken_frames ? mix_frames(conf, spoken_frames, speaker_count, listener_count) : NULL;
+			// get the next conference before this one is moved
+			ast_conference *next = conf->mixer_next;
 
-			// loop over member list and send outgoing frames
-			for (member = conf->memberlist; member; member = member->next)
-			{
-				member_process_outgoing_frames(conf, member);
-			}
+			//
+			// move an oversized conference to a dedicated mixer
+			// and move it back to a shared mixer when it shrinks
+			//
 
-			// delete send frames
-			while (send_frames)
+#if	AST_CONF_DEDICATED_MIXER_COST
+			if (!mixer->dedicated ? conf->mix_cost > AST_CONF_DEDICATED_MIXER_COST && mixer->conference_count > 1
+				: conf->mix_cost < AST_CONF_SHARED_MIXER_COST)
 			{
-				if (send_frames->member)
-					send_frames->member->speaker_frame = NULL; // reset speaker frame
-				else
-					conf->listener_frame = NULL; // reset listener frame
+				if (!ast_mutex_trylock(&conflist_lock))
+				{
+					if (!move_conf(conf, !mixer->dedicated ? NULL : select_mixer()))
+					{
+						ast_log(LOG_NOTICE, "conference %s moved to %s mixer, mix cost => %d us\n",
+							conf->name, !mixer->dedicated ? "a dedicated" : "a shared", conf->mix_cost);
 
-				send_frames = delete_conf_frame(send_frames);
-			}
+						// update last conference list
+						lastconflist = mixer->conflist;
 
-			// release conference lock
-			ast_rwlock_unlock(&conf->lock);
+						if (!mixer->conference_count)
+						{
+							// exit the conference thread
+							stop_mixer(mixer);
+						}
+					}
 
+					// release the conference list lock
+					ast_mutex_unlock(&conflist_lock);
+				}
+			}
+#endif
 			// get the next conference
-			conf = conf->next;
+			conf = next;
 		}
 #if	defined(TIMERFD) || defined(KQUEUE)
 		}
@@ -336,6 +785,174 @@ static void conference_exec()
 	}
 }
 
+//
+// mixer thread functions
+//
+
+// This function should be called with conflist_lock held
+static ast_conf_mixer *select_mixer(void)
+{
+	ast_conf_mixer *mixer = &mixers[0];
+	int i;
+
+	// pick the shared mixer with the smallest slice
+	for (i = 1; i < AST_CONF_MIXER_THREADS; ++i)
+	{
+		if (mixers[i].conference_count < mixer->conference_count)
+			mixer = &mixers[i];
+	}
+
+	return mixer;
+}
+
+// This function should be called with conflist_lock held
+static int start_mixer(ast_conf_mixer *mixer)
+{
+#ifdef	TIMERFD
+	// create timer
+	if ((mixer->timerfd = timerfd_create(CLOCK_MONOTONIC,TFD_CLOEXEC)) == -1)
+	{
+		ast_log(LOG_ERROR, "unable to create timer!? %s\n", strerror(errno));
+		return -1;
+	}
+
+	// set interval to epoch
+	struct itimerspec timerspec = { .it_interval.tv_sec = 0,
+					.it_interval.tv_nsec = AST_CONF_FRAME_INTERVAL * 1000000,
+					.it_value.tv_sec = 0,
+					.it_value.tv_nsec = 1 };
+
+	// set timer
+	if (timerfd_settime(mixer->timerfd, 0, &timerspec, 0) == -1)
+	{
+		ast_log(LOG_NOTICE, "unable to set timer!? %s\n", strerror(errno));
+
+		close(mixer->timerfd);
+		return -1;
+	}
+#elif	KQUEUE
+	// create timer
+	if ((mixer->kqueuefd = kqueue()) == -1)
+	{
+		ast_log(LOG_ERROR, "unable to create timer!? %s\n", strerror(errno));
+		return -1;
+	}
+
+	// set interval to epoch
+	EV_SET(&mixer->inqueue, 1, EVFILT_TIMER, EV_ADD | EV_ENABLE, 0, AST_CONF_FRAME_INTERVAL, 0);
+#endif
+
+	pthread_t conference_thread; // conference thread id
+	if (ast_pthread_create(&conference_thread, NULL, (void*)conference_exec, mixer))
+	{
+		ast_log(LOG_ERROR, "unable to start conference thread for mixer %d\n", mixer->index);
+#ifdef	TIMERFD
+		close(mixer->timerfd);
+#elif	KQUEUE
+		close(mixer->kqueuefd);
+#endif
+		return -1;
+	}
+
+	// detach the thread so it doesn't leak
+	pthread_detach(conference_thread);
+
+	// if realtime set fifo scheduling and bump priority
+	if (ast_opt_high_priority)
+	{
+		int policy;
+		struct sched_param param;
+
+		pthread_getschedparam(conference_thread, &policy, &param);
+		
+		++param.sched_priority;
+		policy = SCHED_FIFO;
+		pthread_setschedparam(conference_thread, policy, &param);
+	}
+
+	return 0;
+}
+
+// This function should be called with conflist_lock held by the mixer thread
+static void stop_mixer(ast_conf_mixer *mixer)
+{
+#ifdef	TIMERFD
+	// close timer file
+	close(mixer->timerfd);
+#elif	KQUEUE
+	// close kqueue file
+	close(mixer->kqueuefd);
+#endif
+	// release the conference list lock
+	ast_mutex_unlock(&conflist_lock);
+
+	// free a dedicated mixer
+	if (mixer->dedicated)
+		ast_free(mixer);
+
+	// return this thread's frame magazines
+	slab_thread_cleanup();
+
+	// exit the conference thread
+	pthread_exit(NULL);
+}
+
+#if	AST_CONF_DEDICATED_MIXER_COST
+// This function should be called with conflist_lock held by the conference's mixer thread
+// (a null mixer moves the conference to a new dedicated mixer)
+static int move_conf(ast_conference *conf, ast_conf_mixer *mixer)
+{
+	ast_conf_mixer *from = conf->mixer;
+
+	if (!mixer)
+	{
+		// allocate a dedicated mixer
+		if (!(mixer = ast_calloc(1, sizeof(ast_conf_mixer))))
+		{
+			ast_log(LOG_ERROR, "unable to malloc ast_conf_mixer\n");
+			return -1;
+		}
+		mixer->index = -1;
+		mixer->dedicated = 1;
+	}
+
+	// tell the mixer thread to pick up the conference on its next tick
+	mixer->pending = 1;
+
+	// spawn the mixer thread if its slice is empty
+	if (!mixer->conflist && start_mixer(mixer))
+	{
+		mixer->pending = 0;
+		if (mixer->dedicated)
+			ast_free(mixer);
+		return -1;
+	}
+
+	// remove the conference from its mixer slice
+	if (conf->mixer_prev)
+		conf->mixer_prev->mixer_next = conf->mixer_next;
+
+	if (conf->mixer_next)
+		conf->mixer_next->mixer_prev = conf->mixer_prev;
+
+	if (conf == from->conflist)
+		from->conflist = conf->mixer_next;
+
+	--from->conference_count;
+
+	// prepend the conference to the new mixer slice
+	conf->mixer_prev = NULL;
+	if (mixer->conflist)
+		mixer->conflist->mixer_prev = conf;
+	conf->mixer_next = mixer->conflist;
+	mixer->conflist = conf;
+	conf->mixer = mixer;
+	++mixer->conference_count;
+
+	return 0;
+}
+#endif
+
 //
 // manange conference functions
 //
@@ -352,6 +969,39 @@ int init_conference(void)
 	for (i = 0; i < CONFERENCE_TABLE_SIZE; i++)
 		AST_LIST_HEAD_INIT (&conference_table[i]);
 
+	//init mixers
+	for (i = 0; i < AST_CONF_MIXER_THREADS; i++)
+		mixers[i].index = i;
+
+	//select mix kernels
+	init_mix_kernels();
+
+	//init frame slabs
+	if (init_slabs())
+		return -1;
+
+	//init translator paths
+	if (init_trans_paths())
+		return -1;
+
+	//decode the join and leave sounds
+	if (init_sounds())
+		return -1;
+
+	//init music on hold
+	if (init_moh())
+		return -1;
+
+#if	AST_CONF_ENCODE_THREADS
+	//start listener frame encoders
+	start_encoders();
+#endif
+
+#if	AST_CONF_SOUND_READERS
+	//start member sound readers
+	start_sound_readers();
+#endif
+
 	//set delimiter
 	argument_delimiter = !strcmp(PACKAGE_VERSION,"1.4") ? "|" : ",";
 
@@ -417,18 +1067,34 @@ void dealloc_conference(void)
 		ast_free(mbrblock);
 	}
 #endif
-	//free silent frames
-	for (i = 1; i < AC_SUPPORTED_FORMATS; ++i)
-		if (silent_conf_frame->converted[i]) ast_frfree(silent_conf_frame->converted[i]);
+#if	AST_CONF_ENCODE_THREADS
+	//stop listener frame encoders
+	stop_encoders();
+#endif
+
+#if	AST_CONF_SOUND_READERS
+	//stop member sound readers
+	stop_sound_readers();
+#endif
 
-#ifdef	CACHE_CONF_FRAMES
-	//free conf frames
-	conf_frame *cfr;
-	while ((cfr = AST_LIST_REMOVE_HEAD(&confFrameList, frame_list)))
+	//free silent frames ( the silent conf frame is static, so forget them for a reload )
+	for (i = 1; i < AC_SUPPORTED_FORMATS; ++i)
 	{
-		ast_free(cfr);
+		if (silent_conf_frame->converted[i]) ast_frfree(silent_conf_frame->converted[i]);
+		silent_conf_frame->converted[i] = NULL;
 	}
-#endif
+
+	//free music on hold
+	dealloc_moh();
+
+	//free sounds
+	dealloc_sounds();
+
+	//free translator paths
+	dealloc_trans_paths();
+
+	//free frame slabs
+	dealloc_slabs();
 
 #if	defined(SPEAKER_SCOREBOARD) && defined(CACHE_CONTROL_BLOCKS)
 	if (speaker_scoreboard)
@@ -468,7 +1134,10 @@ ast_conference* join_conference(ast_conf_member* member, char* conf_name, char*
 		// is responsible for calling delete_member()
 		//
 		if (!member->max_users || (member->max_users > conf->membercount)) {
-			add_member(member, conf);
+			if (add_member(member, conf)) {
+				ast_log(LOG_ERROR, "unable to add member to conference %s\n", conf->name);
+				conf = NULL;
+			}
 		} else {
 			pbx_builtin_setvar_helper(member->chan, "KONFERENCE", "MAXUSERS");
 			*max_users_flag = 1;
@@ -536,6 +1205,15 @@ static ast_conference* create_conf(char* name, ast_conf_member* member)
 	}
 #endif
 
+	// allocate the tick array
+	if (!(conf->ticklist = ast_malloc(AST_CONF_TICK_BLOCK * sizeof(ast_conf_tick))))
+	{
+		ast_log(LOG_ERROR, "unable to malloc conference tick array\n");
+		ast_free(conf);
+		return NULL;
+	}
+	conf->tickcapacity = AST_CONF_TICK_BLOCK;
+
 	//
 	// initialize conference
 	//
@@ -546,6 +1224,9 @@ static ast_conference* create_conf(char* name, ast_conf_member* member)
 	// copy name to conference
 	strncpy((char*)&(conf->name), name, sizeof(conf->name) - 1);
 
+	// speaker limit requested by the first member
+	conf->max_speakers = member->max_speakers;
+
 	// initialize the conference lock
 	ast_rwlock_init(&conf->lock);
 
@@ -561,117 +1242,55 @@ static ast_conference* create_conf(char* name, ast_conf_member* member)
 	// build translation paths
 	conf->from_slinear_paths[AC_CONF_INDEX] = NULL;
 #if	ASTERISK_SRC_VERSION < 1000
-	conf->from_slinear_paths[AC_ULAW_INDEX] = ast_translator_build_path(AST_FORMAT_ULAW, AST_FORMAT_CONFERENCE);
-	conf->from_slinear_paths[AC_ALAW_INDEX] = ast_translator_build_path(AST_FORMAT_ALAW, AST_FORMAT_CONFERENCE);
-	conf->from_slinear_paths[AC_GSM_INDEX] = ast_translator_build_path(AST_FORMAT_GSM, AST_FORMAT_CONFERENCE);
+	conf->from_slinear_paths[AC_ULAW_INDEX] = trans_build_path(AST_FORMAT_ULAW, AST_FORMAT_CONFERENCE);
+	conf->from_slinear_paths[AC_ALAW_INDEX] = trans_build_path(AST_FORMAT_ALAW, AST_FORMAT_CONFERENCE);
+	conf->from_slinear_paths[AC_GSM_INDEX] = trans_build_path(AST_FORMAT_GSM, AST_FORMAT_CONFERENCE);
 #else
-	conf->from_slinear_paths[AC_ULAW_INDEX] = ast_translator_build_path(&ast_format_ulaw, &ast_format_conference);
-	conf->from_slinear_paths[AC_ALAW_INDEX] = ast_translator_build_path(&ast_format_alaw, &ast_format_conference);
-	conf->from_slinear_paths[AC_GSM_INDEX] = ast_translator_build_path(&ast_format_gsm, &ast_format_conference);
+	conf->from_slinear_paths[AC_ULAW_INDEX] = trans_build_path(&ast_format_ulaw, &ast_format_conference);
+	conf->from_slinear_paths[AC_ALAW_INDEX] = trans_build_path(&ast_format_alaw, &ast_format_conference);
+	conf->from_slinear_paths[AC_GSM_INDEX] = trans_build_path(&ast_format_gsm, &ast_format_conference);
 #endif
 #ifdef	AC_USE_SPEEX
 #if	ASTERISK_SRC_VERSION < 1000
-	conf->from_slinear_paths[AC_SPEEX_INDEX] = ast_translator_build_path(AST_FORMAT_SPEEX, AST_FORMAT_CONFERENCE);
+	conf->from_slinear_paths[AC_SPEEX_INDEX] = trans_build_path(AST_FORMAT_SPEEX, AST_FORMAT_CONFERENCE);
 #else
-	conf->from_slinear_paths[AC_SPEEX_INDEX] = ast_translator_build_path(&ast_format_speex, &ast_format_conference);
+	conf->from_slinear_paths[AC_SPEEX_INDEX] = trans_build_path(&ast_format_speex, &ast_format_conference);
 #endif
 #endif
 #ifdef AC_USE_G729A
 #if	ASTERISK_SRC_VERSION < 1000
-	conf->from_slinear_paths[AC_G729A_INDEX] = ast_translator_build_path(AST_FORMAT_G729A, AST_FORMAT_CONFERENCE);
+	conf->from_slinear_paths[AC_G729A_INDEX] = trans_build_path(AST_FORMAT_G729A, AST_FORMAT_CONFERENCE);
 #else
-	conf->from_slinear_paths[AC_G729A_INDEX] = ast_translator_build_path(&ast_format_g729a, &ast_format_conference);
-#endif
-#endif
-#ifdef AC_USE_G722
-#if	ASTERISK_SRC_VERSION < 1000
-	conf->from_slinear_paths[AC_SLINEAR_INDEX] = ast_translator_build_path(AST_FORMAT_SLINEAR, AST_FORMAT_CONFERENCE);
-	conf->from_slinear_paths[AC_G722_INDEX] = ast_translator_build_path(AST_FORMAT_G722, AST_FORMAT_CONFERENCE);
-#else
-	conf->from_slinear_paths[AC_SLINEAR_INDEX] = ast_translator_build_path(&ast_format_slinear, &ast_format_conference);
-	conf->from_slinear_paths[AC_G722_INDEX] = ast_translator_build_path(&ast_format_g722, &ast_format_conference);
-#endif
-#endif
-
-	//
-	// spawn thread for new conference, using conference_exec(conf)
-	//
-	if (!conflist)
-	{
-
-#ifdef	TIMERFD
-		// create timer
-		if ((timerfd = timerfd_create(CLOCK_MONOTONIC,TFD_CLOEXEC)) == -1)
-		{
-			ast_log(LOG_ERROR, "unable to create timer!? %s\n", strerror(errno));
-
-			// clean up conference
-			ast_free(conf);
-			return NULL;
-		}
-
-		// set interval to epoch
-		struct itimerspec timerspec = { .it_interval.tv_sec = 0,
-						.it_interval.tv_nsec = AST_CONF_FRAME_INTERVAL * 1000000,
-						.it_value.tv_sec = 0,
-						.it_value.tv_nsec = 1 };
-
-		// set timer
-		if (timerfd_settime(timerfd, 0, &timerspec, 0) == -1)
-		{
-			ast_log(LOG_NOTICE, "unable to set timer!? %s\n", strerror(errno));
-
-			close(timerfd);
-
-			// clean up conference
-			ast_free(conf);
-			return NULL;
-		}
-#elif	KQUEUE
-		// create timer
-		if ((kqueuefd = kqueue()) == -1)
-		{
-			ast_log(LOG_ERROR, "unable to create timer!? %s\n", strerror(errno));
-
-			// clean up conference
-			ast_free(conf);
-			return NULL;
-		}
-
-		// set interval to epoch
-		EV_SET(&inqueue, 1, EVFILT_TIMER, EV_ADD | EV_ENABLE, 0, AST_CONF_FRAME_INTERVAL, 0);
+	conf->from_slinear_paths[AC_G729A_INDEX] = trans_build_path(&ast_format_g729a, &ast_format_conference);
+#endif
+#endif
+#ifdef AC_USE_G722
+#if	ASTERISK_SRC_VERSION < 1000
+	conf->from_slinear_paths[AC_SLINEAR_INDEX] = trans_build_path(AST_FORMAT_SLINEAR, AST_FORMAT_CONFERENCE);
+	conf->from_slinear_paths[AC_G722_INDEX] = trans_build_path(AST_FORMAT_G722, AST_FORMAT_CONFERENCE);
+#else
+	conf->from_slinear_paths[AC_SLINEAR_INDEX] = trans_build_path(&ast_format_slinear, &ast_format_conference);
+	conf->from_slinear_paths[AC_G722_INDEX] = trans_build_path(&ast_format_g722, &ast_format_conference);
+#endif
 #endif
 
-		pthread_t conference_thread; // conference thread id
-		if (!(ast_pthread_create(&conference_thread, NULL, (void*)conference_exec, NULL)))
-		{
-			// detach the thread so it doesn't leak
-			pthread_detach(conference_thread);
+	//
+	// assign the new conference to a mixer, spawning
+	// the mixer thread if its slice is empty
+	//
+	ast_conf_mixer *mixer = select_mixer();
 
-			// if realtime set fifo scheduling and bump priority
-			if (ast_opt_high_priority)
-			{
-				int policy;
-				struct sched_param param;
-
-				pthread_getschedparam(conference_thread, &policy, &param);
-				
-				++param.sched_priority;
-				policy = SCHED_FIFO;
-				pthread_setschedparam(conference_thread, policy, &param);
-			}
-		}
-		else
-		{
-			ast_log(LOG_ERROR, "unable to start conference thread for conference %s\n", conf->name);
+	if (!mixer->conflist && start_mixer(mixer))
+	{
+		ast_log(LOG_ERROR, "unable to start conference thread for conference %s\n", conf->name);
 
-			// clean up conference
-			ast_free(conf);
-			return NULL;
-		}
+		// clean up conference
+		ast_free(conf->ticklist);
+		ast_free(conf);
+		return NULL;
 	}
 
-	// add the initial member
+	// add the initial member (the tick array has room for it)
 	add_member(member, conf);
 
 	// prepend new conference to conflist
@@ -680,6 +1299,14 @@ static ast_conference* create_conf(char* name, ast_conf_member* member)
 	conf->next = conflist;
 	conflist = conf;
 
+	// prepend new conference to the mixer slice
+	if (mixer->conflist)
+		mixer->conflist->mixer_prev = conf;
+	conf->mixer_next = mixer->conflist;
+	mixer->conflist = conf;
+	conf->mixer = mixer;
+	++mixer->conference_count;
+
 	// add member to channel table
 	conf->bucket = &(conference_table[hash(conf->name) % CONFERENCE_TABLE_SIZE]);
 
@@ -698,6 +1325,7 @@ ast_conference *remove_conf(ast_conference *conf)
 {
 
 	ast_conference *conf_temp;
+	ast_conf_mixer *mixer = conf->mixer;
 
 	//
 	// do some frame clean up
@@ -709,10 +1337,13 @@ ast_conference *remove_conf(ast_conference *conf)
 		// free the translation paths
 		if (conf->from_slinear_paths[c])
 		{
-			ast_translator_free_path(conf->from_slinear_paths[c]);
+			trans_free_path(conf->from_slinear_paths[c]);
 		}
 	}
 
+	// stop the sounds
+	stop_sounds(&conf->playbacks);
+
 	// speaker frames
 	if (conf->mixAstFrame)
 	{
@@ -723,6 +1354,9 @@ ast_conference *remove_conf(ast_conference *conf)
 		ast_free(conf->mixConfFrame);
 	}
 
+	// tick array
+	ast_free(conf->ticklist);
+
 	AST_LIST_LOCK(conf->bucket);
 	AST_LIST_REMOVE(conf->bucket, conf, hash_entry);
 	AST_LIST_UNLOCK(conf->bucket);
@@ -731,8 +1365,6 @@ ast_conference *remove_conf(ast_conference *conf)
 	ast_rwlock_unlock(&conf->lock);
 	ast_rwlock_destroy(&conf->lock);
 
-	conf_temp = conf->next;
-
 	if (conf->prev)
 		conf->prev->next = conf->next;
 
@@ -740,7 +1372,21 @@ ast_conference *remove_conf(ast_conference *conf)
 		conf->next->prev = conf->prev;
 
 	if (conf == conflist)
-		conflist = conf_temp;
+		conflist = conf->next;
+
+	// remove the conference from the mixer slice
+	conf_temp = conf->mixer_next;
+
+	if (conf->mixer_prev)
+		conf->mixer_prev->mixer_next = conf->mixer_next;
+
+	if (conf->mixer_next)
+		conf->mixer_next->mixer_prev = conf->mixer_prev;
+
+	if (conf == mixer->conflist)
+		mixer->conflist = conf_temp;
+
+	--mixer->conference_count;
 #ifdef	CACHE_CONTROL_BLOCKS
 	// put the conference control block on the free list
 	conf->next = confblocklist;
@@ -794,12 +1440,35 @@ void end_conference(const char *name)
 //
 
 // This function should be called with conflist_lock held
-static void add_member(ast_conf_member *member, ast_conference *conf)
+static int add_member(ast_conf_member *member, ast_conference *conf)
 {
-	ast_conf_member *other_member;
 	// acquire the conference lock
 	ast_rwlock_wrlock(&conf->lock);
 
+	//
+	// grow the tick array if it's full
+	//
+	if (conf->membercount == conf->tickcapacity)
+	{
+		ast_conf_tick *ticklist = ast_realloc(conf->ticklist, 2 * conf->tickcapacity * sizeof(ast_conf_tick));
+
+		if (!ticklist)
+		{
+			ast_rwlock_unlock(&conf->lock);
+			return -1;
+		}
+
+		// repoint the members at their moved entries
+		int index;
+		for (index = 0; index < conf->membercount; ++index)
+		{
+			ticklist[index].member->tick = &ticklist[index];
+		}
+
+		conf->ticklist = ticklist;
+		conf->tickcapacity *= 2;
+	}
+
 	//
 	// if spying, setup spyer/spyee
 	//
@@ -821,9 +1490,18 @@ static void add_member(ast_conf_member *member, ast_conference *conf)
 		}
 	}
 
+	// append the member to the tick array
+	member->tick = &conf->ticklist[conf->membercount];
+	memset(member->tick, 0, sizeof(ast_conf_tick));
+	member->tick->member = member;
+	member->tick->write_format_index = member->write_format_index;
+
 	// update conference count
 	conf->membercount++;
 
+	// update write format count
+	conf->write_formats[member->write_format_index]++;
+
 	// update moderator count
 	if (member->ismoderator)
 		conf->moderators++;
@@ -863,27 +1541,22 @@ static void add_member(ast_conf_member *member, ast_conference *conf)
 //#endif
 	}
 
-	// play join sound to all the rest members of this conference (except last one)
-	if (conf->membercount >1)
+	// overlay the join sound on the conference audio
+	if (conf->membercount > 1)
 	{
-		other_member = conf->memberlist;
-		while (other_member) {
-			member_play_sound(other_member, "join");
-			other_member = other_member->next;
-		}
+		play_sound(&conf->playbacks, find_sound(AST_CONF_JOIN_SOUND));
 	}
 
 	// release the conference lock
 	ast_rwlock_unlock(&conf->lock);
 
-	return;
+	return 0;
 }
 
 void remove_member(ast_conf_member* member, ast_conference* conf, char* conf_name)
 {
 	int membercount;
 	int moderators;
-	ast_conf_member* member_stayed;
 
 	ast_rwlock_wrlock(&conf->lock);
 
@@ -904,14 +1577,25 @@ void remove_member(ast_conf_member* member, ast_conference* conf, char* conf_nam
 	// update member count
 	membercount = --conf->membercount;
 
-	// play leave sound to all the rest members of this conference
-	if (conf->membercount >0)
+	// update write format count
+	conf->write_formats[member->write_format_index]--;
+
+	//
+	// remove member from tick array (the last entry fills the hole)
+	//
+	ast_conf_tick *last = &conf->ticklist[conf->membercount];
+
+	if (member->tick != last)
 	{
-		member_stayed = conf->memberlist;
-		while (member_stayed) {
-			member_play_sound(member_stayed, "leave");
-			member_stayed = member_stayed->next;
-		}
+		*member->tick = *last;
+		member->tick->member->tick = member->tick;
+	}
+	member->tick = NULL;
+
+	// overlay the leave sound on the conference audio
+	if (conf->membercount > 0)
+	{
+		play_sound(&conf->playbacks, find_sound(AST_CONF_LEAVE_SOUND));
 	}
 
 	// play music-on-hold if there is only one conference member left
@@ -1084,7 +1768,7 @@ void list_members(int fd, const char *name)
 				member = conf->memberlist;
 				while (member)
 				{
-					snprintf(volume_str, 10, "%d:%d", member->talk_volume, member->listen_volume);
+					snprintf(volume_str, 10, "%d:%d", member->talk_volume, member->tick->listen_volume);
 					if (member->spyee_channel_name && member->spy_partner)
 						snprintf(spy_str, 10, "%d", member->spy_partner->conf_id);
 					else
@@ -1114,6 +1798,145 @@ void list_members(int fd, const char *name)
 	}
 }
 
+void stats_conferences(int fd)
+{
+	ast_conf_member *member;
+
+        // any conferences?
+	if (conflist)
+	{
+		// acquire mutex
+		ast_mutex_lock(&conflist_lock);
+
+		ast_conference *conf = conflist;
+
+#if	SILDET == 1 || SILDET == 2
+		ast_cli(fd, "%-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-20.20s\n", "Name", "Members", "In Overruns", "In Underruns", "Out Overruns", "Mix Cost (us)", "Encode Hits", "Encode Misses", "VAD Frames", "VAD Gated");
+#else
+		ast_cli(fd, "%-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-20.20s\n", "Name", "Members", "In Overruns", "In Underruns", "Out Overruns", "Mix Cost (us)", "Encode Hits", "Encode Misses");
+#endif
+
+		// loop through conf list
+		while (conf)
+		{
+			unsigned int in_overruns = 0, in_underruns = 0, out_overruns = 0;
+#if	SILDET == 1 || SILDET == 2
+			unsigned int vad_frames = 0, vad_gated = 0;
+#endif
+
+			// acquire conference lock
+			ast_rwlock_rdlock(&conf->lock);
+
+			// sum the member queue counters
+			for (member = conf->memberlist; member; member = member->next)
+			{
+				in_overruns += member->incomingq.overruns;
+				in_underruns += member->incomingq.underruns;
+				out_overruns += member->outgoingq.overruns;
+#if	SILDET == 1 || SILDET == 2
+				vad_frames += member->vad_frames;
+				vad_gated += member->vad_gated;
+#endif
+			}
+
+#if	SILDET == 1 || SILDET == 2
+			ast_cli(fd, "%-20.20s %-20d %-20u %-20u %-20u %-20d %-20u %-20u %-20u %-20u\n", conf->name, conf->membercount, in_overruns, in_underruns, out_overruns, conf->mix_cost, conf->encode_hits, conf->encode_misses, vad_frames, vad_gated);
+#else
+			ast_cli(fd, "%-20.20s %-20d %-20u %-20u %-20u %-20d %-20u %-20u\n", conf->name, conf->membercount, in_overruns, in_underruns, out_overruns, conf->mix_cost, conf->encode_hits, conf->encode_misses);
+#endif
+
+			// release conference lock
+			ast_rwlock_unlock(&conf->lock);
+
+			conf = conf->next;
+		}
+
+		// release mutex
+		ast_mutex_unlock(&conflist_lock);
+	}
+}
+
+void stats_members(int fd, const char *name)
+{
+	ast_conf_member *member;
+
+        // any conferences?
+	if (conflist)
+	{
+		// acquire mutex
+		ast_mutex_lock(&conflist_lock);
+
+		ast_conference *conf = conflist;
+
+		// loop through conf list
+		while (conf)
+		{
+			if (!strcasecmp((const char*)&(conf->name), name))
+			{
+				// acquire conference lock
+				ast_rwlock_rdlock(&conf->lock);
+
+				// print the header
+#if	AST_CONF_SOUND_READERS
+				ast_cli(fd, "%s:\n%-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-80.20s\n", conf->name, "User #", "In Overruns", "In Underruns", "Out Overruns", "Sound Depth", "Sound Underruns", "Channel");
+#else
+				ast_cli(fd, "%s:\n%-20.20s %-20.20s %-20.20s %-20.20s %-80.20s\n", conf->name, "User #", "In Overruns", "In Underruns", "Out Overruns", "Channel");
+#endif
+
+				for (member = conf->memberlist; member; member = member->next)
+				{
+#if	AST_CONF_SOUND_READERS
+					ast_cli(fd, "%-20d %-20u %-20u %-20u %-20d %-20u %-80s\n",
+#if	ASTERISK_SRC_VERSION < 1100
+					member->conf_id, member->incomingq.overruns, member->incomingq.underruns, member->outgoingq.overruns, member->sound_depth, member->sound_underruns, member->chan->name);
+#else
+					member->conf_id, member->incomingq.overruns, member->incomingq.underruns, member->outgoingq.overruns, member->sound_depth, member->sound_underruns, ast_channel_name(member->chan));
+#endif
+#else
+					ast_cli(fd, "%-20d %-20u %-20u %-20u %-80s\n",
+#if	ASTERISK_SRC_VERSION < 1100
+					member->conf_id, member->incomingq.overruns, member->incomingq.underruns, member->outgoingq.overruns, member->chan->name);
+#else
+					member->conf_id, member->incomingq.overruns, member->incomingq.underruns, member->outgoingq.overruns, ast_channel_name(member->chan));
+#endif
+#endif
+				}
+
+				// print the write formats and their listener frame encode cost
+				ast_cli(fd, "%-20.20s %-20.20s %-20.20s\n", "Write Format", "Members", "Encode Cost (us)");
+
+				int index;
+				for (index = 0; index < AC_SUPPORTED_FORMATS; ++index)
+				{
+					if (conf->write_formats[index])
+						ast_cli(fd, "%-20.20s %-20d %-20d\n", format_names[index], conf->write_formats[index], conf->encode_cost[index]);
+				}
+
+#if	AST_CONF_JITTER_BUFFER
+				// print the jitter buffers ( late frames are the incoming underruns )
+				ast_cli(fd, "%-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-20.20s\n", "User #", "Jitter (ms)", "Buffer Depth", "Buffer Target", "Late", "Dropped");
+
+				for (member = conf->memberlist; member; member = member->next)
+				{
+					ast_cli(fd, "%-20d %-20d %-20d %-20d %-20u %-20u\n",
+						member->conf_id, member->jb_jitter / 1000, member->jb_depth, member->jb_target, member->incomingq.underruns, member->jb_dropped);
+				}
+#endif
+
+				// release conference lock
+				ast_rwlock_unlock(&conf->lock);
+
+				break;
+			}
+
+			conf = conf->next;
+		}
+
+		// release mutex
+		ast_mutex_unlock(&conflist_lock);
+	}
+}
+
 void list_all(int fd)
 {
 	ast_conf_member *member;
@@ -1142,7 +1965,7 @@ void list_all(int fd)
 			member = conf->memberlist;
 			while (member)
 			{
-				snprintf(volume_str, 10, "%d:%d", member->talk_volume, member->listen_volume);
+				snprintf(volume_str, 10, "%d:%d", member->talk_volume, member->tick->listen_volume);
 				if (member->spyee_channel_name && member->spy_partner)
 					snprintf(spy_str, 10, "%d", member->spy_partner->conf_id);
 				else
@@ -1459,9 +2282,9 @@ ast_conf_member *find_member(const char *chan)
 }
 
 #if	ASTERISK_SRC_VERSION == 104 || ASTERISK_SRC_VERSION == 106
-void play_sound_channel(int fd, const char *channel, char **file, int mute, int tone, int n)
+int play_sound_channel(int fd, const char *channel, char **file, int mute, int tone, int n)
 #else
-void play_sound_channel(int fd, const char *channel, const char * const *file, int mute, int tone, int n)
+int play_sound_channel(int fd, const char *channel, const char * const *file, int mute, int tone, int n)
 #endif
 {
 	ast_conf_member *member;
@@ -1474,6 +2297,9 @@ void play_sound_channel(int fd, const char *channel, const char * const *file, i
 		if (!member->norecv_audio && !ast_test_flag(member->chan, AST_FLAG_MOH)
 #else
 		if (!member->norecv_audio && !ast_test_flag(ast_channel_flags(member->chan), AST_FLAG_MOH)
+#endif
+#if	AST_CONF_SHARED_MOH
+				&& !member->moh_playing
 #endif
 				&& (!tone || !member->soundq))
 		{
@@ -1491,15 +2317,113 @@ void play_sound_channel(int fd, const char *channel, const char * const *file, i
 			}
 
 			member->muted = mute;
+#if	AST_CONF_SOUND_READERS
+			// read the sounds ahead of the member's output
+			prefetch_sounds(member);
+#endif
 
 		}
 		if (!--member->use_count && member->delete_flag)
 			ast_cond_signal(&member->delete_var);
 		ast_mutex_unlock(&member->lock);
+
+		return 0;
+	}
+
+	return -1;
+}
+
+#if	ASTERISK_SRC_VERSION == 104 || ASTERISK_SRC_VERSION == 106
+int play_sound_conference(int fd, const char *conference, char **file, int duck, int tone, int n)
+#else
+int play_sound_conference(int fd, const char *conference, const char * const *file, int duck, int tone, int n)
+#endif
+{
+	ast_conference *conf;
+	ast_conf_sound *sounds[n];
+	int i, res = -1;
+
+	// an unknown conference decodes nothing
+	ast_mutex_lock(&conflist_lock);
+	conf = find_conf(conference);
+	ast_mutex_unlock(&conflist_lock);
+
+	if (!conf)
+	{
+		return -1;
+	}
+
+	// decode the sounds for this request before locking the conference
+	for (i = 0; i < n; ++i)
+	{
+		sounds[i] = load_sound(file[i]);
+	}
+
+	// acquire the conference list lock
+	ast_mutex_lock(&conflist_lock);
+
+	if ((conf = find_conf(conference)))
+	{
+		// acquire the conference lock
+		ast_rwlock_wrlock(&conf->lock);
+
+		if (!tone || !queued_sounds(conf->playbacks))
+		{
+			for (i = 0; i < n; ++i)
+			{
+				// the playback owns a queued sound
+				if (!queue_sound(&conf->playbacks, sounds[i], duck))
+					sounds[i] = NULL;
+			}
+		}
+
+		// release the conference lock
+		ast_rwlock_unlock(&conf->lock);
+
+		res = 0;
+	}
+
+	// release the conference list lock
+	ast_mutex_unlock(&conflist_lock);
+
+	// free the sounds that weren't queued
+	for (i = 0; i < n; ++i)
+	{
+		free_sound(sounds[i]);
+	}
+
+	return res;
+}
+
+int stop_sound_conference(int fd, const char *conference)
+{
+	ast_conference *conf;
+	int res = -1;
+
+	// acquire the conference list lock
+	ast_mutex_lock(&conflist_lock);
+
+	if ((conf = find_conf(conference)))
+	{
+		// acquire the conference lock
+		ast_rwlock_wrlock(&conf->lock);
+
+		// the join and leave sounds play out
+		stop_queued_sounds(&conf->playbacks);
+
+		// release the conference lock
+		ast_rwlock_unlock(&conf->lock);
+
+		res = 0;
 	}
+
+	// release the conference list lock
+	ast_mutex_unlock(&conflist_lock);
+
+	return res;
 }
 
-void stop_sound_channel(int fd, const char *channel)
+int stop_sound_channel(int fd, const char *channel)
 {
 	ast_conf_member *member;
 	ast_conf_soundq *sound;
@@ -1522,7 +2446,11 @@ void stop_sound_channel(int fd, const char *channel)
 		if (!--member->use_count && member->delete_flag)
 			ast_cond_signal(&member->delete_var);
 		ast_mutex_unlock(&member->lock);
+
+		return 0;
 	}
+
+	return -1;
 }
 
 void start_moh_channel(int fd, const char *channel)
@@ -1544,15 +2472,10 @@ void start_moh_channel(int fd, const char *channel)
 				sound = next;
 			}
 
+			// the member thread drops any queued frames
 			member->muted = 1;
 			member->ready_for_outgoing = 0;
 
-			struct ast_frame *f; 
-			while ((f = get_outgoing_frame(member)))
-			{
-				ast_frfree(f);
-			}
-
 			ast_moh_start(member->chan, NULL, NULL);
 		}
 
@@ -1597,16 +2520,22 @@ void start_moh_member(int fd, ast_conf_member* member)
 			sound = next;
 		}
 
-		member->muted = 1;
-		member->ready_for_outgoing = 0;
-
-		struct ast_frame *f;
-		while ((f = get_outgoing_frame(member)))
+#if	AST_CONF_SHARED_MOH
+		// the mixer queues the shared music on hold from the start of its ring
+		if (member->moh)
 		{
-			ast_frfree(f);
+			member->moh_block = 0;
+			member->moh_playing = 1;
 		}
+		else
+#endif
+		{
+			// the member thread drops any queued frames
+			member->muted = 1;
+			member->ready_for_outgoing = 0;
 
-		ast_moh_start(member->chan, NULL, NULL);
+			ast_moh_start(member->chan, NULL, NULL);
+		}
 	}
 
 	ast_mutex_unlock(&member->lock);
@@ -1616,10 +2545,19 @@ void stop_moh_member(int fd, ast_conf_member* member)
 {
 	if (!member->norecv_audio)
 	{
-		member->muted = 0;
-		member->ready_for_outgoing = 1;
+#if	AST_CONF_SHARED_MOH
+		if (member->moh_playing)
+		{
+			member->moh_playing = 0;
+		}
+		else
+#endif
+		{
+			member->muted = 0;
+			member->ready_for_outgoing = 1;
 
-		ast_moh_stop(member->chan);
+			ast_moh_stop(member->chan);
+		}
 	}
 
 	ast_mutex_unlock(&member->lock);
@@ -1642,15 +2580,33 @@ void talk_volume_channel(int fd, const char *channel, int up)
 void listen_volume_channel(int fd, const char *channel, int up)
 {
 	ast_conf_member *member;
+	ast_conference *conf;
+
+	// acquire the conference list lock
+	ast_mutex_lock(&conflist_lock);
 
 	if ((member = find_member(channel)))
 	{
-		up ? member->listen_volume++ : member->listen_volume--;
+		// the listen volume is kept in the member's tick entry,
+		// which only stays put under the conference lock
+		conf = member->conf;
+		ast_mutex_unlock(&member->lock);
+
+		ast_rwlock_rdlock(&conf->lock);
+		ast_mutex_lock(&member->lock);
+
+		if (member->tick)
+			up ? member->tick->listen_volume++ : member->tick->listen_volume--;
+
+		ast_rwlock_unlock(&conf->lock);
 
 		if (!--member->use_count && member->delete_flag)
 			ast_cond_signal(&member->delete_var);
 		ast_mutex_unlock(&member->lock);
 	}
+
+	// release the conference list lock
+	ast_mutex_unlock(&conflist_lock);
 }
 
 void volume(int fd, const char *conference, int up)
@@ -25,6 +25,7 @@
 
 #include "app_conference.h"
 #include "member.h"
+#include "sound.h"
 
 //
 // defines
@@ -55,9 +56,15 @@ struct ast_conference
 	// conference listener frame
 	conf_frame *listener_frame;
 
+	// lone speaker of a tick whose frame became the listener frame ( it hears only the sounds )
+	ast_conf_member *lone_speaker;
+
 	// conference volume
 	int volume;
 
+	// zero or max speakers mixed per tick
+	int max_speakers;
+
 	// single-linked list of members in conference
 	ast_conf_member* memberlist;
 
@@ -67,6 +74,17 @@ struct ast_conference
 	int membercount;
         int id_count;
 
+	// contiguous per tick state of the members in conference
+	ast_conf_tick* ticklist;
+	int tickcapacity;
+
+#if	SILDET == 1
+	// incoming frames waiting for a batched vad decision on this tick
+	int vad_count;
+	ast_conf_tick* vad_ticks[AST_CONF_VAD_BATCH];
+	conf_frame* vad_frames[AST_CONF_VAD_BATCH];
+#endif
+
 	// conference data lock
 	ast_rwlock_t lock;
 
@@ -74,6 +92,13 @@ struct ast_conference
 	ast_conference* next;
 	ast_conference* prev;
 
+	// mixer thread for this conference
+	ast_conf_mixer* mixer;
+
+	// pointers to conference in mixer's doubly-linked list
+	ast_conference* mixer_next;
+	ast_conference* mixer_prev;
+
 	// pointer to conference's bucket list head
 	struct conference_bucket *bucket;
 	// list entry for conference's bucket list
@@ -85,15 +110,32 @@ struct ast_conference
 	// keep track of current delivery time
 	struct timeval delivery_time;
 
+	// mix cost in microseconds per tick
+	int mix_cost;
+
+	// listener frames reused from the tick's conversions and converted
+	unsigned int encode_hits;
+	unsigned int encode_misses;
+
+	// members per write format
+	int write_formats[AC_SUPPORTED_FORMATS];
+
+	// listener frame encode cost per write format in microseconds per tick
+	int encode_cost[AC_SUPPORTED_FORMATS];
+
+	// listener mix accumulator
+	int listenerAccumulator[AST_CONF_BLOCK_SAMPLES] __attribute((aligned(64)));
 	// listener mix buffer
-#ifdef	VECTORS
-	char listenerBuffer[AST_CONF_BUFFER_SIZE] __attribute((aligned(16)));
-#else
-	char listenerBuffer[AST_CONF_BUFFER_SIZE];
-#endif
+	char listenerBuffer[AST_CONF_BUFFER_SIZE] __attribute((aligned(64)));
 	// listener mix frames
 	struct ast_frame *mixAstFrame;
 	conf_frame *mixConfFrame;
+
+	// silent frames shared by the members on this tick
+	ast_conf_sharedframe *silent_frames[AC_SUPPORTED_FORMATS];
+
+	// sounds overlaid on the conference audio
+	ast_conf_playback *playbacks;
 };
 
 //
@@ -113,9 +155,9 @@ ast_conference* join_conference(ast_conf_member* member, char* conf_name, char*
 // Find member, locked if found.
 ast_conf_member *find_member(const char *chan);
 
-void queue_frame_for_listener(ast_conference* conf, ast_conf_member* member);
-void queue_frame_for_speaker(ast_conference* conf, ast_conf_member* member);
-void queue_silent_frame(ast_conference* conf, ast_conf_member* member);
+void queue_frame_for_listener(ast_conference* conf, ast_conf_tick* tick);
+void queue_frame_for_speaker(ast_conference* conf, ast_conf_tick* tick);
+void queue_silent_frame(ast_conference* conf, ast_conf_tick* tick);
 
 void get_unison_event_server_node_variable(struct ast_channel *channel, char **varval, char *workspace, int wssize);
 
@@ -133,6 +175,9 @@ void list_members(int fd, const char* name);
 void list_conferences(int fd);
 void list_all(int fd);
 
+void stats_members(int fd, const char* name);
+void stats_conferences(int fd);
+
 #ifdef	KICK_MEMBER
 void kick_member(const char* confname, int user_id);
 #endif
@@ -149,12 +194,15 @@ void mute_conference(const char* confname);
 void unmute_conference(const char* confname);
 
 #if	ASTERISK_SRC_VERSION == 104 || ASTERISK_SRC_VERSION == 106
-void play_sound_channel(int fd, const char *channel, char **file, int mute, int tone, int n);
+int play_sound_channel(int fd, const char *channel, char **file, int mute, int tone, int n);
+int play_sound_conference(int fd, const char *conference, char **file, int duck, int tone, int n);
 #else
-void play_sound_channel(int fd, const char *channel, const char * const *file, int mute, int tone, int n);
+int play_sound_channel(int fd, const char *channel, const char * const *file, int mute, int tone, int n);
+int play_sound_conference(int fd, const char *conference, const char * const *file, int duck, int tone, int n);
 #endif
 
-void stop_sound_channel(int fd, const char *channel);
+int stop_sound_channel(int fd, const char *channel);
+int stop_sound_conference(int fd, const char *conference);
 
 void start_moh_member(int fd, ast_conf_member* member);
 void stop_moh_member(int fd, ast_conf_member* member);
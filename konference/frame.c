@@ -17,7 +17,10 @@
  */
 
 #include "asterisk/autoconfig.h"
+#include "asterisk/ulaw.h"
+#include "asterisk/alaw.h"
 #include "frame.h"
+#include "slab.h"
 
 static char data[AST_CONF_BUFFER_SIZE];
 
@@ -40,88 +43,367 @@ static conf_frame cfr =  { .fr = &fr, .converted[AC_CONF_INDEX] = &fr };
 
 conf_frame *silent_conf_frame = &cfr;
 
-#ifdef	VECTORS
+//
+// saturating slinear mix kernels
+//
+// every kernel mixes one AST_CONF_BLOCK_SAMPLES block (160 samples or
+// 320 samples for G.722) and is bit-exact with the portable C kernel;
+// the kernel is selected at module load by init_mix_kernels()
+//
+// the conference mix is accumulated in 32 bits so that each speaker's
+// mix-minus is exact and is saturated once, on output
+//
 
-typedef short v4si __attribute__ ((vector_size (16))); 
+#if	AST_CONF_BLOCK_SAMPLES % 32
+#error AST_CONF_BLOCK_SAMPLES must be a multiple of 32 samples
+#endif
 
-static inline void mix_slinear_frames(char *dst, const char *src, int samples)
+static inline short saturate_slinear(int val)
+{
+	return val > 32767 ? 32767 : val < -32768 ? -32768 : val;
+}
+
+static void mix_slinear_frames_c(char *dst, const char *src)
 {
 	int i;
 
-	for (i = 0; i < samples / 8; ++i)
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; ++i)
 	{
-		((v4si *)dst)[i] = ((v4si *)dst)[i] + ((v4si *)src)[i];
+		((short*)dst)[i] = saturate_slinear(((short*)dst)[i] + ((short*)src)[i]);
 	}
+}
 
-	return;
+static void accumulate_slinear_frame_c(int *acc, const char *src)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; ++i)
+	{
+		acc[i] += ((short*)src)[i];
+	}
 }
 
-static inline void unmix_slinear_frame(char *dst, const char *src1, const char *src2, int samples)
+static void saturate_slinear_frame_c(char *dst, const int *acc)
 {
 	int i;
 
-	for (i = 0; i < samples / 8; ++i)
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; ++i)
 	{
-		((v4si *)dst)[i] = ((v4si *)src1)[i] - ((v4si *)src2)[i];
+		((short*)dst)[i] = saturate_slinear(acc[i]);
 	}
+}
+
+static void unmix_slinear_frame_c(char *dst, const int *acc, const char *src)
+{
+	int i;
 
-	return;
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; ++i)
+	{
+		((short*)dst)[i] = saturate_slinear(acc[i] - ((short*)src)[i]);
+	}
 }
 
-#else
+#if	defined(__x86_64__) || defined(__i386__)
 
-static void mix_slinear_frames(char *dst, const char *src, int samples)
+#include <immintrin.h>
+
+__attribute__((target("sse2")))
+static void mix_slinear_frames_sse2(char *dst, const char *src)
 {
-	int i, val;
+	int i;
 
-	for (i = 0; i < samples; ++i)
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES * 2; i += 16)
 	{
-		val = ((short*)dst)[i] + ((short*)src)[i];
+		__m128i d = _mm_loadu_si128((__m128i*)(dst + i));
+		__m128i s = _mm_loadu_si128((__m128i*)(src + i));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epi16(d, s));
+	}
+}
 
-		if (val > 32767)
-		{
-			((short*)dst)[i] = 32767;
-		}
-		else if (val < -32768)
-		{
-			((short*)dst)[i] = -32768;
-		}
-		else
-		{
-			((short*)dst)[i] = val;
-		}
+__attribute__((target("sse2")))
+static void accumulate_slinear_frame_sse2(int *acc, const char *src)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 8)
+	{
+		__m128i s = _mm_loadu_si128((__m128i*)((short*)src + i));
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+		_mm_storeu_si128((__m128i*)(acc + i), _mm_add_epi32(_mm_loadu_si128((__m128i*)(acc + i)), lo));
+		_mm_storeu_si128((__m128i*)(acc + i + 4), _mm_add_epi32(_mm_loadu_si128((__m128i*)(acc + i + 4)), hi));
+	}
+}
+
+__attribute__((target("sse2")))
+static void saturate_slinear_frame_sse2(char *dst, const int *acc)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 8)
+	{
+		__m128i lo = _mm_loadu_si128((__m128i*)(acc + i));
+		__m128i hi = _mm_loadu_si128((__m128i*)(acc + i + 4));
+		_mm_storeu_si128((__m128i*)((short*)dst + i), _mm_packs_epi32(lo, hi));
 	}
+}
+
+__attribute__((target("sse2")))
+static void unmix_slinear_frame_sse2(char *dst, const int *acc, const char *src)
+{
+	int i;
 
-	return;
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 8)
+	{
+		__m128i s = _mm_loadu_si128((__m128i*)((short*)src + i));
+		__m128i lo = _mm_sub_epi32(_mm_loadu_si128((__m128i*)(acc + i)), _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+		__m128i hi = _mm_sub_epi32(_mm_loadu_si128((__m128i*)(acc + i + 4)), _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+		_mm_storeu_si128((__m128i*)((short*)dst + i), _mm_packs_epi32(lo, hi));
+	}
 }
 
-static void unmix_slinear_frame(char *dst, const char *src1, const char *src2, int samples)
+__attribute__((target("avx2")))
+static void mix_slinear_frames_avx2(char *dst, const char *src)
 {
-	int i, val;
+	int i;
 
-	for (i = 0; i < samples; ++i)
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES * 2; i += 32)
 	{
-		val = ((short*)src1)[i] - ((short*)src2)[i];
+		__m256i d = _mm256_loadu_si256((__m256i*)(dst + i));
+		__m256i s = _mm256_loadu_si256((__m256i*)(src + i));
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epi16(d, s));
+	}
+}
 
-		if (val > 32767)
-		{
-			((short*)dst)[i] = 32767;
-		}
-		else if (val < -32768)
-		{
-			((short*)dst)[i] = -32768;
-		}
-		else
-		{
-			((short*)dst)[i] = val;
-		}
+__attribute__((target("avx2")))
+static void accumulate_slinear_frame_avx2(int *acc, const char *src)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 8)
+	{
+		__m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)((short*)src + i)));
+		_mm256_storeu_si256((__m256i*)(acc + i), _mm256_add_epi32(_mm256_loadu_si256((__m256i*)(acc + i)), s));
+	}
+}
+
+__attribute__((target("avx2")))
+static void saturate_slinear_frame_avx2(char *dst, const int *acc)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 16)
+	{
+		__m256i lo = _mm256_loadu_si256((__m256i*)(acc + i));
+		__m256i hi = _mm256_loadu_si256((__m256i*)(acc + i + 8));
+		// packs works within 128 bit lanes so restore the sample order
+		_mm256_storeu_si256((__m256i*)((short*)dst + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8));
+	}
+}
+
+__attribute__((target("avx2")))
+static void unmix_slinear_frame_avx2(char *dst, const int *acc, const char *src)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 16)
+	{
+		__m256i lo = _mm256_sub_epi32(_mm256_loadu_si256((__m256i*)(acc + i)),
+			_mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)((short*)src + i))));
+		__m256i hi = _mm256_sub_epi32(_mm256_loadu_si256((__m256i*)(acc + i + 8)),
+			_mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)((short*)src + i + 8))));
+		_mm256_storeu_si256((__m256i*)((short*)dst + i), _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8));
+	}
+}
+
+__attribute__((target("avx512bw")))
+static void mix_slinear_frames_avx512(char *dst, const char *src)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES * 2; i += 64)
+	{
+		__m512i d = _mm512_loadu_si512((void*)(dst + i));
+		__m512i s = _mm512_loadu_si512((void*)(src + i));
+		_mm512_storeu_si512((void*)(dst + i), _mm512_adds_epi16(d, s));
+	}
+}
+
+__attribute__((target("avx512bw")))
+static void accumulate_slinear_frame_avx512(int *acc, const char *src)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 16)
+	{
+		__m512i s = _mm512_cvtepi16_epi32(_mm256_loadu_si256((__m256i*)((short*)src + i)));
+		_mm512_storeu_si512((void*)(acc + i), _mm512_add_epi32(_mm512_loadu_si512((void*)(acc + i)), s));
+	}
+}
+
+__attribute__((target("avx512bw")))
+static void saturate_slinear_frame_avx512(char *dst, const int *acc)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 16)
+	{
+		_mm256_storeu_si256((__m256i*)((short*)dst + i), _mm512_cvtsepi32_epi16(_mm512_loadu_si512((void*)(acc + i))));
+	}
+}
+
+__attribute__((target("avx512bw")))
+static void unmix_slinear_frame_avx512(char *dst, const int *acc, const char *src)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 16)
+	{
+		__m512i d = _mm512_sub_epi32(_mm512_loadu_si512((void*)(acc + i)),
+			_mm512_cvtepi16_epi32(_mm256_loadu_si256((__m256i*)((short*)src + i))));
+		_mm256_storeu_si256((__m256i*)((short*)dst + i), _mm512_cvtsepi32_epi16(d));
+	}
+}
+
+#elif	defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+static void mix_slinear_frames_neon(char *dst, const char *src)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 8)
+	{
+		int16x8_t d = vld1q_s16((short*)dst + i);
+		int16x8_t s = vld1q_s16((short*)src + i);
+		vst1q_s16((short*)dst + i, vqaddq_s16(d, s));
+	}
+}
+
+static void accumulate_slinear_frame_neon(int *acc, const char *src)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 4)
+	{
+		vst1q_s32(acc + i, vaddw_s16(vld1q_s32(acc + i), vld1_s16((short*)src + i)));
+	}
+}
+
+static void saturate_slinear_frame_neon(char *dst, const int *acc)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 4)
+	{
+		vst1_s16((short*)dst + i, vqmovn_s32(vld1q_s32(acc + i)));
 	}
+}
 
-	return;
+static void unmix_slinear_frame_neon(char *dst, const int *acc, const char *src)
+{
+	int i;
+
+	for (i = 0; i < AST_CONF_BLOCK_SAMPLES; i += 4)
+	{
+		vst1_s16((short*)dst + i, vqmovn_s32(vsubw_s16(vld1q_s32(acc + i), vld1_s16((short*)src + i))));
+	}
 }
 
 #endif
 
+// selected kernels
+void (*mix_slinear_frames)(char *dst, const char *src) = mix_slinear_frames_c;
+static void (*accumulate_slinear_frame)(int *acc, const char *src) = accumulate_slinear_frame_c;
+static void (*saturate_slinear_frame)(char *dst, const int *acc) = saturate_slinear_frame_c;
+static void (*unmix_slinear_frame)(char *dst, const int *acc, const char *src) = unmix_slinear_frame_c;
+
+// called by conference.c:init_conference()
+void init_mix_kernels(void)
+{
+	const char *name = "c";
+
+#if	defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512bw"))
+	{
+		mix_slinear_frames = mix_slinear_frames_avx512;
+		accumulate_slinear_frame = accumulate_slinear_frame_avx512;
+		saturate_slinear_frame = saturate_slinear_frame_avx512;
+		unmix_slinear_frame = unmix_slinear_frame_avx512;
+		name = "avx512";
+	}
+	else if (__builtin_cpu_supports("avx2"))
+	{
+		mix_slinear_frames = mix_slinear_frames_avx2;
+		accumulate_slinear_frame = accumulate_slinear_frame_avx2;
+		saturate_slinear_frame = saturate_slinear_frame_avx2;
+		unmix_slinear_frame = unmix_slinear_frame_avx2;
+		name = "avx2";
+	}
+	else if (__builtin_cpu_supports("sse2"))
+	{
+		mix_slinear_frames = mix_slinear_frames_sse2;
+		accumulate_slinear_frame = accumulate_slinear_frame_sse2;
+		saturate_slinear_frame = saturate_slinear_frame_sse2;
+		unmix_slinear_frame = unmix_slinear_frame_sse2;
+		name = "sse2";
+	}
+#elif	defined(__ARM_NEON) || defined(__ARM_NEON__)
+	mix_slinear_frames = mix_slinear_frames_neon;
+	accumulate_slinear_frame = accumulate_slinear_frame_neon;
+	saturate_slinear_frame = saturate_slinear_frame_neon;
+	unmix_slinear_frame = unmix_slinear_frame_neon;
+	name = "neon";
+#endif
+
+	ast_log(LOG_NOTICE, "mixing %d sample blocks with %s kernels\n", AST_CONF_BLOCK_SAMPLES, name);
+}
+
+// convert a slinear frame to a write format in a new shared frame, g.711 without the translator
+ast_conf_sharedframe* encode_frame(int format_index, struct ast_trans_pvt* trans, struct ast_frame* fr, struct timeval delivery)
+{
+	ast_conf_sharedframe* sf;
+	struct ast_frame* qf;
+
+#ifndef	AC_USE_G722
+	if ((format_index == AC_ULAW_INDEX || format_index == AC_ALAW_INDEX)
+		&& (sf = encode_g711_frame(fr, format_index, delivery)))
+	{
+		return sf;
+	}
+#endif
+
+	if (!(qf = convert_frame(trans, fr, 0)))
+	{
+		return NULL;
+	}
+
+	sf = create_shared_frame(qf, delivery);
+
+	// free frame (the translator's copy)
+	if (trans)
+		ast_frfree(qf);
+
+	return sf;
+}
+
+// convert a speaker's frame to the conference format, g.711 without the translator
+static struct ast_frame* decode_conf_frame(conf_frame* cf)
+{
+#ifndef	AC_USE_G722
+	int index = cf->member->read_format_index;
+
+	if ((index == AC_ULAW_INDEX || index == AC_ALAW_INDEX) && (cf->decoded = decode_g711_frame(cf->fr, index)))
+	{
+		return &cf->decoded->fr;
+	}
+#endif
+	return convert_frame(cf->member->to_slinear, cf->fr, 0);
+}
+
 conf_frame* mix_frames(ast_conference* conf, conf_frame* frames_in, int speaker_count, int listener_count)
 {
 	if (speaker_count == 1)
@@ -138,7 +420,7 @@ conf_frame* mix_frames(ast_conference* conf, conf_frame* frames_in, int speaker_
 		frames_in->converted[frames_in->member->read_format_index] = frames_in->fr;
 
 		// convert frame to slinear and adjust volume; otherwise, drop both frames
-		if (!(frames_in->fr = convert_frame(frames_in->member->to_slinear, frames_in->fr, 0)))
+		if (!(frames_in->fr = decode_conf_frame(frames_in)))
 		{
 			ast_log(LOG_WARNING, "mix_frames: unable to convert frame to slinear\n");
 			return NULL;
@@ -152,7 +434,7 @@ conf_frame* mix_frames(ast_conference* conf, conf_frame* frames_in, int speaker_
 		frames_in->next->converted[frames_in->next->member->read_format_index] = frames_in->next->fr;
 
 		// convert frame to slinear and adjust volume; otherwise, drop both frames
-		if (!(frames_in->next->fr = convert_frame(frames_in->next->member->to_slinear, frames_in->next->fr, 0)))
+		if (!(frames_in->next->fr = decode_conf_frame(frames_in->next)))
 		{
 			ast_log(LOG_WARNING, "mix_frames: unable to convert frame to slinear\n");
 			return NULL;
@@ -167,8 +449,8 @@ conf_frame* mix_frames(ast_conference* conf, conf_frame* frames_in, int speaker_
 		frames_in->member = frames_in->next->member;
 		frames_in->next->member = mbr;
 
-		frames_in->member->speaker_frame = frames_in;
-		frames_in->next->member->speaker_frame = frames_in->next;
+		frames_in->member->tick->speaker_frame = frames_in;
+		frames_in->next->member->tick->speaker_frame = frames_in->next;
 
 		return frames_in;
 	}
@@ -189,7 +471,7 @@ conf_frame* mix_single_speaker(ast_conference* conf, conf_frame* frames_in)
 	frames_in->converted[frames_in->member->read_format_index] = frames_in->fr;
 
 	// convert frame to slinear; otherwise, drop the frame
-	if (!(frames_in->fr = convert_frame(frames_in->member->to_slinear, frames_in->fr, 0)))
+	if (!(frames_in->fr = decode_conf_frame(frames_in)))
 	{
 		ast_log(LOG_WARNING, "mix_single_speaker: unable to convert frame to slinear\n");
 		return NULL;
@@ -206,6 +488,7 @@ conf_frame* mix_single_speaker(ast_conference* conf, conf_frame* frames_in)
 
 		// set the conference listener frame
 		conf->listener_frame = frames_in;
+		conf->lone_speaker = frames_in->member;
 		frames_in->member = NULL;
 	}
 	else
@@ -228,7 +511,7 @@ conf_frame* mix_single_speaker(ast_conference* conf, conf_frame* frames_in)
 					= !frames_in->member->to_slinear ? spy_frame->fr :
 						ast_frdup(frames_in->converted[frames_in->member->read_format_index]); 
 
-				spy_frame->member->speaker_frame = spy_frame;
+				spy_frame->member->tick->speaker_frame = spy_frame;
 			}
 
 			// set the conference listener frame
@@ -239,13 +522,104 @@ conf_frame* mix_single_speaker(ast_conference* conf, conf_frame* frames_in)
 		{
 			frames_in->member = frames_in->member->spy_partner;
 
-			frames_in->member->speaker_frame = frames_in;
+			frames_in->member->tick->speaker_frame = frames_in;
 		}
 	}
 
 	return frames_in;
 }
 
+conf_frame* mix_sounds(ast_conference* conf, conf_frame* send_frames)
+{
+	short block[AST_CONF_BLOCK_SAMPLES] __attribute((aligned(64)));
+	ast_conf_member* member;
+	conf_frame* cf;
+	short* samples;
+	int duck, i;
+
+	// mix the next block of the playing sounds
+	if (!next_sound_block(&conf->playbacks, block, &duck))
+	{
+		return send_frames;
+	}
+
+	// overlay the block on the listener and speaker frames
+	for (cf = send_frames; cf; cf = cf->next)
+	{
+		// frames of another size are sent as they are
+		if (!cf->fr || cf->fr->samples != AST_CONF_BLOCK_SAMPLES)
+			continue;
+
+#if	ASTERISK_SRC_VERSION == 104
+		samples = cf->fr->data;
+#else
+		samples = cf->fr->data.ptr;
+#endif
+		// duck or mute the conference audio under an announcement
+		if (duck == AST_CONF_SOUND_MUTE)
+		{
+			memset(samples, 0, AST_CONF_BLOCK_SAMPLES * sizeof(short));
+		}
+		else if (duck == AST_CONF_SOUND_DUCK)
+		{
+			for (i = 0; i < AST_CONF_BLOCK_SAMPLES; ++i)
+				samples[i] /= AST_CONF_DUCK_VOLUME;
+		}
+
+		mix_slinear_frames((char*)samples, (char*)block);
+
+		// the frame no longer matches its converted versions
+		if (!cf->talk_volume)
+			cf->talk_volume = 1;
+	}
+
+	// the lone speaker hears the bare block
+	if ((member = conf->lone_speaker) && !member->tick->speaker_frame)
+	{
+		if (!member->speakerBuffer)
+			member->speakerBuffer = ast_malloc(AST_CONF_BUFFER_SIZE);
+
+		if (member->speakerBuffer && (cf = create_mix_frame(member, send_frames, &member->mixConfFrame)))
+		{
+			cf->mixed_buffer = member->speakerBuffer + AST_FRIENDLY_OFFSET;
+			memcpy(cf->mixed_buffer, block, sizeof(block));
+
+			if ((cf->fr = create_slinear_frame(&member->mixAstFrame, cf->mixed_buffer)))
+			{
+				member->tick->speaker_frame = cf;
+				send_frames = cf;
+			}
+			else if (send_frames)
+			{
+				send_frames->prev = NULL;
+			}
+		}
+	}
+
+	// without a listener frame the block is the listener frame
+	if (!conf->listener_frame)
+	{
+		if (!(cf = create_mix_frame(NULL, send_frames, &conf->mixConfFrame)))
+			return send_frames;
+
+		cf->mixed_buffer = conf->listenerBuffer + AST_FRIENDLY_OFFSET;
+		memcpy(cf->mixed_buffer, block, sizeof(block));
+
+		if (!(cf->fr = create_slinear_frame(&conf->mixAstFrame, cf->mixed_buffer)))
+		{
+			if (send_frames)
+				send_frames->prev = NULL;
+			return send_frames;
+		}
+
+		// set the conference listener frame
+		conf->listener_frame = cf;
+		send_frames = cf;
+	}
+
+	return send_frames;
+}
+
 conf_frame* mix_multiple_speakers(
 	ast_conference* conf,	
 	conf_frame* frames_in,
@@ -260,15 +634,15 @@ conf_frame* mix_multiple_speakers(
 	// pointer to the spoken frames list
 	conf_frame* cf_spoken = frames_in;
 
-	// clear listener mix buffer
-	memset(conf->listenerBuffer,0,AST_CONF_BUFFER_SIZE);
+	// clear listener mix accumulator
+	memset(conf->listenerAccumulator,0,sizeof(conf->listenerAccumulator));
 
 	while (cf_spoken)
 	{
 		// copy orignal frame to converted array so spyers don't need to re-encode it
 		cf_spoken->converted[cf_spoken->member->read_format_index] = cf_spoken->fr;
 
-		if (!(cf_spoken->fr = convert_frame(cf_spoken->member->to_slinear, cf_spoken->fr, 0)))
+		if (!(cf_spoken->fr = decode_conf_frame(cf_spoken)))
 		{
 			ast_log(LOG_ERROR, "mix_multiple_speakers: unable to convert frame to slinear\n");
 			return NULL;
@@ -283,9 +657,9 @@ conf_frame* mix_multiple_speakers(
 		{
 			// add the speaker's voice
 #if	ASTERISK_SRC_VERSION == 104
-			mix_slinear_frames(conf->listenerBuffer + AST_FRIENDLY_OFFSET, cf_spoken->fr->data, AST_CONF_BLOCK_SAMPLES);
+			accumulate_slinear_frame(conf->listenerAccumulator, cf_spoken->fr->data);
 #else
-			mix_slinear_frames(conf->listenerBuffer + AST_FRIENDLY_OFFSET, cf_spoken->fr->data.ptr, AST_CONF_BLOCK_SAMPLES);
+			accumulate_slinear_frame(conf->listenerAccumulator, cf_spoken->fr->data.ptr);
 #endif
 		} 
 		else
@@ -296,6 +670,9 @@ conf_frame* mix_multiple_speakers(
 		cf_spoken = cf_spoken->next;
 	}
 
+	// saturate the listener mix
+	saturate_slinear_frame(conf->listenerBuffer + AST_FRIENDLY_OFFSET, conf->listenerAccumulator);
+
 	//
 	// create the send frame list
 	//
@@ -314,9 +691,6 @@ conf_frame* mix_multiple_speakers(
 			if (!cf_spoken->member->speakerBuffer)
 				cf_spoken->member->speakerBuffer = ast_malloc(AST_CONF_BUFFER_SIZE);
 
-			// clear speaker buffer
-			memset(cf_spoken->member->speakerBuffer,0,AST_CONF_BUFFER_SIZE);
-
 			if (!(cf_sendFrames = create_mix_frame(cf_spoken->member, cf_sendFrames, &cf_spoken->member->mixConfFrame)))
 				return NULL;
 
@@ -324,27 +698,27 @@ conf_frame* mix_multiple_speakers(
 
 			// subtract the speaker's voice
 #if	ASTERISK_SRC_VERSION == 104
-			unmix_slinear_frame(cf_sendFrames->mixed_buffer, conf->listenerBuffer + AST_FRIENDLY_OFFSET, cf_spoken->fr->data, AST_CONF_BLOCK_SAMPLES);
+			unmix_slinear_frame(cf_sendFrames->mixed_buffer, conf->listenerAccumulator, cf_spoken->fr->data);
 #else
-			unmix_slinear_frame(cf_sendFrames->mixed_buffer, conf->listenerBuffer + AST_FRIENDLY_OFFSET, cf_spoken->fr->data.ptr, AST_CONF_BLOCK_SAMPLES);
+			unmix_slinear_frame(cf_sendFrames->mixed_buffer, conf->listenerAccumulator, cf_spoken->fr->data.ptr);
 #endif
 
-			if (cf_spoken->member->spy_partner && cf_spoken->member->spy_partner->is_speaking)
+			if (cf_spoken->member->spy_partner && cf_spoken->member->spy_partner->tick->is_speaking)
 			{
 				// add whisper voice
 #if	ASTERISK_SRC_VERSION == 104
-				mix_slinear_frames(cf_sendFrames->mixed_buffer, cf_spoken->member->whisper_frame->fr->data, AST_CONF_BLOCK_SAMPLES);
+				mix_slinear_frames(cf_sendFrames->mixed_buffer, cf_spoken->member->whisper_frame->fr->data);
 #else
-				mix_slinear_frames(cf_sendFrames->mixed_buffer, cf_spoken->member->whisper_frame->fr->data.ptr, AST_CONF_BLOCK_SAMPLES);
+				mix_slinear_frames(cf_sendFrames->mixed_buffer, cf_spoken->member->whisper_frame->fr->data.ptr);
 #endif
 			}
 
 			if (!(cf_sendFrames->fr = create_slinear_frame(&cf_sendFrames->member->mixAstFrame, cf_sendFrames->mixed_buffer)))
 				return NULL;
 
-			cf_sendFrames->member->speaker_frame = cf_sendFrames;
+			cf_sendFrames->member->tick->speaker_frame = cf_sendFrames;
 		}
-		else if (!cf_spoken->member->spy_partner->is_speaking)
+		else if (!cf_spoken->member->spy_partner->tick->is_speaking)
 		{
 			// allocate/reuse a mix buffer for whisper
 			if (!cf_spoken->member->speakerBuffer)
@@ -360,15 +734,15 @@ conf_frame* mix_multiple_speakers(
 
 			// add the whisper voice
 #if	ASTERISK_SRC_VERSION == 104
-			mix_slinear_frames(cf_spoken->member->speakerBuffer + AST_FRIENDLY_OFFSET, cf_spoken->fr->data, AST_CONF_BLOCK_SAMPLES);
+			mix_slinear_frames(cf_spoken->member->speakerBuffer + AST_FRIENDLY_OFFSET, cf_spoken->fr->data);
 #else
-			mix_slinear_frames(cf_spoken->member->speakerBuffer + AST_FRIENDLY_OFFSET, cf_spoken->fr->data.ptr, AST_CONF_BLOCK_SAMPLES);
+			mix_slinear_frames(cf_spoken->member->speakerBuffer + AST_FRIENDLY_OFFSET, cf_spoken->fr->data.ptr);
 #endif
 
 			if (!(cf_sendFrames->fr = create_slinear_frame(&cf_sendFrames->member->mixAstFrame, cf_sendFrames->mixed_buffer)))
 				return NULL;
 
-			cf_sendFrames->member->speaker_frame = cf_sendFrames;
+			cf_sendFrames->member->tick->speaker_frame = cf_sendFrames;
 		}
 
 		cf_spoken = cf_spoken->next;
@@ -425,7 +799,7 @@ conf_frame* mix_multiple_speakers(
 
 			cf_sendFrames = spy_frame;
 
-			cf_sendFrames->member->speaker_frame = cf_sendFrames;
+			cf_sendFrames->member->tick->speaker_frame = cf_sendFrames;
 		}
 	}
 
@@ -456,43 +830,235 @@ conf_frame* delete_conf_frame(conf_frame* cf)
 		}
 	}
 
+	for (c = 0; c < AC_SUPPORTED_FORMATS; ++c)
+	{
+		if (cf->shared[c])
+		{
+			release_shared_frame(&cf->shared[c]->fr);
+		}
+	}
+
+	for (c = 0; c < cf->volume_frame_count; ++c)
+	{
+		release_shared_frame(&cf->volume_frames[c].shared->fr);
+	}
+
+	if (cf->copy)
+	{
+		release_shared_frame(&cf->copy->fr);
+	}
+
+	if (cf->decoded)
+	{
+		release_shared_frame(&cf->decoded->fr);
+	}
+
 	conf_frame* nf = cf->next;
 
 	if (!cf->mixed_buffer)
 	{
-#ifdef	CACHE_CONF_FRAMES
-		memset(cf,0,sizeof(conf_frame));
-		AST_LIST_INSERT_HEAD(&confFrameList, cf, frame_list);
+		slab_free(AC_CONF_FRAME_SLAB, cf);
+	}
+
+	return nf;
+}
+
+// source of shared frames
+static const char shared_frame_src[] = "konference";
+
+ast_conf_sharedframe* create_shared_frame(const struct ast_frame* fr, struct timeval delivery)
+{
+	ast_conf_sharedframe* sf;
+
+	if (fr->datalen > AST_CONF_FRAME_DATA_SIZE)
+	{
+		ast_log(LOG_ERROR, "unable to share a %d byte frame\n", fr->datalen);
+		return NULL;
+	}
+
+	if (!(sf = slab_alloc(AC_FRAME_SLAB)))
+	{
+		ast_log(LOG_ERROR, "unable to malloc shared frame\n");
+		return NULL;
+	}
+
+	// copy the frame header and data
+	sf->fr = *fr;
+	sf->fr.mallocd = 0;
+	sf->fr.src = shared_frame_src;
+	sf->fr.delivery = delivery;
+	AST_LIST_NEXT(&sf->fr, frame_list) = NULL;
+#if	ASTERISK_SRC_VERSION == 104
+	memcpy(sf->data, fr->data, fr->datalen);
+	sf->fr.data = sf->data;
 #else
-		ast_free(cf);
+	memcpy(sf->data, fr->data.ptr, fr->datalen);
+	sf->fr.data.ptr = sf->data;
 #endif
+
+	// no friendly offset, so channel drivers that prepend
+	// headers to the frame data copy the frame instead
+	sf->fr.offset = 0;
+
+	sf->refcount = 1;
+
+	return sf;
+}
+
+#ifndef	AC_USE_G722
+//
+// g.711 codecs, with asterisk's tables so they match its translators bit for bit
+//
+
+// a shared frame for the output of a codec, with the header of its input
+static ast_conf_sharedframe* create_codec_frame(const struct ast_frame* fr, int format, int datalen, struct timeval delivery)
+{
+	ast_conf_sharedframe* sf;
+
+	if (datalen > AST_CONF_FRAME_DATA_SIZE)
+	{
+		return NULL;
 	}
 
-	return nf;
+	if (!(sf = slab_alloc(AC_FRAME_SLAB)))
+	{
+		ast_log(LOG_ERROR, "unable to malloc shared frame\n");
+		return NULL;
+	}
+
+	sf->fr = *fr;
+#if	ASTERISK_SRC_VERSION == 104 || ASTERISK_SRC_VERSION == 106
+	sf->fr.subclass = format;
+#else
+	sf->fr.subclass.integer = format;
+#endif
+	sf->fr.datalen = datalen;
+	sf->fr.mallocd = 0;
+	sf->fr.src = shared_frame_src;
+	sf->fr.delivery = delivery;
+	AST_LIST_NEXT(&sf->fr, frame_list) = NULL;
+#if	ASTERISK_SRC_VERSION == 104
+	sf->fr.data = sf->data;
+#else
+	sf->fr.data.ptr = sf->data;
+#endif
+	sf->fr.offset = 0;
+
+	sf->refcount = 1;
+
+	return sf;
 }
 
-conf_frame* create_conf_frame(ast_conf_member* member, const struct ast_frame* fr)
+ast_conf_sharedframe* decode_g711_frame(const struct ast_frame* fr, int format_index)
 {
-	conf_frame* cf;
+	ast_conf_sharedframe* sf;
+	int i;
+
+	if (fr->datalen != fr->samples || !(sf = create_codec_frame(fr, AST_FORMAT_SLINEAR, fr->samples * AST_CONF_BYTES_PER_SAMPLE, fr->delivery)))
+	{
+		return NULL;
+	}
 
-#ifdef	CACHE_CONF_FRAMES
-	cf  = AST_LIST_REMOVE_HEAD(&confFrameList, frame_list);
-	if (!cf && !(cf = ast_calloc(1, sizeof(conf_frame))))
+#if	ASTERISK_SRC_VERSION == 104
+	const unsigned char* in = fr->data;
 #else
-	if (!(cf  = ast_calloc(1, sizeof(conf_frame))))
+	const unsigned char* in = fr->data.ptr;
 #endif
+	short* out = (short*)sf->data;
+
+	if (format_index == AC_ULAW_INDEX)
+	{
+		for (i = 0; i < fr->samples; ++i)
+			out[i] = AST_MULAW(in[i]);
+	}
+	else
+	{
+		for (i = 0; i < fr->samples; ++i)
+			out[i] = AST_ALAW(in[i]);
+	}
+
+	return sf;
+}
+
+ast_conf_sharedframe* encode_g711_frame(const struct ast_frame* fr, int format_index, struct timeval delivery)
+{
+	ast_conf_sharedframe* sf;
+	int i;
+
+	if (!(sf = create_codec_frame(fr, format_index == AC_ULAW_INDEX ? AST_FORMAT_ULAW : AST_FORMAT_ALAW, fr->samples, delivery)))
+	{
+		return NULL;
+	}
+
+#if	ASTERISK_SRC_VERSION == 104
+	const short* in = fr->data;
+#else
+	const short* in = fr->data.ptr;
+#endif
+	unsigned char* out = (unsigned char*)sf->data;
+
+	if (format_index == AC_ULAW_INDEX)
+	{
+		for (i = 0; i < fr->samples; ++i)
+			out[i] = AST_LIN2MU(in[i]);
+	}
+	else
+	{
+		for (i = 0; i < fr->samples; ++i)
+			out[i] = AST_LIN2A(in[i]);
+	}
+
+	return sf;
+}
+#endif
+
+void release_shared_frame(struct ast_frame* fr)
+{
+	ast_conf_sharedframe* sf = (ast_conf_sharedframe*)fr;
+
+	if (ast_atomic_dec_and_test(&sf->refcount))
+	{
+		slab_free(AC_FRAME_SLAB, sf);
+	}
+}
+
+int is_shared_frame(const struct ast_frame* fr)
+{
+	return fr->src == shared_frame_src;
+}
+
+conf_frame* create_conf_frame(ast_conf_member* member, const struct ast_frame* fr)
+{
+	conf_frame* cf;
+
+	if (!(cf = slab_alloc(AC_CONF_FRAME_SLAB)))
 	{
 		ast_log(LOG_ERROR, "unable to allocate memory for conf frame\n");
 		return NULL;
 	}
 
+	memset(cf,0,sizeof(conf_frame));
+
 	cf->member = member;
 
 	if (fr)
 	{
-		if (!(cf->fr = ast_frdup((struct ast_frame*)(fr))))
+		// copy the frame into a slab object unless it's too large
+		if (fr->datalen <= AST_CONF_FRAME_DATA_SIZE)
+		{
+			if ((cf->copy = create_shared_frame(fr, fr->delivery)))
+			{
+				cf->fr = &cf->copy->fr;
+			}
+		}
+		else
+		{
+			cf->fr = ast_frdup((struct ast_frame*)(fr));
+		}
+
+		if (!cf->fr)
 		{
-			ast_free(cf);
+			slab_free(AC_CONF_FRAME_SLAB, cf);
 			ast_log(LOG_ERROR, "unable to allocate memory for conf frame\n");
 			return NULL;
 		}
@@ -32,18 +32,35 @@
 //
 
 // mixing
+void init_mix_kernels(void);
+extern void (*mix_slinear_frames)(char *dst, const char *src);
 conf_frame* mix_frames(ast_conference* conf, conf_frame* frames_in, int speaker_count, int listener_count);
 conf_frame* mix_multiple_speakers(ast_conference* conf, conf_frame* frames_in, int speakers, int listeners);
 conf_frame* mix_single_speaker(ast_conference* conf, conf_frame* frames_in);
+conf_frame* mix_sounds(ast_conference* conf, conf_frame* send_frames);
 
 // frame creation and deletion
 conf_frame* create_conf_frame(ast_conf_member* member, const struct ast_frame* fr);
 conf_frame* create_mix_frame(ast_conf_member* member, conf_frame* next, conf_frame** cf);
 conf_frame* delete_conf_frame(conf_frame* cf);
 
+// shared frame creation and release
+ast_conf_sharedframe* create_shared_frame(const struct ast_frame* fr, struct timeval delivery);
+void release_shared_frame(struct ast_frame* fr);
+int is_shared_frame(const struct ast_frame* fr);
+
 // convert frame function
 struct ast_frame* convert_frame(struct ast_trans_pvt* trans, struct ast_frame* fr, int consume);
 
+// convert a slinear frame to a write format in a new shared frame
+ast_conf_sharedframe* encode_frame(int format_index, struct ast_trans_pvt* trans, struct ast_frame* fr, struct timeval delivery);
+
+#ifndef	AC_USE_G722
+// g.711 codecs ( ulaw and alaw format indexes ) writing to new shared frames
+ast_conf_sharedframe* decode_g711_frame(const struct ast_frame* fr, int format_index);
+ast_conf_sharedframe* encode_g711_frame(const struct ast_frame* fr, int format_index, struct timeval delivery);
+#endif
+
 // slinear frame function
 struct ast_frame* create_slinear_frame(struct ast_frame** fr, char* data);
 
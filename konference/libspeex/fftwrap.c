@@ -0,0 +1,124 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <pthread.h>
+#include "misc.h"
+#include "smallft.h"
+#include "vecfft.h"
+#include "fftwrap.h"
+
+/* vecfft lookups are read only, one per size is shared by every preprocessor */
+struct shared_vecfft {
+   struct vecfft_lookup lookup;
+   int refs;
+   struct shared_vecfft *next;
+};
+
+static struct shared_vecfft *shared_vecffts;
+static pthread_mutex_t shared_vecffts_lock = PTHREAD_MUTEX_INITIALIZER;
+
+struct fft_table {
+   struct shared_vecfft *vec;    /* else smallft, which works in its lookup */
+   struct drft_lookup drft;
+};
+
+#ifndef USE_SMALLFT
+static struct shared_vecfft *shared_vecfft_get(int size)
+{
+   struct shared_vecfft *v;
+
+   pthread_mutex_lock(&shared_vecffts_lock);
+
+   for (v = shared_vecffts; v && v->lookup.n != size; v = v->next)
+      ;
+
+   if (!v)
+   {
+      v = (struct shared_vecfft*)speex_alloc(sizeof(struct shared_vecfft));
+      if (vecfft_init(&v->lookup, size))
+      {
+         speex_free(v);
+         pthread_mutex_unlock(&shared_vecffts_lock);
+         return 0;
+      }
+      v->next = shared_vecffts;
+      shared_vecffts = v;
+   }
+   v->refs++;
+
+   pthread_mutex_unlock(&shared_vecffts_lock);
+
+   return v;
+}
+#endif
+
+static void shared_vecfft_put(struct shared_vecfft *v)
+{
+   struct shared_vecfft **p;
+
+   pthread_mutex_lock(&shared_vecffts_lock);
+
+   if (!--v->refs)
+   {
+      for (p = &shared_vecffts; *p != v; p = &(*p)->next)
+         ;
+      *p = v->next;
+
+      vecfft_clear(&v->lookup);
+      speex_free(v);
+   }
+
+   pthread_mutex_unlock(&shared_vecffts_lock);
+}
+
+void *spx_fft_init(int size)
+{
+   struct fft_table *table = (struct fft_table*)speex_alloc(sizeof(struct fft_table));
+
+#ifndef USE_SMALLFT
+   if ((table->vec = shared_vecfft_get(size)))
+      return table;
+#endif
+   drft_init(&table->drft, size);
+   return table;
+}
+
+void spx_fft_destroy(void *table)
+{
+   struct fft_table *t = (struct fft_table*)table;
+
+   if (t->vec)
+      shared_vecfft_put(t->vec);
+   else
+      drft_clear(&t->drft);
+   speex_free(t);
+}
+
+void spx_fft(void *table, float *data)
+{
+   struct fft_table *t = (struct fft_table*)table;
+
+   if (t->vec)
+      vecfft_forward(&t->vec->lookup, data);
+   else
+      drft_forward(&t->drft, data);
+}
+
+void spx_ifft(void *table, float *data)
+{
+   struct fft_table *t = (struct fft_table*)table;
+
+   if (t->vec)
+      vecfft_backward(&t->vec->lookup, data);
+   else
+      drft_backward(&t->drft, data);
+}
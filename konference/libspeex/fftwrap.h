@@ -0,0 +1,37 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * fft backend of the preprocessor
+ *
+ * the vector fft ( vecfft.c ), with one lookup shared per size, is used for
+ * the sizes it supports and smallft for the others, or for all sizes when
+ * built with USE_SMALLFT. both take and return smallft's half complex
+ * layout, in place and unscaled
+ */
+
+#ifndef FFTWRAP_H
+#define FFTWRAP_H
+
+/** Create a table for n point real transforms */
+void *spx_fft_init(int size);
+
+/** Destroy a table */
+void spx_fft_destroy(void *table);
+
+/** Forward transform, in place */
+void spx_fft(void *table, float *data);
+
+/** Backward transform, in place, scaled by n */
+void spx_ifft(void *table, float *data);
+
+#endif
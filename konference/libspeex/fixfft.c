@@ -0,0 +1,415 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * vecfft.c's Stockham passes and real split on 32 bit lanes. Twiddles and
+ * butterfly constants are Q15 ( 1 is 32768, lanes are 32 bits wide ) and
+ * products are taken with vmulq15(), which needs the other factor below
+ * 2^30 in magnitude: the passes never grow values past four times the
+ * absolute sum of the input, which the callers keep below 2^28.
+ */
+
+#include <math.h>
+#include "misc.h"
+#include "vecmath.h"
+#include "fixfft.h"
+
+#define Q15(x) ((int)floor((x) * 32768. + .5))
+
+#define SIN_60 Q15(0.866025403784438647)
+#define COS_72 Q15(0.309016994374947424)
+#define SIN_72 Q15(0.951056516295153572)
+#define COS_144 Q15(-0.809016994374947424)
+#define SIN_144 Q15(0.587785252292473129)
+
+static inline v4si vset1i(int a)
+{
+   return (v4si){a, a, a, a};
+}
+
+/* Multiply outputs 1 to r-1 of four butterflies by their twiddles */
+static inline void twiddle(v4si *br, v4si *bi, int r, const int *tw, int h, int idx)
+{
+   int j;
+
+   for (j = 1; j < r; j++)
+   {
+      v4si wr = vloadi(tw + (2 * j - 2) * h + idx);
+      v4si wi = vloadi(tw + (2 * j - 1) * h + idx);
+      v4si t = vmulq15(wr, br[j]) - vmulq15(wi, bi[j]);
+
+      bi[j] = vmulq15(wi, br[j]) + vmulq15(wr, bi[j]);
+      br[j] = t;
+   }
+}
+
+/* Store the outputs of four butterflies, as vecfft's store() */
+static inline void store(int *yr, int *yi, const v4si *br, const v4si *bi, int r, int s, int idx, int base)
+{
+   int j, l;
+
+   if (!(s % VLEN))
+   {
+      for (j = 0; j < r; j++)
+      {
+         vstorei(yr + base + s * j, br[j]);
+         vstorei(yi + base + s * j, bi[j]);
+      }
+   } else if (s == 1 && r == 4)
+   {
+      for (l = 0; l < VLEN; l++)
+      {
+         vstorei(yr + 4 * (idx + l), (v4si){br[0][l], br[1][l], br[2][l], br[3][l]});
+         vstorei(yi + 4 * (idx + l), (v4si){bi[0][l], bi[1][l], bi[2][l], bi[3][l]});
+      }
+   } else {
+      for (l = 0; l < VLEN; l++)
+      {
+         base = (idx + l) % s + r * (idx + l - (idx + l) % s);
+
+         for (j = 0; j < r; j++)
+         {
+            yr[base + s * j] = br[j][l];
+            yi[base + s * j] = bi[j][l];
+         }
+      }
+   }
+}
+
+static inline void advance(int *q, int *base, int r, int s)
+{
+   *q += VLEN;
+   *base += VLEN;
+   if (*q >= s)
+   {
+      *q = 0;
+      *base += (r - 1) * s;
+   }
+}
+
+static void pass2(int m, int s, const int *tw, const int *xr, const int *xi, int *yr, int *yi)
+{
+   int h = m / 2, idx, q = 0, base = 0;
+
+   for (idx = 0; idx < h; idx += VLEN)
+   {
+      v4si a0r = vloadi(xr + idx), a0i = vloadi(xi + idx);
+      v4si a1r = vloadi(xr + idx + h), a1i = vloadi(xi + idx + h);
+      v4si br[2], bi[2];
+
+      br[0] = a0r + a1r;
+      bi[0] = a0i + a1i;
+      br[1] = a0r - a1r;
+      bi[1] = a0i - a1i;
+
+      if (tw)
+         twiddle(br, bi, 2, tw, h, idx);
+      store(yr, yi, br, bi, 2, s, idx, base);
+      advance(&q, &base, 2, s);
+   }
+}
+
+static void pass3(int m, int s, const int *tw, const int *xr, const int *xi, int *yr, int *yi)
+{
+   int h = m / 3, idx, q = 0, base = 0;
+   v4si sin60 = vset1i(SIN_60);
+
+   for (idx = 0; idx < h; idx += VLEN)
+   {
+      v4si a0r = vloadi(xr + idx), a0i = vloadi(xi + idx);
+      v4si a1r = vloadi(xr + idx + h), a1i = vloadi(xi + idx + h);
+      v4si a2r = vloadi(xr + idx + 2 * h), a2i = vloadi(xi + idx + 2 * h);
+      v4si br[3], bi[3];
+
+      v4si tr = a1r + a2r, ti = a1i + a2i;
+      v4si mr = a0r - (tr >> 1), mi = a0i - (ti >> 1);
+      v4si nr = vmulq15(sin60, a1r - a2r), ni = vmulq15(sin60, a1i - a2i);
+
+      br[0] = a0r + tr;
+      bi[0] = a0i + ti;
+      br[1] = mr + ni;
+      bi[1] = mi - nr;
+      br[2] = mr - ni;
+      bi[2] = mi + nr;
+
+      if (tw)
+         twiddle(br, bi, 3, tw, h, idx);
+      store(yr, yi, br, bi, 3, s, idx, base);
+      advance(&q, &base, 3, s);
+   }
+}
+
+static void pass4(int m, int s, const int *tw, const int *xr, const int *xi, int *yr, int *yi)
+{
+   int h = m / 4, idx, q = 0, base = 0;
+
+   for (idx = 0; idx < h; idx += VLEN)
+   {
+      v4si a0r = vloadi(xr + idx), a0i = vloadi(xi + idx);
+      v4si a1r = vloadi(xr + idx + h), a1i = vloadi(xi + idx + h);
+      v4si a2r = vloadi(xr + idx + 2 * h), a2i = vloadi(xi + idx + 2 * h);
+      v4si a3r = vloadi(xr + idx + 3 * h), a3i = vloadi(xi + idx + 3 * h);
+      v4si br[4], bi[4];
+
+      v4si t0r = a0r + a2r, t0i = a0i + a2i;
+      v4si t1r = a0r - a2r, t1i = a0i - a2i;
+      v4si t2r = a1r + a3r, t2i = a1i + a3i;
+      v4si t3r = a1r - a3r, t3i = a1i - a3i;
+
+      br[0] = t0r + t2r;
+      bi[0] = t0i + t2i;
+      br[1] = t1r + t3i;
+      bi[1] = t1i - t3r;
+      br[2] = t0r - t2r;
+      bi[2] = t0i - t2i;
+      br[3] = t1r - t3i;
+      bi[3] = t1i + t3r;
+
+      if (tw)
+         twiddle(br, bi, 4, tw, h, idx);
+      store(yr, yi, br, bi, 4, s, idx, base);
+      advance(&q, &base, 4, s);
+   }
+}
+
+static void pass5(int m, int s, const int *tw, const int *xr, const int *xi, int *yr, int *yi)
+{
+   int h = m / 5, idx, q = 0, base = 0;
+   v4si cos72 = vset1i(COS_72), sin72 = vset1i(SIN_72);
+   v4si cos144 = vset1i(COS_144), sin144 = vset1i(SIN_144);
+
+   for (idx = 0; idx < h; idx += VLEN)
+   {
+      v4si a0r = vloadi(xr + idx), a0i = vloadi(xi + idx);
+      v4si a1r = vloadi(xr + idx + h), a1i = vloadi(xi + idx + h);
+      v4si a2r = vloadi(xr + idx + 2 * h), a2i = vloadi(xi + idx + 2 * h);
+      v4si a3r = vloadi(xr + idx + 3 * h), a3i = vloadi(xi + idx + 3 * h);
+      v4si a4r = vloadi(xr + idx + 4 * h), a4i = vloadi(xi + idx + 4 * h);
+      v4si br[5], bi[5];
+
+      v4si t1r = a1r + a4r, t1i = a1i + a4i;
+      v4si t2r = a2r + a3r, t2i = a2i + a3i;
+      v4si t3r = a1r - a4r, t3i = a1i - a4i;
+      v4si t4r = a2r - a3r, t4i = a2i - a3i;
+
+      v4si m1r = a0r + vmulq15(cos72, t1r) + vmulq15(cos144, t2r), m1i = a0i + vmulq15(cos72, t1i) + vmulq15(cos144, t2i);
+      v4si m2r = a0r + vmulq15(cos144, t1r) + vmulq15(cos72, t2r), m2i = a0i + vmulq15(cos144, t1i) + vmulq15(cos72, t2i);
+      v4si n1r = vmulq15(sin72, t3r) + vmulq15(sin144, t4r), n1i = vmulq15(sin72, t3i) + vmulq15(sin144, t4i);
+      v4si n2r = vmulq15(sin144, t3r) - vmulq15(sin72, t4r), n2i = vmulq15(sin144, t3i) - vmulq15(sin72, t4i);
+
+      br[0] = a0r + t1r + t2r;
+      bi[0] = a0i + t1i + t2i;
+      br[1] = m1r + n1i;
+      bi[1] = m1i - n1r;
+      br[4] = m1r - n1i;
+      bi[4] = m1i + n1r;
+      br[2] = m2r + n2i;
+      bi[2] = m2i - n2r;
+      br[3] = m2r - n2i;
+      bi[3] = m2i + n2r;
+
+      if (tw)
+         twiddle(br, bi, 5, tw, h, idx);
+      store(yr, yi, br, bi, 5, s, idx, base);
+      advance(&q, &base, 5, s);
+   }
+}
+
+/* Forward complex transform of x, returns the buffer holding the result ( x or y ) */
+static int *complex_forward(const struct fixfft_lookup *l, int *xr, int *xi, int *yr, int *yi)
+{
+   int m = l->m, s = 1, i;
+
+   for (i = 0; i < l->nstages; i++)
+   {
+      int *t;
+
+      switch (l->radix[i])
+      {
+      case 2:
+         pass2(m, s, l->twiddle[i], xr, xi, yr, yi);
+         break;
+      case 3:
+         pass3(m, s, l->twiddle[i], xr, xi, yr, yi);
+         break;
+      case 4:
+         pass4(m, s, l->twiddle[i], xr, xi, yr, yi);
+         break;
+      default:
+         pass5(m, s, l->twiddle[i], xr, xi, yr, yi);
+         break;
+      }
+      s *= l->radix[i];
+
+      t = xr; xr = yr; yr = t;
+      t = xi; xi = yi; yi = t;
+   }
+
+   return xr;
+}
+
+int fixfft_init(struct fixfft_lookup *l, int n)
+{
+   static const int radices[] = {4, 2, 3, 5};
+   int m = n / 2, rest = m, s = 1, i, j, k;
+
+   l->n = n;
+   l->m = m;
+   l->nstages = 0;
+   l->post = 0;
+
+   if (n <= 0 || n % 2 || n > FIXFFT_MAX_SIZE)
+      return -1;
+
+   for (i = 0; i < 4; i++)
+   {
+      while (rest % radices[i] == 0 && (m / radices[i]) % VLEN == 0 && l->nstages < FIXFFT_MAX_STAGES)
+      {
+         l->radix[l->nstages++] = radices[i];
+         rest /= radices[i];
+      }
+   }
+   if (rest != 1)
+   {
+      l->nstages = 0;
+      return -1;
+   }
+
+   for (i = 0; i < l->nstages; i++)
+   {
+      int r = l->radix[i], h = m / r, len = m / s;
+
+      if (s * r == m)
+      {
+         l->twiddle[i] = 0;
+         break;
+      }
+
+      l->twiddle[i] = (int*)speex_alloc(2 * (r - 1) * h * sizeof(int));
+      for (j = 1; j < r; j++)
+      {
+         for (k = 0; k < h; k++)
+         {
+            double a = -2 * M_PI * j * (k / s) / len;
+            l->twiddle[i][(2 * j - 2) * h + k] = Q15(cos(a));
+            l->twiddle[i][(2 * j - 1) * h + k] = Q15(sin(a));
+         }
+      }
+      s *= r;
+   }
+
+   l->post = (int*)speex_alloc(2 * m * sizeof(int));
+   for (k = 0; k < m; k++)
+   {
+      l->post[k] = Q15(cos(2 * M_PI * k / n));
+      l->post[m + k] = Q15(sin(2 * M_PI * k / n));
+   }
+
+   return 0;
+}
+
+void fixfft_clear(struct fixfft_lookup *l)
+{
+   int i;
+
+   for (i = 0; i < l->nstages; i++)
+      if (l->twiddle[i])
+         speex_free(l->twiddle[i]);
+   if (l->post)
+      speex_free(l->post);
+}
+
+void fixfft_forward(const struct fixfft_lookup *l, int *data)
+{
+   int m = l->m, k;
+   const int *cs = l->post, *sn = l->post + m;
+   int work[4 * m], *zr, *zi;
+
+   for (k = 0; k < m; k += VLEN)
+   {
+      v4si even, odd;
+
+      vloadi_interleaved(data + 2 * k, &even, &odd);
+      vstorei(work + k, even);
+      vstorei(work + m + k, odd);
+   }
+
+   zr = complex_forward(l, work, work + m, work + 2 * m, work + 3 * m);
+   zi = zr + m;
+
+   /* the split of vecfft_forward(), with the halving folded into the sums */
+   data[0] = zr[0] + zi[0];
+   data[l->n - 1] = zr[0] - zi[0];
+
+   for (k = 1; k + VLEN <= m; k += VLEN)
+   {
+      v4si ar = vloadi(zr + k), ai = vloadi(zi + k);
+      v4si br = vreversei(vloadi(zr + m - k - 3)), bi = vreversei(vloadi(zi + m - k - 3));
+      v4si c = vloadi(cs + k), s = vloadi(sn + k);
+      v4si er = (ar + br) >> 1, ei = (ai - bi) >> 1;
+      v4si odr = (ai + bi) >> 1, odi = (br - ar) >> 1;
+
+      vstorei_interleaved(data + 2 * k - 1, er + vmulq15(c, odr) + vmulq15(s, odi), ei + vmulq15(c, odi) - vmulq15(s, odr));
+   }
+   for (; k < m; k++)
+   {
+      int er = (zr[k] + zr[m - k]) >> 1, ei = (zi[k] - zi[m - k]) >> 1;
+      int odr = (zi[k] + zi[m - k]) >> 1, odi = (zr[m - k] - zr[k]) >> 1;
+      v4si t = vmulq15((v4si){cs[k], sn[k], cs[k], sn[k]}, (v4si){odr, odi, odi, odr});
+
+      data[2 * k - 1] = er + t[0] + t[1];
+      data[2 * k] = ei + t[2] - t[3];
+   }
+}
+
+void fixfft_backward(const struct fixfft_lookup *l, int *data)
+{
+   int m = l->m, k;
+   const int *cs = l->post, *sn = l->post + m;
+   int work[4 * m], *ur = work, *ui = work + m, *w;
+
+   ui[0] = data[0] + data[l->n - 1];
+   ur[0] = data[0] - data[l->n - 1];
+
+   for (k = 1; k + VLEN <= m; k += VLEN)
+   {
+      v4si ar, ai, br, bi, dr, di, tr, ti;
+      v4si c = vloadi(cs + k), s = vloadi(sn + k);
+
+      vloadi_interleaved(data + 2 * k - 1, &ar, &ai);
+      vloadi_interleaved(data + 2 * (m - k - 3) - 1, &br, &bi);
+      br = vreversei(br);
+      bi = -vreversei(bi);
+
+      dr = ar - br;
+      di = ai - bi;
+      tr = vmulq15(c, dr) - vmulq15(s, di);
+      ti = vmulq15(c, di) + vmulq15(s, dr);
+
+      vstorei(ui + k, ar + br - ti);
+      vstorei(ur + k, ai + bi + tr);
+   }
+   for (; k < m; k++)
+   {
+      int ar = data[2 * k - 1], ai = data[2 * k];
+      int br = data[2 * (m - k) - 1], bi = -data[2 * (m - k)];
+      v4si t = vmulq15((v4si){cs[k], sn[k], cs[k], sn[k]}, (v4si){ai - bi, ar - br, ar - br, ai - bi});
+
+      ui[k] = ar + br - (t[0] + t[1]);
+      ur[k] = ai + bi + (t[2] - t[3]);
+   }
+
+   w = complex_forward(l, ur, ui, work + 2 * m, work + 3 * m);
+
+   for (k = 0; k < m; k += VLEN)
+      vstorei_interleaved(data + 2 * k, vloadi(w + m + k), vloadi(w + k));
+}
@@ -0,0 +1,44 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * fixed point real fft on four lane integer vectors, for the fixed point
+ * preprocessor
+ *
+ * the same transform as vecfft.c on 32 bit integers with Q15 twiddles,
+ * in smallft's half complex layout and unscaled. the forward transform
+ * takes samples of up to 16 bits, the backward one values whose absolute
+ * sum is below 2^28 ( it returns n times the samples )
+ */
+
+#ifndef FIXFFT_H
+#define FIXFFT_H
+
+#define FIXFFT_MAX_STAGES 16
+#define FIXFFT_MAX_SIZE 2048
+
+struct fixfft_lookup {
+   int n;                                /* real size */
+   int m;                                /* complex size ( n/2 ) */
+   int nstages;
+   int radix[FIXFFT_MAX_STAGES];
+   int *twiddle[FIXFFT_MAX_STAGES];      /* stage twiddles in Q15, laid out as vecfft's */
+   int *post;                            /* cos and sin of the real split in Q15, per bin */
+};
+
+/* 0 on success, -1 for the sizes vecfft_init() refuses */
+extern int fixfft_init(struct fixfft_lookup *l, int n);
+extern void fixfft_forward(const struct fixfft_lookup *l, int *data);
+extern void fixfft_backward(const struct fixfft_lookup *l, int *data);
+extern void fixfft_clear(struct fixfft_lookup *l);
+
+#endif
@@ -34,7 +34,9 @@
 #include <math.h>
 #include "speex_preprocess.h"
 #include "misc.h"
-#include "smallft.h"
+#include "fftwrap.h"
+#include "preprocess_fx.h"
+#include "vecmath.h"
 
 #define max(a,b) ((a) > (b) ? (a) : (b))
 #define min(a,b) ((a) < (b) ? (a) : (b))
@@ -96,14 +98,15 @@ static void conj_window(float *w, int len)
    which multiplied by xi/(1+xi) is the optimal gain
    in the loudness domain ( sqrt[amplitude] )
 */
-static float hypergeom_gain(float x)
+static const float hypergeom_table[21] = {
+   0.82157, 1.02017, 1.20461, 1.37534, 1.53363, 1.68092, 1.81865, 
+   1.94811, 2.07038, 2.18638, 2.29688, 2.40255, 2.50391, 2.60144, 
+   2.69551, 2.78647, 2.87458, 2.96015, 3.04333, 3.12431, 3.20326};
+
+float hypergeom_gain(float x)
 {
    int ind;
    float integer, frac;
-   static float table[21] = {
-      0.82157, 1.02017, 1.20461, 1.37534, 1.53363, 1.68092, 1.81865, 
-      1.94811, 2.07038, 2.18638, 2.29688, 2.40255, 2.50391, 2.60144, 
-      2.69551, 2.78647, 2.87458, 2.96015, 3.04333, 3.12431, 3.20326};
    
    if (x>9.5)
       return 1+.12/x;
@@ -112,14 +115,59 @@ static float hypergeom_gain(float x)
    frac = x-integer;
    ind = (int)integer;
    
-   return ((1-frac)*table[ind] + frac*table[ind+1])/sqrt(x+.0001);
+   return ((1-frac)*hypergeom_table[ind] + frac*hypergeom_table[ind+1])/sqrt(x+.0001);
 }
 
-SpeexPreprocessState *speex_preprocess_state_init(int frame_size, int sampling_rate)
+/* hypergeom_gain() of four non negative values */
+static inline v4sf hypergeom_gain4(v4sf x)
+{
+   v4sf xc = vmin(x, vset1(9.5f));
+   v4si ind = vfloori(xc);
+   v4sf frac = xc - (v4sf){(float)ind[0], (float)ind[1], (float)ind[2], (float)ind[3]};
+   v4sf t0 = {hypergeom_table[ind[0]], hypergeom_table[ind[1]], hypergeom_table[ind[2]], hypergeom_table[ind[3]]};
+   v4sf t1 = {hypergeom_table[ind[0]+1], hypergeom_table[ind[1]+1], hypergeom_table[ind[2]+1], hypergeom_table[ind[3]+1]};
+
+   return vselect(x > 9.5f, 1.f + .12f / vmax(x, vset1(9.5f)), ((1.f-frac)*t0 + frac*t1) / vsqrt(x + .0001f));
+}
+
+/* Analysis/synthesis window of 2*N points */
+void preprocess_window(float *window, int N, int frame_size)
+{
+   int i;
+   int N3 = 2*N - frame_size;
+   int N4 = frame_size - N3;
+
+   conj_window(window, 2*N3);
+   for (i=2*N3;i<2*N;i++)
+      window[i]=1;
+   
+   if (N4>0)
+   {
+      for (i=N3-1;i>=0;i--)
+      {
+         window[i+N3+N4]=window[i+N3];
+         window[i+N3]=1;
+      }
+   }
+}
+
+void preprocess_loudness_weight(float *loudness_weight, int N, int sampling_rate)
 {
    int i;
-   int N, N3, N4;
 
+   for (i=0;i<N;i++)
+   {
+      float ff=((float)i)*.5*sampling_rate/((float)N);
+      loudness_weight[i] = .35-.35*ff/16000+.73*exp(-.5*(ff-3800)*(ff-3800)/9e5);
+      if (loudness_weight[i]<.01)
+         loudness_weight[i]=.01;
+      loudness_weight[i] *= loudness_weight[i];
+   }
+}
+
+/* Parameters, per frame decisions and sizes, which fixed point states share */
+static SpeexPreprocessState *preprocess_state_alloc(int frame_size, int sampling_rate)
+{
    SpeexPreprocessState *st = (SpeexPreprocessState *)speex_alloc(sizeof(SpeexPreprocessState));
    st->frame_size = frame_size;
 
@@ -145,10 +193,6 @@ SpeexPreprocessState *speex_preprocess_state_init(int frame_size, int sampling_r
    st->ps_size = st->frame_size;
 #endif
 
-   N = st->ps_size;
-   N3 = 2*N - st->frame_size;
-   N4 = st->frame_size - N3;
-   
    st->sampling_rate = sampling_rate;
    st->denoise_enabled = 1;
    st->agc_enabled = 0;
@@ -157,7 +201,48 @@ SpeexPreprocessState *speex_preprocess_state_init(int frame_size, int sampling_r
 
    st->speech_prob_start = SPEEX_PROB_START ;
    st->speech_prob_continue = SPEEX_PROB_CONTINUE ;
-   
+
+   st->Zpeak = 0;
+   st->Zlast = 0;
+
+   st->noise_bands = (float*)speex_alloc(NB_BANDS*sizeof(float));
+   st->noise_bands2 = (float*)speex_alloc(NB_BANDS*sizeof(float));
+   st->speech_bands = (float*)speex_alloc(NB_BANDS*sizeof(float));
+   st->speech_bands2 = (float*)speex_alloc(NB_BANDS*sizeof(float));
+   st->noise_bandsN = st->speech_bandsN = 1;
+
+   st->speech_prob = 0;
+   st->last_speech = 1000;
+   st->loudness = pow(6000,LOUDNESS_EXP);
+   st->loudness2 = 6000;
+   st->nb_loudness_adapt = 0;
+
+   st->nb_adapt=0;
+   st->consec_noise=0;
+   st->nb_preprocess=0;
+   return st;
+}
+
+static void preprocess_state_free(SpeexPreprocessState *st)
+{
+   speex_free(st->noise_bands);
+   speex_free(st->noise_bands2);
+   speex_free(st->speech_bands);
+   speex_free(st->speech_bands2);
+
+   speex_free(st);
+}
+
+SpeexPreprocessState *speex_preprocess_state_init(int frame_size, int sampling_rate)
+{
+   int i;
+   int N, N3;
+
+   SpeexPreprocessState *st = preprocess_state_alloc(frame_size, sampling_rate);
+
+   N = st->ps_size;
+   N3 = 2*N - st->frame_size;
+
    st->frame = (float*)speex_alloc(2*N*sizeof(float));
    st->ps = (float*)speex_alloc(N*sizeof(float));
    st->gain2 = (float*)speex_alloc(N*sizeof(float));
@@ -178,27 +263,8 @@ SpeexPreprocessState *speex_preprocess_state_init(int frame_size, int sampling_r
    st->update_prob = (float*)speex_alloc(N*sizeof(float));
 
    st->zeta = (float*)speex_alloc(N*sizeof(float));
-   st->Zpeak = 0;
-   st->Zlast = 0;
-
-   st->noise_bands = (float*)speex_alloc(NB_BANDS*sizeof(float));
-   st->noise_bands2 = (float*)speex_alloc(NB_BANDS*sizeof(float));
-   st->speech_bands = (float*)speex_alloc(NB_BANDS*sizeof(float));
-   st->speech_bands2 = (float*)speex_alloc(NB_BANDS*sizeof(float));
-   st->noise_bandsN = st->speech_bandsN = 1;
 
-   conj_window(st->window, 2*N3);
-   for (i=2*N3;i<2*st->ps_size;i++)
-      st->window[i]=1;
-   
-   if (N4>0)
-   {
-      for (i=N3-1;i>=0;i--)
-      {
-         st->window[i+N3+N4]=st->window[i+N3];
-         st->window[i+N3]=1;
-      }
-   }
+   preprocess_window(st->window, N, st->frame_size);
    for (i=0;i<N;i++)
    {
       st->noise[i]=1e4;
@@ -214,32 +280,34 @@ SpeexPreprocessState *speex_preprocess_state_init(int frame_size, int sampling_r
       st->outbuf[i]=0;
    }
 
-   for (i=0;i<N;i++)
-   {
-      float ff=((float)i)*.5*sampling_rate/((float)N);
-      st->loudness_weight[i] = .35-.35*ff/16000+.73*exp(-.5*(ff-3800)*(ff-3800)/9e5);
-      if (st->loudness_weight[i]<.01)
-         st->loudness_weight[i]=.01;
-      st->loudness_weight[i] *= st->loudness_weight[i];
-   }
+   preprocess_loudness_weight(st->loudness_weight, N, sampling_rate);
 
-   st->speech_prob = 0;
-   st->last_speech = 1000;
-   st->loudness = pow(6000,LOUDNESS_EXP);
-   st->loudness2 = 6000;
-   st->nb_loudness_adapt = 0;
+   st->fft_lookup = spx_fft_init(2*N);
 
-   st->fft_lookup = (struct drft_lookup*)speex_alloc(sizeof(struct drft_lookup));
-   drft_init(st->fft_lookup,2*N);
+   return st;
+}
 
-   st->nb_adapt=0;
-   st->consec_noise=0;
-   st->nb_preprocess=0;
+SpeexPreprocessState *speex_preprocess_state_init_fixed(int frame_size, int sampling_rate)
+{
+   SpeexPreprocessState *st = preprocess_state_alloc(frame_size, sampling_rate);
+
+   if (!(st->fixed = preprocess_fx_init(st)))
+   {
+      preprocess_state_free(st);
+      return 0;
+   }
    return st;
 }
 
 void speex_preprocess_state_destroy(SpeexPreprocessState *st)
 {
+   if (st->fixed)
+   {
+      preprocess_fx_destroy(st->fixed);
+      preprocess_state_free(st);
+      return;
+   }
+
    speex_free(st->frame);
    speex_free(st->ps);
    speex_free(st->gain2);
@@ -258,18 +326,12 @@ void speex_preprocess_state_destroy(SpeexPreprocessState *st)
    speex_free(st->update_prob);
    speex_free(st->zeta);
 
-   speex_free(st->noise_bands);
-   speex_free(st->noise_bands2);
-   speex_free(st->speech_bands);
-   speex_free(st->speech_bands2);
-
    speex_free(st->inbuf);
    speex_free(st->outbuf);
 
-   drft_clear(st->fft_lookup);
-   speex_free(st->fft_lookup);
+   spx_fft_destroy(st->fft_lookup);
 
-   speex_free(st);
+   preprocess_state_free(st);
 }
 
 static void update_noise(SpeexPreprocessState *st, float *ps, float *echo)
@@ -297,33 +359,40 @@ static void update_noise(SpeexPreprocessState *st, float *ps, float *echo)
 
 static int speex_compute_vad(SpeexPreprocessState *st, float *ps, float mean_prior, float mean_post)
 {
-   int i, is_speech=0;
+   int i, j;
    int N = st->ps_size;
    float scale=.5/N;
+   float bands[NB_BANDS];
+   float tot_loudness=0;
 
-   /* FIXME: Clean this up a bit */
+   for (i=5;i<N-10;i++)
    {
-      float bands[NB_BANDS];
-      int j;
-      float p0, p1;
-      float tot_loudness=0;
-      float x = sqrt(mean_post);
+      tot_loudness += scale*st->ps[i] * st->loudness_weight[i];
+   }
 
-      for (i=5;i<N-10;i++)
+   for (i=0;i<NB_BANDS;i++)
+   {
+      bands[i]=1e4;
+      for (j=i*N/NB_BANDS;j<(i+1)*N/NB_BANDS;j++)
       {
-         tot_loudness += scale*st->ps[i] * st->loudness_weight[i];
+         bands[i] += ps[j];
       }
+      bands[i]=log(bands[i]);
+   }
+
+   return preprocess_vad_decision(st, bands, tot_loudness, mean_post);
+}
+
+/* Speech decision of a frame from its log band energies, loudness and mean a posteriori SNR */
+int preprocess_vad_decision(SpeexPreprocessState *st, const float *bands, float tot_loudness, float mean_post)
+{
+   int i, is_speech=0;
+
+   /* FIXME: Clean this up a bit */
+   {
+      float p0, p1;
+      float x = sqrt(mean_post);
 
-      for (i=0;i<NB_BANDS;i++)
-      {
-         bands[i]=1e4;
-         for (j=i*N/NB_BANDS;j<(i+1)*N/NB_BANDS;j++)
-         {
-            bands[i] += ps[j];
-         }
-         bands[i]=log(bands[i]);
-      }
-      
       /*p1 = .0005+.6*exp(-.5*(x-.4)*(x-.4)*11)+.1*exp(-1.2*x);
       if (x<1.5)
          p0=.1*exp(2*(x-1.5));
@@ -507,6 +576,7 @@ static void speex_compute_agc(SpeexPreprocessState *st, float mean_prior)
    float agc_gain;
    int freq_start, freq_end;
    float active_bands = 0;
+   float loudness = 0;
 
    freq_start = (int)(300.0*2*N/st->sampling_rate);
    freq_end   = (int)(2000.0*2*N/st->sampling_rate);
@@ -517,6 +587,23 @@ static void speex_compute_agc(SpeexPreprocessState *st, float mean_prior)
    }
    active_bands /= (freq_end-freq_start+1);
 
+   for (i=2;i<N;i++)
+   {
+      loudness += scale*st->ps[i] * st->gain2[i] * st->gain2[i] * st->loudness_weight[i];
+   }
+
+   agc_gain = preprocess_agc_gain(st, active_bands, loudness);
+
+   for (i=0;i<N;i++)
+      st->gain2[i] *= agc_gain;
+   
+}
+
+/* Loudness tracking, from the share of active bands and the weighted energy of a frame, and the gain that brings it to the agc level */
+float preprocess_agc_gain(SpeexPreprocessState *st, float active_bands, float frame_loudness)
+{
+   float agc_gain;
+
    if (active_bands > .2)
    {
       float loudness=0;
@@ -532,11 +619,7 @@ static void speex_compute_agc(SpeexPreprocessState *st, float mean_prior)
       if (rate < .4 && pow(loudness, LOUDNESS_EXP) > 10*st->loudness)
          rate = .4;
 
-      for (i=2;i<N;i++)
-      {
-         loudness += scale*st->ps[i] * st->gain2[i] * st->gain2[i] * st->loudness_weight[i];
-      }
-      loudness=sqrt(loudness);
+      loudness=sqrt(frame_loudness);
       /*if (loudness < 2*pow(st->loudness, 1.0/LOUDNESS_EXP) &&
         loudness*2 > pow(st->loudness, 1.0/LOUDNESS_EXP))*/
       st->loudness = (1-rate)*st->loudness + (rate)*pow(loudness, LOUDNESS_EXP);
@@ -553,9 +636,7 @@ static void speex_compute_agc(SpeexPreprocessState *st, float mean_prior)
    if (agc_gain>200)
       agc_gain = 200;
 
-   for (i=0;i<N;i++)
-      st->gain2[i] *= agc_gain;
-   
+   return agc_gain;
 }
 
 static void preprocess_analysis(SpeexPreprocessState *st, short *x)
@@ -581,7 +662,7 @@ static void preprocess_analysis(SpeexPreprocessState *st, short *x)
       st->frame[i] *= st->window[i];
 
    /* Perform FFT */
-   drft_forward(st->fft_lookup, st->frame);
+   spx_fft(st->fft_lookup, st->frame);
 
    /* Power spectrum */
    ps[0]=1;
@@ -594,190 +675,152 @@ static void update_noise_prob(SpeexPreprocessState *st)
 {
    int i;
    int N = st->ps_size;
+   const float *restrict ps = st->ps;
+   float *restrict S = st->S;
+   float *restrict Smin = st->Smin;
+   float *restrict Stmp = st->Stmp;
+   float *restrict update_prob = st->update_prob;
 
+   /* the loops are kept free of branches so that they vectorize */
    for (i=1;i<N-1;i++)
-      st->S[i] = 100+ .8*st->S[i] + .05*st->ps[i-1]+.1*st->ps[i]+.05*st->ps[i+1];
+      S[i] = 100+ .8*S[i] + .05*ps[i-1]+.1*ps[i]+.05*ps[i+1];
    
    if (st->nb_preprocess<1)
    {
       for (i=1;i<N-1;i++)
-         st->Smin[i] = st->Stmp[i] = st->S[i]+100;
+         Smin[i] = Stmp[i] = S[i]+100;
    }
 
    if (st->nb_preprocess%200==0)
    {
       for (i=1;i<N-1;i++)
       {
-         st->Smin[i] = min(st->Stmp[i], st->S[i]);
-         st->Stmp[i] = st->S[i];
+         Smin[i] = min(Stmp[i], S[i]);
+         Stmp[i] = S[i];
       }
    } else {
       for (i=1;i<N-1;i++)
       {
-         st->Smin[i] = min(st->Smin[i], st->S[i]);
-         st->Stmp[i] = min(st->Stmp[i], st->S[i]);      
+         Smin[i] = min(Smin[i], S[i]);
+         Stmp[i] = min(Stmp[i], S[i]);      
       }
    }
    for (i=1;i<N-1;i++)
-   {
-      st->update_prob[i] *= .2;
-      if (st->S[i] > 5*st->Smin[i])
-         st->update_prob[i] += .8;
-      /*fprintf (stderr, "%f ", st->S[i]/st->Smin[i]);*/
-      /*fprintf (stderr, "%f ", st->update_prob[i]);*/
-   }
+      update_prob[i] = .2*update_prob[i] + (S[i] > 5*Smin[i] ? .8 : 0);
 
 }
 
-inline void ephraim_malah(SpeexPreprocessState *st, int N, float Pframe)
+/* Speech presence of a frame from its smoothed a priori SNR in the 300 to 2000 Hz bins */
+float preprocess_frame_presence(SpeexPreprocessState *st, float Zframe)
 {
-   int i;   
+   float Pframe;
 
-   /* defactor loop for i=1,1 < i < N-1, and i= N-1 cases */ 
-   /* i=1 case */
+   if (Zframe<ZMIN)
    {
-      float MM;
-      float theta;
-      float prior_ratio;
-      float p, q;
-      float zeta1;
-      float P1;
-                                                                                
-      prior_ratio = st->prior[1]/(1.0001+st->prior[1]);
-      theta = (1+st->post[1])*prior_ratio;
-
-      zeta1 = st->zeta[1];
-
-      if (zeta1<ZMIN)
-         P1 = 0;
-      else if (zeta1>ZMAX)
-         P1 = 1;
-      else
-         P1 = LOG_MIN_MAX_1 * log(ZMIN_1*zeta1);
-                                                                                
-      /*P1 = log(zeta1/ZMIN)/log(ZMAX/ZMIN);*/
-                                                                                
-      /* FIXME: add global prop (P2) */
-      q = 1-Pframe*P1;
-      if (q>.95)
-         q=.95;
-      p=1/(1 + (q/(1-q))*(1+st->prior[1])*exp(-theta));
-                                                                                
-      /* Optimal estimator for loudness domain */
-      MM = hypergeom_gain(theta);
-                                                                                
-      st->gain[1] = prior_ratio * MM;
-      /*Put some (very arbitraty) limit on the gain*/
-      if (st->gain[1]>2)
-      {
-         st->gain[1]=2;
-      }
-                                                                                
-      if (st->denoise_enabled)
+      Pframe = 0;
+   } else {
+      if (Zframe > 1.5*st->Zlast)
       {
-         st->gain2[1]=p*p*st->gain[1];
+         Pframe = 1;
+         st->Zpeak = Zframe;
+         if (st->Zpeak > 10)
+            st->Zpeak = 10;
+         if (st->Zpeak < 1)
+            st->Zpeak = 1;
       } else {
-         st->gain2[1]=1;
+         if (Zframe < st->Zpeak*ZMIN)
+         {
+            Pframe = 0;
+         } else if (Zframe > st->Zpeak*ZMAX)
+         {
+            Pframe = 1;
+         } else {
+            Pframe = log(Zframe/(st->Zpeak*ZMIN)) / log(ZMAX/ZMIN);
+         }
       }
    }
+   st->Zlast = Zframe;
 
-   for (i=2;i<(N-1);i++)
-   {
-      float MM;
-      float theta;
-      float prior_ratio;
-      float p, q;
-      float zeta1;
-      float P1;
-      
-    
-      zeta1 = .25*st->zeta[i-1] + .5*st->zeta[i] + .25*st->zeta[i+1];
-
-      prior_ratio = st->prior[i]/(1.0001+st->prior[i]);
-      theta = (1+st->post[i])*prior_ratio;
-
-                                                                                
+   return Pframe;
+}
 
-      if (zeta1<ZMIN)
-         P1 = 0;
-      else if (zeta1>ZMAX)
-         P1 = 1;
-      else
-         P1 = LOG_MIN_MAX_1 * log(ZMIN_1*zeta1);
+/* Ephraim-Malah gain of bin i, zeta1 is its smoothed a priori SNR */
+static inline void ephraim_malah_bin(SpeexPreprocessState *st, int i, float zeta1, float Pframe)
+{
+   float MM;
+   float theta;
+   float prior_ratio;
+   float p, q;
+   float P1;
+
+   prior_ratio = st->prior[i]/(1.0001+st->prior[i]);
+   theta = (1+st->post[i])*prior_ratio;
+
+   if (zeta1<ZMIN)
+      P1 = 0;
+   else if (zeta1>ZMAX)
+      P1 = 1;
+   else
+      P1 = LOG_MIN_MAX_1 * log(ZMIN_1*zeta1);
                                                                                 
-      /*P1 = log(zeta1/ZMIN)/log(ZMAX/ZMIN);*/
-
+   /*P1 = log(zeta1/ZMIN)/log(ZMAX/ZMIN);*/
                                                                                 
-      /* FIXME: add global prop (P2) */
-      q = 1-Pframe*P1;
-      if (q>.95)
-         q=.95;
-      p=1/(1 + (q/(1-q))*(1+st->prior[i])*exp(-theta));
+   /* FIXME: add global prop (P2) */
+   q = 1-Pframe*P1;
+   if (q>.95)
+      q=.95;
+   p=1/(1 + (q/(1-q))*(1+st->prior[i])*exp(-theta));
                                                                                 
-      /* Optimal estimator for loudness domain */
-      MM = hypergeom_gain(theta);
+   /* Optimal estimator for loudness domain */
+   MM = hypergeom_gain(theta);
                                                                                 
-      st->gain[i] = prior_ratio * MM;
-      /*Put some (very arbitraty) limit on the gain*/
-      if (st->gain[i]>2)
-      {
-         st->gain[i]=2;
-      }
+   st->gain[i] = prior_ratio * MM;
+   /*Put some (very arbitraty) limit on the gain*/
+   if (st->gain[i]>2)
+   {
+      st->gain[i]=2;
+   }
                                                                                 
-      if (st->denoise_enabled)
-      {
-         st->gain2[i]=p*p*st->gain[i];
-      } else {
-         st->gain2[i]=1;
-      }
+   if (st->denoise_enabled)
+   {
+      st->gain2[i]=p*p*st->gain[i];
+   } else {
+      st->gain2[i]=1;
    }
+}
+
+static inline void ephraim_malah(SpeexPreprocessState *st, int N, float Pframe)
+{
+   int i;   
 
-   /* i = N-1 case */
+   /* the a priori SNR of bin 1 is not smoothed, bin N-1 is zeroed below */
+   ephraim_malah_bin(st, 1, st->zeta[1], Pframe);
+
+   /* four bins at a time, the speech presence ( p ) only matters for denoising */
+   for (i=2;i+VLEN<=N-1;i+=VLEN)
    {
-      float MM;
-      float theta;
-      float prior_ratio;
-      float p, q;
-      float zeta1;
-      float P1;
-                                                                                
-      prior_ratio = st->prior[N-1]/(1.0001+st->prior[N-1]);
-      theta = (1+st->post[N-1])*prior_ratio;
-                                                                                
-      zeta1 = st->zeta[N-1];
+      v4sf prior = vload(st->prior+i);
+      v4sf prior_ratio = prior/(1.0001f+prior);
+      v4sf theta = (1.f+vload(st->post+i))*prior_ratio;
+      v4sf gain = vmin(prior_ratio*hypergeom_gain4(theta), vset1(2.f));
+
+      vstore(st->gain+i, gain);
 
-      if (zeta1<ZMIN)
-         P1 = 0;
-      else if (zeta1>ZMAX)
-         P1 = 1;
-      else
-         P1 = LOG_MIN_MAX_1 * log(ZMIN_1*zeta1);
-                                                                                
-      /*P1 = log(zeta1/ZMIN)/log(ZMAX/ZMIN);*/
-                                                                                
-      /* FIXME: add global prop (P2) */
-      q = 1-Pframe*P1;
-      if (q>.95)
-         q=.95;
-      p=1/(1 + (q/(1-q))*(1+st->prior[N-1])*exp(-theta));
-                                                                                
-      /* Optimal estimator for loudness domain */
-      MM = hypergeom_gain(theta);
-                                                                                
-      st->gain[N-1] = prior_ratio * MM;
-      /*Put some (very arbitraty) limit on the gain*/
-      if (st->gain[N-1]>2)
-      {
-         st->gain[N-1]=2;
-      }
-                                                                                
       if (st->denoise_enabled)
       {
-         st->gain2[N-1]=p*p*st->gain[N-1];
+         v4sf zeta1 = .25f*vload(st->zeta+i-1) + .5f*vload(st->zeta+i) + .25f*vload(st->zeta+i+1);
+         v4sf P1 = vselect(zeta1>ZMAX, vset1(1.f), LOG_MIN_MAX_1*vlog(vmax(ZMIN_1*zeta1, vset1(1.f))));
+         v4sf q = vmin(1.f-Pframe*P1, vset1(.95f));
+         v4sf p = 1.f/(1.f + (q/(1.f-q))*(1.f+prior)*vexp(-theta));
+
+         vstore(st->gain2+i, p*p*gain);
       } else {
-         st->gain2[N-1]=1;
+         vstore(st->gain2+i, vset1(1.f));
       }
    }
+   for (;i<N-1;i++)
+      ephraim_malah_bin(st, i, .25*st->zeta[i-1] + .5*st->zeta[i] + .25*st->zeta[i+1], Pframe);
+
    st->gain2[0]=st->gain[0]=0;
    st->gain2[N-1]=st->gain[N-1]=0;
 }
@@ -796,6 +839,9 @@ int speex_preprocess(SpeexPreprocessState *st, short *x, float *echo)
    float *ps=st->ps;
    float Zframe=0, Pframe;
 
+   if (st->fixed)
+      return preprocess_fx(st, x);
+
    preprocess_analysis(st, x);
 
    update_noise_prob(st);
@@ -914,10 +960,7 @@ int speex_preprocess(SpeexPreprocessState *st, short *x, float *echo)
       update_noise(st, st->old_ps, echo);
    } else {
       for (i=1;i<N-1;i++)
-      {
-         if (st->update_prob[i]<.5)
-            st->noise[i] = .90*st->noise[i] + .1*st->ps[i];
-      }
+         st->noise[i] = st->update_prob[i]<.5 ? .90*st->noise[i] + .1*st->ps[i] : st->noise[i];
    }
 
    for (i=1;i<N;i++)
@@ -935,31 +978,7 @@ int speex_preprocess(SpeexPreprocessState *st, short *x, float *echo)
    }
 
    Zframe /= N;
-   if (Zframe<ZMIN)
-   {
-      Pframe = 0;
-   } else {
-      if (Zframe > 1.5*st->Zlast)
-      {
-         Pframe = 1;
-         st->Zpeak = Zframe;
-         if (st->Zpeak > 10)
-            st->Zpeak = 10;
-         if (st->Zpeak < 1)
-            st->Zpeak = 1;
-      } else {
-         if (Zframe < st->Zpeak*ZMIN)
-         {
-            Pframe = 0;
-         } else if (Zframe > st->Zpeak*ZMAX)
-         {
-            Pframe = 1;
-         } else {
-            Pframe = log(Zframe/(st->Zpeak*ZMIN)) / log(ZMAX/ZMIN);
-         }
-      }
-   }
-   st->Zlast = Zframe;
+   Pframe = preprocess_frame_presence(st, Zframe);
 
    /*fprintf (stderr, "%f\n", Pframe);*/
    /* Compute gain according to the Ephraim-Malah algorithm */
@@ -999,7 +1018,7 @@ int speex_preprocess(SpeexPreprocessState *st, short *x, float *echo)
      st->frame[2*N-1]=0;
 
      /* Inverse FFT with 1/N scaling */
-     drft_backward(st->fft_lookup, st->frame);
+     spx_ifft(st->fft_lookup, st->frame);
 
      for (i=0;i<2*N;i++)
 	st->frame[i] *= scale;
@@ -1046,6 +1065,12 @@ void speex_preprocess_estimate_update(SpeexPreprocessState *st, short *x, float
 
    float *ps=st->ps;
 
+   if (st->fixed)
+   {
+      preprocess_fx_estimate_update(st, x);
+      return;
+   }
+
    preprocess_analysis(st, x);
 
    update_noise_prob(st);
@@ -1053,10 +1078,7 @@ void speex_preprocess_estimate_update(SpeexPreprocessState *st, short *x, float
    st->nb_preprocess++;
    
    for (i=1;i<N-1;i++)
-   {
-      if (st->update_prob[i]<.5)
-         st->noise[i] = .90*st->noise[i] + .1*ps[i];
-   }
+      st->noise[i] = st->update_prob[i]<.5 ? .90*st->noise[i] + .1*ps[i] : st->noise[i];
 
    for (i=0;i<N3;i++)
       st->outbuf[i] = x[st->frame_size-N3+i]*st->window[st->frame_size+i];
@@ -0,0 +1,650 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * speex_preprocess() in fixed point, for the states made by
+ * speex_preprocess_state_init_fixed()
+ *
+ * the bins are worked on as integers:
+ *
+ *   frame                    32 bits, the float spectrum scaled by 2^fft_shift
+ *   power spectra            32 bits, in units of 2^ps_shift ( ps, noise, old_ps, S, Smin, Stmp )
+ *   a priori/posteriori SNR  Q9, the a priori ones kept in 16 bits ( prior, zeta )
+ *   gains                    Q14 in 16 bits ( gain ), Q16 ( gain2 )
+ *   update_prob              Q15 in 16 bits
+ *   window, loudness weight  Q15 and Q14 in 16 bits, shared by the states of a size
+ *
+ * and the per frame decisions ( vad, speech presence, agc loudness ) run on
+ * sums of the bins through the float code of preprocess.c. frame, ps, post
+ * and gain2 only live for a call, on the stack, so a state is 32 bytes per
+ * bin against the 80 of a float one. residual echo is not supported
+ */
+
+#include <pthread.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <math.h>
+#include "misc.h"
+#include "fixfft.h"
+#include "preprocess_fx.h"
+
+#define NB_BANDS 8
+
+/* as preprocess.c */
+#define ZMIN_1 10
+#define LOG_MIN_MAX_1 0.86859
+
+#define Q15_ONE 32768
+#define Q15(x) ((int)floor((x) * 32768. + .5))
+
+#define SNR_SHIFT 9
+#define SNR_ONE (1 << SNR_SHIFT)
+#define SNR_MAX (100 << SNR_SHIFT)
+
+/* hypergeom_gain() is tabled up to 9.5, past which it is 1 + .12/x */
+#define HYPERGEOM_MAX (19 << (SNR_SHIFT - 1))
+
+/* the speech presence of a bin is 0 for a smoothed a priori SNR of .1 and below and 1 from .316 */
+#define P1_MIN 52
+#define P1_MAX 162
+
+#define LOG2E_Q14 23637
+
+#define Q30_48_17 3031741621LL
+#define Q30_32_17 2021161080LL
+
+/* window, loudness weight and fft of a frame size and rate, shared by its states */
+struct fx_tables {
+   int frame_size;
+   int sampling_rate;
+   struct fixfft_lookup fft;
+   unsigned short *window;
+   unsigned short *loudness_weight;
+   int refs;
+   struct fx_tables *next;
+};
+
+static struct fx_tables *shared_tables;
+static pthread_mutex_t shared_tables_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* size independent tables, filled with the first shared tables */
+static unsigned short hypergeom_fx[HYPERGEOM_MAX + 1];  /* hypergeom_gain() in Q9, of a Q9 x */
+static unsigned short p1_fx[P1_MAX];                    /* speech presence of a bin in Q15, of its Q9 smoothed a priori SNR */
+static unsigned short exp2_fx[SNR_ONE];                 /* 2^-(i/512) in Q15 */
+
+struct preprocess_fx {
+   struct fx_tables *tables;
+   int ps_shift;
+   int fft_shift;
+   int *noise;
+   int *old_ps;
+   int *S;
+   int *Smin;
+   int *Stmp;
+   unsigned short *gain;
+   unsigned short *prior;
+   unsigned short *zeta;
+   unsigned short *update_prob;
+   short *inbuf;
+   short *outbuf;
+};
+
+static void fill_math_tables(void)
+{
+   int i;
+
+   for (i=0;i<=HYPERGEOM_MAX;i++)
+      hypergeom_fx[i] = floor(hypergeom_gain((float)i/SNR_ONE)*SNR_ONE + .5);
+   for (i=P1_MIN;i<P1_MAX;i++)
+      p1_fx[i] = floor(LOG_MIN_MAX_1*log(ZMIN_1*(double)i/SNR_ONE)*Q15_ONE + .5);
+   for (i=0;i<SNR_ONE;i++)
+      exp2_fx[i] = floor(pow(2., -(double)i/SNR_ONE)*Q15_ONE + .5);
+}
+
+static struct fx_tables *shared_tables_get(int frame_size, int sampling_rate)
+{
+   struct fx_tables *t;
+   int N = frame_size, i;
+
+   pthread_mutex_lock(&shared_tables_lock);
+
+   for (t = shared_tables; t && (t->frame_size != frame_size || t->sampling_rate != sampling_rate); t = t->next)
+      ;
+
+   if (!t)
+   {
+      float window[2*N], loudness_weight[N];
+
+      t = (struct fx_tables*)speex_alloc(sizeof(struct fx_tables));
+      if (fixfft_init(&t->fft, 2*N))
+      {
+         speex_free(t);
+         pthread_mutex_unlock(&shared_tables_lock);
+         return 0;
+      }
+      t->frame_size = frame_size;
+      t->sampling_rate = sampling_rate;
+
+      preprocess_window(window, N, frame_size);
+      t->window = (unsigned short*)speex_alloc(2*N*sizeof(unsigned short));
+      for (i=0;i<2*N;i++)
+         t->window[i] = floor(window[i]*Q15_ONE + .5);
+
+      preprocess_loudness_weight(loudness_weight, N, sampling_rate);
+      t->loudness_weight = (unsigned short*)speex_alloc(N*sizeof(unsigned short));
+      for (i=0;i<N;i++)
+         t->loudness_weight[i] = floor(loudness_weight[i]*16384 + .5);
+
+      if (!exp2_fx[0])
+         fill_math_tables();
+
+      t->next = shared_tables;
+      shared_tables = t;
+   }
+   t->refs++;
+
+   pthread_mutex_unlock(&shared_tables_lock);
+
+   return t;
+}
+
+static void shared_tables_put(struct fx_tables *t)
+{
+   struct fx_tables **p;
+
+   pthread_mutex_lock(&shared_tables_lock);
+
+   if (!--t->refs)
+   {
+      for (p = &shared_tables; *p != t; p = &(*p)->next)
+         ;
+      *p = t->next;
+
+      fixfft_clear(&t->fft);
+      speex_free(t->window);
+      speex_free(t->loudness_weight);
+      speex_free(t);
+   }
+
+   pthread_mutex_unlock(&shared_tables_lock);
+}
+
+void *preprocess_fx_init(SpeexPreprocessState *st)
+{
+   int i;
+   int N = st->ps_size;
+   int N3 = 2*N - st->frame_size;
+   struct fx_tables *tables;
+   struct preprocess_fx *fx;
+   char *p;
+
+   if (N3 <= 0 || !(tables = shared_tables_get(st->frame_size, st->sampling_rate)))
+      return 0;
+
+   /* one block, the 32 bit arrays first */
+   fx = (struct preprocess_fx*)speex_alloc(sizeof(struct preprocess_fx) + 5*N*sizeof(int) + 4*N*sizeof(unsigned short) + 2*N3*sizeof(short));
+   p = (char*)(fx + 1);
+   fx->noise = (int*)p; p += N*sizeof(int);
+   fx->old_ps = (int*)p; p += N*sizeof(int);
+   fx->S = (int*)p; p += N*sizeof(int);
+   fx->Smin = (int*)p; p += N*sizeof(int);
+   fx->Stmp = (int*)p; p += N*sizeof(int);
+   fx->gain = (unsigned short*)p; p += N*sizeof(unsigned short);
+   fx->prior = (unsigned short*)p; p += N*sizeof(unsigned short);
+   fx->zeta = (unsigned short*)p; p += N*sizeof(unsigned short);
+   fx->update_prob = (unsigned short*)p; p += N*sizeof(unsigned short);
+   fx->inbuf = (short*)p; p += N3*sizeof(short);
+   fx->outbuf = (short*)p;
+
+   fx->tables = tables;
+
+   /* a full scale tone about fills the power spectrum, the fft input has room for its growth */
+   for (i=N, fx->ps_shift=-2; i>1; i>>=1)
+      fx->ps_shift += 2;
+   for (fx->fft_shift=0; (2*N << (fx->fft_shift+1)) <= 1<<14; fx->fft_shift++)
+      ;
+
+   for (i=0;i<N;i++)
+   {
+      fx->noise[i] = fx->old_ps[i] = 1 + (int)ldexp(1e4, -fx->ps_shift);
+      fx->gain[i] = 1<<14;
+      fx->prior[i] = SNR_ONE;
+   }
+
+   return fx;
+}
+
+void preprocess_fx_destroy(void *fx)
+{
+   shared_tables_put(((struct preprocess_fx*)fx)->tables);
+   speex_free(fx);
+}
+
+static inline short saturate16(int x)
+{
+   return x > SHRT_MAX ? SHRT_MAX : x < SHRT_MIN ? SHRT_MIN : x;
+}
+
+/* a/d in Qq, for 0 <= a < 2^31, 0 < d < 2^32 and q <= 30 + log2(d): d = m*2^e with .5 <= m < 1,
+   and 1/m in Q30 is two Newton steps from a linear guess, within 2^-16 */
+static inline long long div_fx(long long a, unsigned int d, int q)
+{
+   int s = __builtin_clz(d);
+   long long m = (d << s) >> 2;
+   long long r = Q30_48_17 - ((Q30_32_17*m) >> 30);
+
+   r = (r*((2LL << 30) - ((m*r) >> 30))) >> 30;
+   r = (r*((2LL << 30) - ((m*r) >> 30))) >> 30;
+
+   return (a*r) >> (30 + (32 - s) - q);
+}
+
+/* exp(-x) in Q15 of a Q9 x >= 0 */
+static inline int exp_fx(int x)
+{
+   int y = (x*LOG2E_Q14) >> 14;
+   int n = y >> SNR_SHIFT;
+
+   return n > 15 ? 0 : exp2_fx[y & (SNR_ONE-1)] >> n;
+}
+
+static void analysis(SpeexPreprocessState *st, struct preprocess_fx *fx, short *x, int *frame, int *ps)
+{
+   int i;
+   int N = st->ps_size;
+   int N3 = 2*N - st->frame_size;
+   int N4 = st->frame_size - N3;
+   int shift = 15 - fx->fft_shift;
+   const unsigned short *window = fx->tables->window;
+
+   /* 'Build' input frame */
+   for (i=0;i<N3;i++)
+      frame[i]=fx->inbuf[i];
+   for (i=0;i<st->frame_size;i++)
+      frame[N3+i]=x[i];
+
+   /* Update inbuf */
+   for (i=0;i<N3;i++)
+      fx->inbuf[i]=x[N4+i];
+
+   /* Windowing */
+   for (i=0;i<2*N;i++)
+      frame[i] = (frame[i]*window[i] + (1<<(shift-1))) >> shift;
+
+   fixfft_forward(&fx->tables->fft, frame);
+
+   /* Power spectrum, saturated */
+   shift = fx->ps_shift + 2*fx->fft_shift;
+   ps[0]=1;
+   for (i=1;i<N;i++)
+   {
+      long long e = ((long long)frame[2*i-1]*frame[2*i-1] + (long long)frame[2*i]*frame[2*i]) >> shift;
+      ps[i] = 1 + (e < INT_MAX ? (int)e : INT_MAX-1);
+   }
+}
+
+static void update_noise_prob(SpeexPreprocessState *st, struct preprocess_fx *fx, const int *ps)
+{
+   int i;
+   int N = st->ps_size;
+   int *S = fx->S, *Smin = fx->Smin, *Stmp = fx->Stmp;
+   unsigned short *update_prob = fx->update_prob;
+
+   for (i=1;i<N-1;i++)
+      S[i] = (Q15(.8)*(long long)S[i] + Q15(.05)*((long long)ps[i-1] + ps[i+1]) + Q15(.1)*(long long)ps[i] + (1<<14)) >> 15;
+
+   if (st->nb_preprocess<1)
+   {
+      for (i=1;i<N-1;i++)
+         Smin[i] = Stmp[i] = S[i]+1;
+   }
+
+   if (st->nb_preprocess%200==0)
+   {
+      for (i=1;i<N-1;i++)
+      {
+         Smin[i] = Stmp[i] < S[i] ? Stmp[i] : S[i];
+         Stmp[i] = S[i];
+      }
+   } else {
+      for (i=1;i<N-1;i++)
+      {
+         Smin[i] = Smin[i] < S[i] ? Smin[i] : S[i];
+         Stmp[i] = Stmp[i] < S[i] ? Stmp[i] : S[i];
+      }
+   }
+   for (i=1;i<N-1;i++)
+      update_prob[i] = ((Q15(.2)*update_prob[i]) >> 15) + (S[i] > 5*(long long)Smin[i] ? Q15(.8) : 0);
+}
+
+static void update_noise(SpeexPreprocessState *st, struct preprocess_fx *fx, const int *ps)
+{
+   int i;
+   int beta;
+   st->nb_adapt++;
+   beta=Q15_ONE/st->nb_adapt;
+   if (beta < Q15(.05))
+      beta=Q15(.05);
+
+   for (i=0;i<st->ps_size;i++)
+      fx->noise[i] += ((long long)(ps[i] - fx->noise[i])*beta + (1<<14)) >> 15;
+}
+
+/* Noise update of the bins unlikely to hold speech */
+static void track_noise(SpeexPreprocessState *st, struct preprocess_fx *fx, const int *ps)
+{
+   int i;
+
+   for (i=1;i<st->ps_size-1;i++)
+      if (fx->update_prob[i] < Q15(.5))
+         fx->noise[i] = (Q15(.9)*(long long)fx->noise[i] + Q15(.1)*(long long)ps[i] + (1<<14)) >> 15;
+}
+
+static int compute_vad(SpeexPreprocessState *st, struct preprocess_fx *fx, const int *ps, float mean_post)
+{
+   int i, j;
+   int N = st->ps_size;
+   const unsigned short *loudness_weight = fx->tables->loudness_weight;
+   float bands[NB_BANDS];
+   long long loudness = 0;
+
+   for (i=5;i<N-10;i++)
+      loudness += (long long)ps[i]*loudness_weight[i];
+
+   for (i=0;i<NB_BANDS;i++)
+   {
+      long long band = 0;
+      for (j=i*N/NB_BANDS;j<(i+1)*N/NB_BANDS;j++)
+         band += ps[j];
+      bands[i]=log(1e4 + ldexp(band, fx->ps_shift));
+   }
+
+   return preprocess_vad_decision(st, bands, .5/N*ldexp(loudness, fx->ps_shift - 14), mean_post);
+}
+
+static void compute_agc(SpeexPreprocessState *st, struct preprocess_fx *fx, const int *ps, int *gain2)
+{
+   int i;
+   int N = st->ps_size;
+   const unsigned short *loudness_weight = fx->tables->loudness_weight;
+   int freq_start = (int)(300.0*2*N/st->sampling_rate);
+   int freq_end   = (int)(2000.0*2*N/st->sampling_rate);
+   int active_bands = 0;
+   long long loudness = 0;
+   int agc_gain;
+
+   for (i=freq_start;i<freq_end;i++)
+   {
+      if (fx->S[i] > 20*(long long)fx->Smin[i] + (1000 >> fx->ps_shift))
+         active_bands++;
+   }
+
+   for (i=2;i<N;i++)
+   {
+      long long g = ((long long)gain2[i]*gain2[i]) >> 16;
+      loudness += (((long long)ps[i]*g) >> 16)*loudness_weight[i];
+   }
+
+   agc_gain = 65536*preprocess_agc_gain(st, (float)active_bands/(freq_end-freq_start+1), .5/N*ldexp(loudness, fx->ps_shift - 14));
+
+   for (i=0;i<N;i++)
+      gain2[i] = ((long long)gain2[i]*agc_gain) >> 16;
+}
+
+/* Ephraim-Malah gain of bin i, zeta1 is its smoothed a priori SNR and Pframe the speech presence of the frame ( Q15 ) */
+static inline void ephraim_malah_bin(SpeexPreprocessState *st, struct preprocess_fx *fx, int i, int zeta1, int Pframe, const int *post, int *gain2)
+{
+   int prior = fx->prior[i];
+   int prior_ratio = div_fx(prior, prior + SNR_ONE, 15);
+   int theta = ((SNR_ONE + post[i])*prior_ratio) >> 15;
+   int MM = theta > HYPERGEOM_MAX ? SNR_ONE + (int)(.12*SNR_ONE*SNR_ONE)/theta : hypergeom_fx[theta];
+   int gain = (prior_ratio*MM) >> 10;
+
+   /*Put some (very arbitraty) limit on the gain*/
+   if (gain > 2<<14)
+      gain = 2<<14;
+   fx->gain[i] = gain;
+
+   if (st->denoise_enabled)
+   {
+      int P1 = zeta1 < P1_MAX ? p1_fx[zeta1] : Q15_ONE;
+      int q = Q15_ONE - ((Pframe*P1) >> 15);
+      int odds, p;
+      long long a;
+
+      if (q > Q15(.95))
+         q = Q15(.95);
+
+      /* p = 1/(1 + q/(1-q)*(1+prior)*exp(-theta)), the odds in Q12 */
+      odds = div_fx(q, Q15_ONE - q, 12);
+      a = ((long long)odds*(SNR_ONE + prior)*exp_fx(theta)) >> 21;
+      p = div_fx(Q15_ONE, Q15_ONE + a, 15);
+
+      gain2[i] = ((long long)p*p*gain) >> 28;
+   } else {
+      gain2[i] = 1<<16;
+   }
+}
+
+static void synthesis(SpeexPreprocessState *st, struct preprocess_fx *fx, short *x, int *frame, const int *gain2)
+{
+   int i;
+   int N = st->ps_size;
+   int N3 = 2*N - st->frame_size;
+   int N4 = st->frame_size - N3;
+   const unsigned short *window = fx->tables->window;
+   long long sum = 0, recip;
+   int shift = 0, e, max_sample = 0;
+
+   /* Get rid of the DC, very low and Nyquist frequencies, apply computed gain */
+   frame[0]=frame[1]=frame[2]=0;
+   frame[2*N-1]=0;
+
+   /* scaled down for the inverse fft to keep below 2^30 */
+   for (i=2;i<N;i++)
+      sum += llabs((long long)frame[2*i-1]*gain2[i]) + llabs((long long)frame[2*i]*gain2[i]);
+   for (sum >>= 16; sum >> shift >= 1<<28; shift++)
+      ;
+
+   for (i=2;i<N;i++)
+   {
+      frame[2*i-1] = ((long long)frame[2*i-1]*gain2[i]) >> (16 + shift);
+      frame[2*i] = ((long long)frame[2*i]*gain2[i]) >> (16 + shift);
+   }
+
+   fixfft_backward(&fx->tables->fft, frame);
+
+   /* back to samples, from 2*N times the spectrum's scale of 2^(fft_shift - shift) */
+   e = fx->fft_shift - shift;
+   recip = ((1LL << 32) + N)/(2*N);
+   for (i=0;i<2*N;i++)
+   {
+      frame[i] = ((long long)frame[i]*recip + (1LL << (31 + e))) >> (32 + e);
+      if (abs(frame[i]) > max_sample)
+         max_sample = abs(frame[i]);
+   }
+
+   if (max_sample>28000)
+   {
+      int damp = (28000 << 15)/max_sample;
+      for (i=0;i<2*N;i++)
+         frame[i] = ((long long)frame[i]*damp) >> 15;
+   }
+
+   for (i=0;i<2*N;i++)
+      frame[i] = (frame[i]*window[i] + (1<<14)) >> 15;
+
+   /* Perform overlap and add */
+   for (i=0;i<N3;i++)
+      x[i] = saturate16(fx->outbuf[i] + frame[i]);
+   for (i=0;i<N4;i++)
+      x[N3+i] = saturate16(frame[N3+i]);
+
+   /* Update outbuf */
+   for (i=0;i<N3;i++)
+      fx->outbuf[i] = frame[st->frame_size+i];
+}
+
+int preprocess_fx(SpeexPreprocessState *st, short *x)
+{
+   struct preprocess_fx *fx = (struct preprocess_fx*)st->fixed;
+   int i;
+   int is_speech=1;
+   int N = st->ps_size;
+   int frame[2*N], ps[N], post[N], gain2[N];
+   long long post_sum=0, prior_sum=0, zeta_sum=0;
+   float mean_post, mean_prior;
+   int gamma, Pframe;
+
+   analysis(st, fx, x, frame, ps);
+
+   update_noise_prob(st, fx, ps);
+
+   st->nb_preprocess++;
+
+   /* Noise estimation always updated for the 20 first times */
+   if (st->nb_adapt<10)
+   {
+      update_noise(st, fx, ps);
+   }
+
+   /* Compute a posteriori SNR */
+   for (i=1;i<N;i++)
+   {
+      long long snr = div_fx(ps[i], 1 + fx->noise[i], SNR_SHIFT) - SNR_ONE;
+      post[i] = snr > SNR_MAX ? SNR_MAX : snr;
+      post_sum += post[i];
+   }
+   mean_post = ldexp(post_sum, -SNR_SHIFT)/N;
+   if (mean_post<0)
+      mean_post=0;
+
+   /* Special case for first frame */
+   if (st->nb_adapt==1)
+      for (i=1;i<N;i++)
+         fx->old_ps[i] = ps[i];
+
+   /* Compute a priori SNR, at speex_preprocess()'s update rate */
+   {
+      float min_gamma = .1*mean_post*mean_post;
+      if (min_gamma>.15)
+         min_gamma = .15;
+      if (min_gamma<.02)
+         min_gamma = .02;
+      gamma = Q15(min_gamma);
+   }
+
+   for (i=1;i<N;i++)
+   {
+      int g = fx->gain[i];
+      long long snr = div_fx(fx->old_ps[i], 1 + fx->noise[i], SNR_SHIFT);
+      long long prior;
+
+      if (snr > 1LL<<34)
+         snr = 1LL<<34;
+
+      /* A priori SNR update, gain is Q14 */
+      prior = (gamma*(long long)(post[i] > 0 ? post[i] : 0) + (Q15_ONE - gamma)*((snr*g*g) >> 28)) >> 15;
+
+      if (prior > SNR_MAX)
+         prior = SNR_MAX;
+      fx->prior[i] = prior;
+      prior_sum += prior;
+   }
+   mean_prior = ldexp(prior_sum, -SNR_SHIFT)/N;
+
+   if (st->nb_preprocess>=20)
+   {
+      int do_update = 0;
+      long long noise_ener=0, sig_ener=0;
+      /* If SNR is low (both a priori and a posteriori), update the noise estimate*/
+      if (mean_prior<.23 && mean_post < .5)
+         do_update = 1;
+      for (i=1;i<N;i++)
+      {
+         noise_ener += fx->noise[i];
+         sig_ener += ps[i];
+      }
+      if (noise_ener > 3*sig_ener)
+         do_update = 1;
+      if (do_update)
+      {
+         st->consec_noise++;
+      } else {
+         st->consec_noise=0;
+      }
+   }
+
+   if (st->vad_enabled)
+      is_speech = compute_vad(st, fx, ps, mean_post);
+
+   if (st->consec_noise>=3)
+   {
+      update_noise(st, fx, fx->old_ps);
+   } else {
+      track_noise(st, fx, ps);
+   }
+
+   for (i=1;i<N;i++)
+      fx->zeta[i] = (Q15(.7)*fx->zeta[i] + Q15(.3)*fx->prior[i] + (1<<14)) >> 15;
+
+   {
+      int freq_start = (int)(300.0*2*N/st->sampling_rate);
+      int freq_end   = (int)(2000.0*2*N/st->sampling_rate);
+      for (i=freq_start;i<freq_end;i++)
+         zeta_sum += fx->zeta[i];
+   }
+   Pframe = Q15(preprocess_frame_presence(st, ldexp(zeta_sum, -SNR_SHIFT)/N));
+
+   /* Compute gain according to the Ephraim-Malah algorithm, the a priori SNR of bin 1 is not smoothed */
+   ephraim_malah_bin(st, fx, 1, fx->zeta[1], Pframe, post, gain2);
+   for (i=2;i<N-1;i++)
+      ephraim_malah_bin(st, fx, i, (fx->zeta[i-1] + 2*fx->zeta[i] + fx->zeta[i+1] + 2) >> 2, Pframe, post, gain2);
+   gain2[0]=fx->gain[0]=0;
+   gain2[N-1]=fx->gain[N-1]=0;
+
+   if (st->agc_enabled)
+      compute_agc(st, fx, ps, gain2);
+
+   if (st->agc_enabled || st->denoise_enabled)
+      synthesis(st, fx, x, frame, gain2);
+
+   /* Save old power spectrum */
+   for (i=1;i<N;i++)
+      fx->old_ps[i] = ps[i];
+
+   return is_speech;
+}
+
+void preprocess_fx_estimate_update(SpeexPreprocessState *st, short *x)
+{
+   struct preprocess_fx *fx = (struct preprocess_fx*)st->fixed;
+   int i;
+   int N = st->ps_size;
+   int N3 = 2*N - st->frame_size;
+   int frame[2*N], ps[N];
+
+   analysis(st, fx, x, frame, ps);
+
+   update_noise_prob(st, fx, ps);
+
+   st->nb_preprocess++;
+
+   track_noise(st, fx, ps);
+
+   for (i=0;i<N3;i++)
+      fx->outbuf[i] = (x[st->frame_size-N3+i]*fx->tables->window[st->frame_size+i] + (1<<14)) >> 15;
+
+   /* Save old power spectrum */
+   for (i=1;i<N;i++)
+      fx->old_ps[i] = ps[i];
+}
@@ -0,0 +1,41 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * fixed point preprocessor
+ *
+ * states made by speex_preprocess_state_init_fixed() keep their spectra in
+ * a compact integer state ( preprocess_fx.c ) and share with the float
+ * preprocessor ( preprocess.c ) the per frame decisions, which only see a
+ * handful of values
+ */
+
+#ifndef PREPROCESS_FX_H
+#define PREPROCESS_FX_H
+
+#include "speex_preprocess.h"
+
+/* preprocess_fx.c */
+void *preprocess_fx_init(SpeexPreprocessState *st);
+void preprocess_fx_destroy(void *fx);
+int preprocess_fx(SpeexPreprocessState *st, short *x);
+void preprocess_fx_estimate_update(SpeexPreprocessState *st, short *x);
+
+/* preprocess.c */
+void preprocess_window(float *window, int N, int frame_size);
+void preprocess_loudness_weight(float *loudness_weight, int N, int sampling_rate);
+float hypergeom_gain(float x);
+int preprocess_vad_decision(SpeexPreprocessState *st, const float *bands, float tot_loudness, float mean_post);
+float preprocess_frame_presence(SpeexPreprocessState *st, float Zframe);
+float preprocess_agc_gain(SpeexPreprocessState *st, float active_bands, float loudness);
+
+#endif
@@ -31,12 +31,13 @@
    POSSIBILITY OF SUCH DAMAGE.
 */
 
+#ifndef SPEEX_PREPROCESS_H
+#define SPEEX_PREPROCESS_H
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-struct drft_lookup;
 
 typedef struct SpeexPreprocessState {
    int    frame_size;        /**< Number of samples processed each time */
@@ -94,13 +95,17 @@ typedef struct SpeexPreprocessState {
    int    nb_loudness_adapt; /**< Number of frames used for loudness adaptation so far */
    int    consec_noise;      /**< Number of consecutive noise frames */
    int    nb_preprocess;     /**< Number of frames processed so far */
-   struct drft_lookup *fft_lookup;   /**< Lookup table for the FFT */
+   void  *fft_lookup;        /**< Lookup table for the FFT */
+   void  *fixed;             /**< Fixed point state, the float arrays are unused when set */
 
 } SpeexPreprocessState;
 
 /** Creates a new preprocessing state */
 SpeexPreprocessState *speex_preprocess_state_init(int frame_size, int sampling_rate);
 
+/** Creates a new fixed point preprocessing state, NULL for sizes it does not support. It ignores the residual echo of speex_preprocess() */
+SpeexPreprocessState *speex_preprocess_state_init_fixed(int frame_size, int sampling_rate);
+
 /** Destroys a denoising state */
 void speex_preprocess_state_destroy(SpeexPreprocessState *st);
 
@@ -137,3 +142,5 @@ int speex_preprocess_ctl(SpeexPreprocessState *st, int request, void *ptr);
 #ifdef __cplusplus
 }
 #endif
+
+#endif
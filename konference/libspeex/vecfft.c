@@ -0,0 +1,415 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * The n point real transform is an n/2 point complex transform of the even
+ * and odd samples followed by a split into the n/2+1 bins. The complex
+ * transform is a Stockham autosort decimation in frequency, with radix 4
+ * passes first and then 2, 3 and 5, so 160 = 4*4*2*5 and 320 = 4*4*4*5.
+ * Real and imaginary parts are kept in separate arrays and every pass runs
+ * four butterflies at once, one per vector lane. Once the stride of a pass
+ * reaches four, the lanes of a butterfly are contiguous at both ends.
+ */
+
+#include <math.h>
+#include "misc.h"
+#include "vecmath.h"
+#include "vecfft.h"
+
+#define SIN_60 0.866025403784438647f
+#define COS_72 0.309016994374947424f
+#define SIN_72 0.951056516295153572f
+#define COS_144 -0.809016994374947424f
+#define SIN_144 0.587785252292473129f
+
+/* Multiply outputs 1 to r-1 of four butterflies by their twiddles */
+static inline void twiddle(v4sf *br, v4sf *bi, int r, const float *tw, int h, int idx)
+{
+   int j;
+
+   for (j = 1; j < r; j++)
+   {
+      v4sf wr = vload(tw + (2 * j - 2) * h + idx);
+      v4sf wi = vload(tw + (2 * j - 1) * h + idx);
+      v4sf t = br[j] * wr - bi[j] * wi;
+
+      bi[j] = br[j] * wi + bi[j] * wr;
+      br[j] = t;
+   }
+}
+
+/* Store the outputs of four butterflies, butterfly idx = s*p + q writes output j
+   to q + s*(r*p + j), base is q + s*r*p when the stride is a whole number of vectors */
+static inline void store(float *yr, float *yi, const v4sf *br, const v4sf *bi, int r, int s, int idx, int base)
+{
+   int j, l;
+
+   if (!(s % VLEN))
+   {
+      for (j = 0; j < r; j++)
+      {
+         vstore(yr + base + s * j, br[j]);
+         vstore(yi + base + s * j, bi[j]);
+      }
+   } else if (s == 1 && r == 4)
+   {
+      /* the first radix 4 pass, four butterflies are a transposed 4x4 block */
+      for (l = 0; l < VLEN; l++)
+      {
+         vstore(yr + 4 * (idx + l), (v4sf){br[0][l], br[1][l], br[2][l], br[3][l]});
+         vstore(yi + 4 * (idx + l), (v4sf){bi[0][l], bi[1][l], bi[2][l], bi[3][l]});
+      }
+   } else {
+      for (l = 0; l < VLEN; l++)
+      {
+         base = (idx + l) % s + r * (idx + l - (idx + l) % s);
+
+         for (j = 0; j < r; j++)
+         {
+            yr[base + s * j] = br[j][l];
+            yi[base + s * j] = bi[j][l];
+         }
+      }
+   }
+}
+
+/* Step base to the next four butterflies */
+static inline void advance(int *q, int *base, int r, int s)
+{
+   *q += VLEN;
+   *base += VLEN;
+   if (*q >= s)
+   {
+      *q = 0;
+      *base += (r - 1) * s;
+   }
+}
+
+static void pass2(int m, int s, const float *tw, const float *xr, const float *xi, float *yr, float *yi)
+{
+   int h = m / 2, idx, q = 0, base = 0;
+
+   for (idx = 0; idx < h; idx += VLEN)
+   {
+      v4sf a0r = vload(xr + idx), a0i = vload(xi + idx);
+      v4sf a1r = vload(xr + idx + h), a1i = vload(xi + idx + h);
+      v4sf br[2], bi[2];
+
+      br[0] = a0r + a1r;
+      bi[0] = a0i + a1i;
+      br[1] = a0r - a1r;
+      bi[1] = a0i - a1i;
+
+      if (tw)
+         twiddle(br, bi, 2, tw, h, idx);
+      store(yr, yi, br, bi, 2, s, idx, base);
+      advance(&q, &base, 2, s);
+   }
+}
+
+static void pass3(int m, int s, const float *tw, const float *xr, const float *xi, float *yr, float *yi)
+{
+   int h = m / 3, idx, q = 0, base = 0;
+
+   for (idx = 0; idx < h; idx += VLEN)
+   {
+      v4sf a0r = vload(xr + idx), a0i = vload(xi + idx);
+      v4sf a1r = vload(xr + idx + h), a1i = vload(xi + idx + h);
+      v4sf a2r = vload(xr + idx + 2 * h), a2i = vload(xi + idx + 2 * h);
+      v4sf br[3], bi[3];
+
+      v4sf tr = a1r + a2r, ti = a1i + a2i;
+      v4sf mr = a0r - .5f * tr, mi = a0i - .5f * ti;
+      v4sf nr = SIN_60 * (a1r - a2r), ni = SIN_60 * (a1i - a2i);
+
+      br[0] = a0r + tr;
+      bi[0] = a0i + ti;
+      br[1] = mr + ni;
+      bi[1] = mi - nr;
+      br[2] = mr - ni;
+      bi[2] = mi + nr;
+
+      if (tw)
+         twiddle(br, bi, 3, tw, h, idx);
+      store(yr, yi, br, bi, 3, s, idx, base);
+      advance(&q, &base, 3, s);
+   }
+}
+
+static void pass4(int m, int s, const float *tw, const float *xr, const float *xi, float *yr, float *yi)
+{
+   int h = m / 4, idx, q = 0, base = 0;
+
+   for (idx = 0; idx < h; idx += VLEN)
+   {
+      v4sf a0r = vload(xr + idx), a0i = vload(xi + idx);
+      v4sf a1r = vload(xr + idx + h), a1i = vload(xi + idx + h);
+      v4sf a2r = vload(xr + idx + 2 * h), a2i = vload(xi + idx + 2 * h);
+      v4sf a3r = vload(xr + idx + 3 * h), a3i = vload(xi + idx + 3 * h);
+      v4sf br[4], bi[4];
+
+      v4sf t0r = a0r + a2r, t0i = a0i + a2i;
+      v4sf t1r = a0r - a2r, t1i = a0i - a2i;
+      v4sf t2r = a1r + a3r, t2i = a1i + a3i;
+      v4sf t3r = a1r - a3r, t3i = a1i - a3i;
+
+      /* outputs 1 and 3 take t3 times -i and i */
+      br[0] = t0r + t2r;
+      bi[0] = t0i + t2i;
+      br[1] = t1r + t3i;
+      bi[1] = t1i - t3r;
+      br[2] = t0r - t2r;
+      bi[2] = t0i - t2i;
+      br[3] = t1r - t3i;
+      bi[3] = t1i + t3r;
+
+      if (tw)
+         twiddle(br, bi, 4, tw, h, idx);
+      store(yr, yi, br, bi, 4, s, idx, base);
+      advance(&q, &base, 4, s);
+   }
+}
+
+static void pass5(int m, int s, const float *tw, const float *xr, const float *xi, float *yr, float *yi)
+{
+   int h = m / 5, idx, q = 0, base = 0;
+
+   for (idx = 0; idx < h; idx += VLEN)
+   {
+      v4sf a0r = vload(xr + idx), a0i = vload(xi + idx);
+      v4sf a1r = vload(xr + idx + h), a1i = vload(xi + idx + h);
+      v4sf a2r = vload(xr + idx + 2 * h), a2i = vload(xi + idx + 2 * h);
+      v4sf a3r = vload(xr + idx + 3 * h), a3i = vload(xi + idx + 3 * h);
+      v4sf a4r = vload(xr + idx + 4 * h), a4i = vload(xi + idx + 4 * h);
+      v4sf br[5], bi[5];
+
+      v4sf t1r = a1r + a4r, t1i = a1i + a4i;
+      v4sf t2r = a2r + a3r, t2i = a2i + a3i;
+      v4sf t3r = a1r - a4r, t3i = a1i - a4i;
+      v4sf t4r = a2r - a3r, t4i = a2i - a3i;
+
+      v4sf m1r = a0r + COS_72 * t1r + COS_144 * t2r, m1i = a0i + COS_72 * t1i + COS_144 * t2i;
+      v4sf m2r = a0r + COS_144 * t1r + COS_72 * t2r, m2i = a0i + COS_144 * t1i + COS_72 * t2i;
+      v4sf n1r = SIN_72 * t3r + SIN_144 * t4r, n1i = SIN_72 * t3i + SIN_144 * t4i;
+      v4sf n2r = SIN_144 * t3r - SIN_72 * t4r, n2i = SIN_144 * t3i - SIN_72 * t4i;
+
+      br[0] = a0r + t1r + t2r;
+      bi[0] = a0i + t1i + t2i;
+      br[1] = m1r + n1i;
+      bi[1] = m1i - n1r;
+      br[4] = m1r - n1i;
+      bi[4] = m1i + n1r;
+      br[2] = m2r + n2i;
+      bi[2] = m2i - n2r;
+      br[3] = m2r - n2i;
+      bi[3] = m2i + n2r;
+
+      if (tw)
+         twiddle(br, bi, 5, tw, h, idx);
+      store(yr, yi, br, bi, 5, s, idx, base);
+      advance(&q, &base, 5, s);
+   }
+}
+
+/* Forward complex transform of x, returns the buffer holding the result ( x or y ) */
+static float *complex_forward(struct vecfft_lookup *l, float *xr, float *xi, float *yr, float *yi)
+{
+   int m = l->m, s = 1, i;
+
+   for (i = 0; i < l->nstages; i++)
+   {
+      float *t;
+
+      switch (l->radix[i])
+      {
+      case 2:
+         pass2(m, s, l->twiddle[i], xr, xi, yr, yi);
+         break;
+      case 3:
+         pass3(m, s, l->twiddle[i], xr, xi, yr, yi);
+         break;
+      case 4:
+         pass4(m, s, l->twiddle[i], xr, xi, yr, yi);
+         break;
+      default:
+         pass5(m, s, l->twiddle[i], xr, xi, yr, yi);
+         break;
+      }
+      s *= l->radix[i];
+
+      t = xr; xr = yr; yr = t;
+      t = xi; xi = yi; yi = t;
+   }
+
+   return xr;
+}
+
+int vecfft_init(struct vecfft_lookup *l, int n)
+{
+   static const int radices[] = {4, 2, 3, 5};
+   int m = n / 2, rest = m, s = 1, i, j, k;
+
+   l->n = n;
+   l->m = m;
+   l->nstages = 0;
+   l->post = 0;
+
+   if (n <= 0 || n % 2 || n > VECFFT_MAX_SIZE)
+      return -1;
+
+   /* factor, every pass needs its butterflies to fill whole vectors */
+   for (i = 0; i < 4; i++)
+   {
+      while (rest % radices[i] == 0 && (m / radices[i]) % VLEN == 0 && l->nstages < VECFFT_MAX_STAGES)
+      {
+         l->radix[l->nstages++] = radices[i];
+         rest /= radices[i];
+      }
+   }
+   if (rest != 1)
+   {
+      l->nstages = 0;
+      return -1;
+   }
+
+   for (i = 0; i < l->nstages; i++)
+   {
+      int r = l->radix[i], h = m / r, len = m / s;
+
+      /* the last pass has no twiddles */
+      if (s * r == m)
+      {
+         l->twiddle[i] = 0;
+         break;
+      }
+
+      l->twiddle[i] = (float*)speex_alloc(2 * (r - 1) * h * sizeof(float));
+      for (j = 1; j < r; j++)
+      {
+         for (k = 0; k < h; k++)
+         {
+            double a = -2 * M_PI * j * (k / s) / len;
+            l->twiddle[i][(2 * j - 2) * h + k] = cos(a);
+            l->twiddle[i][(2 * j - 1) * h + k] = sin(a);
+         }
+      }
+      s *= r;
+   }
+
+   l->post = (float*)speex_alloc(2 * m * sizeof(float));
+   for (k = 0; k < m; k++)
+   {
+      l->post[k] = cos(2 * M_PI * k / n);
+      l->post[m + k] = sin(2 * M_PI * k / n);
+   }
+
+   return 0;
+}
+
+void vecfft_clear(struct vecfft_lookup *l)
+{
+   int i;
+
+   for (i = 0; i < l->nstages; i++)
+      if (l->twiddle[i])
+         speex_free(l->twiddle[i]);
+   if (l->post)
+      speex_free(l->post);
+}
+
+void vecfft_forward(struct vecfft_lookup *l, float *data)
+{
+   int m = l->m, k;
+   const float *cs = l->post, *sn = l->post + m;
+   float work[4 * m], *zr, *zi;
+
+   for (k = 0; k < m; k += VLEN)
+   {
+      v4sf even, odd;
+
+      vload_interleaved(data + 2 * k, &even, &odd);
+      vstore(work + k, even);
+      vstore(work + m + k, odd);
+   }
+
+   zr = complex_forward(l, work, work + m, work + 2 * m, work + 3 * m);
+   zi = zr + m;
+
+   /* X[k] = E[k] + W^k O[k], E and O the transforms of the even and odd
+      samples, E[k] = (Z[k] + conj(Z[m-k]))/2 and O[k] = (Z[k] - conj(Z[m-k]))/2i */
+   data[0] = zr[0] + zi[0];
+   data[l->n - 1] = zr[0] - zi[0];
+
+   for (k = 1; k + VLEN <= m; k += VLEN)
+   {
+      v4sf ar = vload(zr + k), ai = vload(zi + k);
+      v4sf br = vreverse(vload(zr + m - k - 3)), bi = vreverse(vload(zi + m - k - 3));
+      v4sf c = vload(cs + k), s = vload(sn + k);
+      v4sf er = .5f * (ar + br), ei = .5f * (ai - bi);
+      v4sf odr = .5f * (ai + bi), odi = -.5f * (ar - br);
+
+      vstore_interleaved(data + 2 * k - 1, er + c * odr + s * odi, ei + c * odi - s * odr);
+   }
+   for (; k < m; k++)
+   {
+      float er = .5f * (zr[k] + zr[m - k]), ei = .5f * (zi[k] - zi[m - k]);
+      float odr = .5f * (zi[k] + zi[m - k]), odi = -.5f * (zr[k] - zr[m - k]);
+
+      data[2 * k - 1] = er + cs[k] * odr + sn[k] * odi;
+      data[2 * k] = ei + cs[k] * odi - sn[k] * odr;
+   }
+}
+
+void vecfft_backward(struct vecfft_lookup *l, float *data)
+{
+   int m = l->m, k;
+   const float *cs = l->post, *sn = l->post + m;
+   float work[4 * m], *ur = work, *ui = work + m, *w;
+
+   /* 2 Z[k] = X[k] + conj(X[m-k]) + i W^-k (X[k] - conj(X[m-k])), inverse
+      transformed by the forward transform with re and im swapped */
+   ui[0] = data[0] + data[l->n - 1];
+   ur[0] = data[0] - data[l->n - 1];
+
+   for (k = 1; k + VLEN <= m; k += VLEN)
+   {
+      v4sf ar, ai, br, bi, dr, di, tr, ti;
+      v4sf c = vload(cs + k), s = vload(sn + k);
+
+      vload_interleaved(data + 2 * k - 1, &ar, &ai);
+      vload_interleaved(data + 2 * (m - k - 3) - 1, &br, &bi);
+      br = vreverse(br);
+      bi = -vreverse(bi);
+
+      dr = ar - br;
+      di = ai - bi;
+      tr = c * dr - s * di;
+      ti = c * di + s * dr;
+
+      vstore(ui + k, ar + br - ti);
+      vstore(ur + k, ai + bi + tr);
+   }
+   for (; k < m; k++)
+   {
+      float ar = data[2 * k - 1], ai = data[2 * k];
+      float br = data[2 * (m - k) - 1], bi = -data[2 * (m - k)];
+      float dr = ar - br, di = ai - bi;
+
+      ui[k] = ar + br - (cs[k] * di + sn[k] * dr);
+      ur[k] = ai + bi + (cs[k] * dr - sn[k] * di);
+   }
+
+   w = complex_forward(l, ur, ui, work + 2 * m, work + 3 * m);
+
+   for (k = 0; k < m; k += VLEN)
+      vstore_interleaved(data + 2 * k, vload(w + m + k), vload(w + k));
+}
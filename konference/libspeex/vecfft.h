@@ -0,0 +1,43 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * real fft on four lane float vectors, for the sizes the preprocessor uses
+ *
+ * the transforms take and return the same half complex layout as smallft's
+ * drft_forward() and drft_backward(), and are unscaled like them. unlike
+ * smallft's the lookup is only read by the transforms ( they work on the
+ * stack ) so that one can be shared by threads
+ */
+
+#ifndef VECFFT_H
+#define VECFFT_H
+
+#define VECFFT_MAX_STAGES 16
+#define VECFFT_MAX_SIZE 2048
+
+struct vecfft_lookup {
+   int n;                                /* real size */
+   int m;                                /* complex size ( n/2 ) */
+   int nstages;
+   int radix[VECFFT_MAX_STAGES];
+   float *twiddle[VECFFT_MAX_STAGES];    /* stage twiddles, per radix-1 output, re and im, per butterfly lane */
+   float *post;                          /* cos and sin of the real split, per bin */
+};
+
+/* 0 on success, -1 if n is above VECFFT_MAX_SIZE or n/2 has factors other than 2, 3 and 5 or is too small to fill the vector lanes */
+extern int vecfft_init(struct vecfft_lookup *l, int n);
+extern void vecfft_forward(struct vecfft_lookup *l, float *data);
+extern void vecfft_backward(struct vecfft_lookup *l, float *data);
+extern void vecfft_clear(struct vecfft_lookup *l);
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/* four lane float and integer vectors ( gcc vector extensions ) and the math the preprocessors need on them */
+
+#ifndef VECMATH_H
+#define VECMATH_H
+
+#include <string.h>
+#include <math.h>
+
+#define VLEN 4
+
+typedef float v4sf __attribute__((vector_size(VLEN * sizeof(float))));
+typedef int v4si __attribute__((vector_size(VLEN * sizeof(int))));
+
+/* Unaligned load and store */
+static inline v4sf vload(const float *p)
+{
+   v4sf v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static inline void vstore(float *p, v4sf v)
+{
+   memcpy(p, &v, sizeof(v));
+}
+
+static inline v4sf vset1(float a)
+{
+   return (v4sf){a, a, a, a};
+}
+
+/* Lanes in reverse order */
+static inline v4sf vreverse(v4sf a)
+{
+   return (v4sf){a[3], a[2], a[1], a[0]};
+}
+
+/* Store a0 b0 a1 b1 a2 b2 a3 b3 */
+static inline void vstore_interleaved(float *p, v4sf a, v4sf b)
+{
+   vstore(p, (v4sf){a[0], b[0], a[1], b[1]});
+   vstore(p + VLEN, (v4sf){a[2], b[2], a[3], b[3]});
+}
+
+/* Load a0 b0 a1 b1 a2 b2 a3 b3 */
+static inline void vload_interleaved(const float *p, v4sf *a, v4sf *b)
+{
+   v4sf lo = vload(p), hi = vload(p + VLEN);
+
+   *a = (v4sf){lo[0], lo[2], hi[0], hi[2]};
+   *b = (v4sf){lo[1], lo[3], hi[1], hi[3]};
+}
+
+/* The same for integer lanes */
+static inline v4si vloadi(const int *p)
+{
+   v4si v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static inline void vstorei(int *p, v4si v)
+{
+   memcpy(p, &v, sizeof(v));
+}
+
+static inline v4si vreversei(v4si a)
+{
+   return (v4si){a[3], a[2], a[1], a[0]};
+}
+
+static inline void vstorei_interleaved(int *p, v4si a, v4si b)
+{
+   vstorei(p, (v4si){a[0], b[0], a[1], b[1]});
+   vstorei(p + VLEN, (v4si){a[2], b[2], a[3], b[3]});
+}
+
+static inline void vloadi_interleaved(const int *p, v4si *a, v4si *b)
+{
+   v4si lo = vloadi(p), hi = vloadi(p + VLEN);
+
+   *a = (v4si){lo[0], lo[2], hi[0], hi[2]};
+   *b = (v4si){lo[1], lo[3], hi[1], hi[3]};
+}
+
+/* a*b >> 15 rounded, for Q15 a and |b| < 2^30, in 32 bit lanes */
+static inline v4si vmulq15(v4si a, v4si b)
+{
+   return a * (b >> 15) + ((a * (b & 0x7fff) + 16384) >> 15);
+}
+
+/* Lanes of a where mask is set, of b elsewhere */
+static inline v4sf vselect(v4si mask, v4sf a, v4sf b)
+{
+   return (v4sf)((mask & (v4si)a) | (~mask & (v4si)b));
+}
+
+static inline v4sf vmin(v4sf a, v4sf b)
+{
+   return vselect(a < b, a, b);
+}
+
+static inline v4sf vmax(v4sf a, v4sf b)
+{
+   return vselect(a > b, a, b);
+}
+
+static inline v4sf vsqrt(v4sf a)
+{
+   return (v4sf){sqrtf(a[0]), sqrtf(a[1]), sqrtf(a[2]), sqrtf(a[3])};
+}
+
+/* Floor of non huge values, as integers */
+static inline v4si vfloori(v4sf a)
+{
+   v4si i = {(int)a[0], (int)a[1], (int)a[2], (int)a[3]};
+   v4sf f = {(float)i[0], (float)i[1], (float)i[2], (float)i[3]};
+   /* truncation rounds negative values up, the mask is -1 where it did */
+   return i + (f > a);
+}
+
+/* exp(), cephes expf() polynomial, within 2 ulp of expf() */
+static inline v4sf vexp(v4sf x)
+{
+   v4si n;
+   v4sf fn, y, z;
+
+   x = vmin(vmax(x, vset1(-87.3365f)), vset1(88.3762f));
+
+   /* x = n*ln(2) + r, |r| <= ln(2)/2 */
+   n = vfloori(x * 1.44269504088896341f + .5f);
+   fn = (v4sf){(float)n[0], (float)n[1], (float)n[2], (float)n[3]};
+   x = x - fn * 0.693359375f - fn * -2.12194440e-4f;
+
+   z = x * x;
+   y = vset1(1.9875691500E-4f);
+   y = y * x + 1.3981999507E-3f;
+   y = y * x + 8.3334519073E-3f;
+   y = y * x + 4.1665795894E-2f;
+   y = y * x + 1.6666665459E-1f;
+   y = y * x + 5.0000001201E-1f;
+   y = y * z + x + 1.f;
+
+   /* scale by 2^n */
+   return y * (v4sf)((n + 127) << 23);
+}
+
+/* log() of positive normal values, cephes logf() polynomial */
+static inline v4sf vlog(v4sf x)
+{
+   v4si bits = (v4si)x, e, small;
+   v4sf m, fe, y, z;
+
+   /* x = m*2^e, .5 <= m < 1 */
+   e = ((bits >> 23) & 0xff) - 126;
+   m = (v4sf)((bits & 0x007fffff) | 0x3f000000);
+
+   /* fold m into [sqrt(.5), sqrt(2)) */
+   small = m < .707106781186547524f;
+   e = e + small;
+   m = m + vselect(small, m, vset1(0.f)) - 1.f;
+   fe = (v4sf){(float)e[0], (float)e[1], (float)e[2], (float)e[3]};
+
+   z = m * m;
+   y = vset1(7.0376836292E-2f);
+   y = y * m - 1.1514610310E-1f;
+   y = y * m + 1.1676998740E-1f;
+   y = y * m - 1.2420140846E-1f;
+   y = y * m + 1.4249322787E-1f;
+   y = y * m - 1.6668057665E-1f;
+   y = y * m + 2.0000714765E-1f;
+   y = y * m - 2.4999993993E-1f;
+   y = y * m + 3.3333331174E-1f;
+   y = y * m * z;
+
+   y = y + fe * -2.12194440e-4f - .5f * z;
+   return m + y + fe * 0.693359375f;
+}
+
+#endif
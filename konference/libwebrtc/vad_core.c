@@ -652,3 +652,58 @@ int WebRtcVad_CalcVad8khz(VadInstT* inst, int16_t* speech_frame,
 
     return inst->vad;
 }
+
+void WebRtcVad_CalcVad8khzBatch(VadInstT** insts,
+                                int16_t* const* speech_frames,
+                                int count, int frame_length, int* vads)
+{
+    int16_t feature_vectors[kBatchLanes][kNumChannels];
+    int16_t total_power[kBatchLanes];
+    int i, lanes;
+
+    for (; count > 0; count -= lanes, insts += lanes, speech_frames += lanes,
+         vads += lanes)
+    {
+        lanes = count < kBatchLanes ? count : kBatchLanes;
+
+        // Get power in the bands of a batch of instances
+        WebRtcVad_CalculateFeaturesBatch(insts, speech_frames, lanes,
+                                         frame_length, feature_vectors,
+                                         total_power);
+
+        // Make a VAD for each of them
+        for (i = 0; i < lanes; i++)
+        {
+            insts[i]->vad = GmmProbability(insts[i], feature_vectors[i],
+                                           total_power[i], frame_length);
+            vads[i] = insts[i]->vad;
+        }
+    }
+}
+
+void WebRtcVad_CalcVad16khzBatch(VadInstT** insts,
+                                 int16_t* const* speech_frames,
+                                 int count, int frame_length, int* vads)
+{
+    int16_t speechNB[kBatchLanes][240]; // Downsampled speech frames
+    int16_t* frames_nb[kBatchLanes];
+    int len = WEBRTC_SPL_RSHIFT_W16(frame_length, 1);
+    int i, lanes;
+
+    for (; count > 0; count -= lanes, insts += lanes, speech_frames += lanes,
+         vads += lanes)
+    {
+        lanes = count < kBatchLanes ? count : kBatchLanes;
+
+        // Wideband: Downsample each signal before doing VAD
+        for (i = 0; i < lanes; i++)
+        {
+            WebRtcVad_Downsampling(speech_frames[i], speechNB[i],
+                                   insts[i]->downsampling_filter_states,
+                                   frame_length);
+            frames_nb[i] = speechNB[i];
+        }
+
+        WebRtcVad_CalcVad8khzBatch(insts, frames_nb, lanes, len, vads);
+    }
+}
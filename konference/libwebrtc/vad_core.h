@@ -22,6 +22,7 @@ enum { kNumChannels = 6 };  // Number of frequency bands (named channels).
 enum { kNumGaussians = 2 };  // Number of Gaussians per channel in the GMM.
 enum { kTableSize = kNumChannels * kNumGaussians };
 enum { kMinEnergy = 10 };  // Minimum energy required to trigger audio signal.
+enum { kBatchLanes = 8 };  // Instances processed together by the batch calls.
 
 typedef struct VadInstT_
 {
@@ -107,4 +108,35 @@ int WebRtcVad_CalcVad16khz(VadInstT* inst, int16_t* speech_frame,
 int WebRtcVad_CalcVad8khz(VadInstT* inst, int16_t* speech_frame,
                           int frame_length);
 
+/****************************************************************************
+ * WebRtcVad_CalcVad8khzBatch(...)
+ *
+ * Same as WebRtcVad_CalcVad8khz() for |count| instances at once, each with
+ * its own speech frame. The filterbank runs |kBatchLanes| instances side by
+ * side and the results are identical to one call per instance.
+ *
+ * Input:
+ *      - insts         : Instances, initialized
+ *      - speech_frames : Input speech frame of each instance
+ *      - count         : Number of instances
+ *      - frame_length  : Number of input samples, the same for all frames
+ *
+ * Output:
+ *      - insts         : Updated filter states etc.
+ *      - vads          : VAD decision of each instance
+ */
+void WebRtcVad_CalcVad8khzBatch(VadInstT** insts,
+                                int16_t* const* speech_frames,
+                                int count, int frame_length, int* vads);
+
+/****************************************************************************
+ * WebRtcVad_CalcVad16khzBatch(...)
+ *
+ * Same as WebRtcVad_CalcVad16khz() for |count| instances at once. Each frame
+ * is downsampled once and the 8 kHz signals are batched.
+ */
+void WebRtcVad_CalcVad16khzBatch(VadInstT** insts,
+                                 int16_t* const* speech_frames,
+                                 int count, int frame_length, int* vads);
+
 #endif  // WEBRTC_COMMON_AUDIO_VAD_VAD_CORE_H_
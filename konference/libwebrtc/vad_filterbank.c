@@ -11,6 +11,7 @@
 #include "vad_filterbank.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include "signal_processing_library.h"
 #include "typedefs.h"
@@ -141,32 +142,19 @@ static void SplitFilter(const int16_t* data_in, int data_length,
   }
 }
 
-// Calculates the energy of |data_in| in dB, and also updates an overall
-// |total_energy| if necessary.
+// Converts an |energy| scaled down by |tot_rshifts| to dB, and also updates an
+// overall |total_energy| if necessary.
 //
-// - data_in      [i]   : Input audio data for energy calculation.
-// - data_length  [i]   : Length of input data.
+// - energy       [i]   : Energy, as returned by WebRtcSpl_Energy().
+// - tot_rshifts  [i]   : Scale factor, as returned by WebRtcSpl_Energy().
 // - offset       [i]   : Offset value added to |log_energy|.
-// - total_energy [i/o] : An external energy updated with the energy of
-//                        |data_in|.
+// - total_energy [i/o] : An external energy updated with |energy|.
 //                        NOTE: |total_energy| is only updated if
 //                        |total_energy| <= |kMinEnergy|.
-// - log_energy   [o]   : 10 * log10("energy of |data_in|") given in Q4.
-static void LogOfEnergy(const int16_t* data_in, int data_length,
-                        int16_t offset, int16_t* total_energy,
-                        int16_t* log_energy) {
-  // |tot_rshifts| accumulates the number of right shifts performed on |energy|.
-  int tot_rshifts = 0;
-  // The |energy| will be normalized to 15 bits. We use unsigned integer because
-  // we eventually will mask out the fractional part.
-  uint32_t energy = 0;
-
-  assert(data_in != NULL);
-  assert(data_length > 0);
-
-  energy = (uint32_t) WebRtcSpl_Energy((int16_t*) data_in, data_length,
-                                       &tot_rshifts);
-
+// - log_energy   [o]   : 10 * log10(|energy|) given in Q4.
+static void LogOfScaledEnergy(uint32_t energy, int tot_rshifts,
+                              int16_t offset, int16_t* total_energy,
+                              int16_t* log_energy) {
   if (energy != 0) {
     // By construction, normalizing to 15 bits is equivalent with 17 leading
     // zeros of an unsigned 32 bit value.
@@ -244,6 +232,35 @@ static void LogOfEnergy(const int16_t* data_in, int data_length,
   }
 }
 
+// Calculates the energy of |data_in| in dB, and also updates an overall
+// |total_energy| if necessary.
+//
+// - data_in      [i]   : Input audio data for energy calculation.
+// - data_length  [i]   : Length of input data.
+// - offset       [i]   : Offset value added to |log_energy|.
+// - total_energy [i/o] : An external energy updated with the energy of
+//                        |data_in|.
+//                        NOTE: |total_energy| is only updated if
+//                        |total_energy| <= |kMinEnergy|.
+// - log_energy   [o]   : 10 * log10("energy of |data_in|") given in Q4.
+static void LogOfEnergy(const int16_t* data_in, int data_length,
+                        int16_t offset, int16_t* total_energy,
+                        int16_t* log_energy) {
+  // |tot_rshifts| accumulates the number of right shifts performed on |energy|.
+  int tot_rshifts = 0;
+  // The |energy| will be normalized to 15 bits. We use unsigned integer because
+  // we eventually will mask out the fractional part.
+  uint32_t energy = 0;
+
+  assert(data_in != NULL);
+  assert(data_length > 0);
+
+  energy = (uint32_t) WebRtcSpl_Energy((int16_t*) data_in, data_length,
+                                       &tot_rshifts);
+
+  LogOfScaledEnergy(energy, tot_rshifts, offset, total_energy, log_energy);
+}
+
 int16_t WebRtcVad_CalculateFeatures(VadInstT* self, const int16_t* data_in,
                                     int data_length, int16_t* features) {
   int16_t total_energy = 0;
@@ -332,3 +349,241 @@ int16_t WebRtcVad_CalculateFeatures(VadInstT* self, const int16_t* data_in,
 
   return total_energy;
 }
+
+// Batched filterbank.
+//
+// The samples of up to |kBatchLanes| instances are interleaved, one vector
+// lane per instance, and each filter step runs on all the lanes at once. The
+// lanes hold the int16_t values of the scalar code above widened to int32_t and
+// the narrowing casts of the scalar code are done with SIGN_EXTEND_16(), so
+// the results are bit exact. Where the compiler supports it the batch is built
+// for AVX2, SSE4.1 and the baseline, and the loader picks the best one.
+
+typedef int32_t VadLanes __attribute__((vector_size(sizeof(int32_t) *
+                                                    kBatchLanes)));
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 6 && \
+    defined(__x86_64__) && defined(__linux__)
+#define BATCH_TARGETS \
+    __attribute__((target_clones("avx2", "sse4.1", "default")))
+#else
+#define BATCH_TARGETS
+#endif
+
+// The kernels are inlined into each target of the batch.
+#define BATCH_INLINE static __inline __attribute__((always_inline))
+
+// (int16_t) cast of each lane.
+#define SIGN_EXTEND_16(v) (((v) << 16) >> 16)
+
+// HighPassFilter() on all lanes.
+BATCH_INLINE void HighPassFilterBatch(const VadLanes* data_in, int data_length,
+                                      VadLanes* filter_state,
+                                      VadLanes* data_out) {
+  int i;
+  VadLanes tmp32;
+
+  for (i = 0; i < data_length; i++) {
+    // All-zero section (filter coefficients in Q14).
+    tmp32 = kHpZeroCoefs[0] * data_in[i];
+    tmp32 += kHpZeroCoefs[1] * filter_state[0];
+    tmp32 += kHpZeroCoefs[2] * filter_state[1];
+    filter_state[1] = filter_state[0];
+    filter_state[0] = data_in[i];
+
+    // All-pole section (filter coefficients in Q14).
+    tmp32 -= kHpPoleCoefs[1] * filter_state[2];
+    tmp32 -= kHpPoleCoefs[2] * filter_state[3];
+    filter_state[3] = filter_state[2];
+    filter_state[2] = SIGN_EXTEND_16(tmp32 >> 14);
+    data_out[i] = filter_state[2];
+  }
+}
+
+// AllPassFilter() on all lanes.
+BATCH_INLINE void AllPassFilterBatch(const VadLanes* data_in, int data_length,
+                                     int16_t filter_coefficient,
+                                     VadLanes* filter_state,
+                                     VadLanes* data_out) {
+  int i;
+  VadLanes tmp16;
+  VadLanes state32 = *filter_state << 16;  // Q15
+
+  for (i = 0; i < data_length; i++) {
+    tmp16 = (state32 + filter_coefficient * *data_in) >> 16;  // Q(-1)
+    *data_out++ = tmp16;
+    state32 = *data_in << 14;  // Q14
+    state32 -= filter_coefficient * tmp16;  // Q14
+    state32 <<= 1;  // Q15.
+    data_in += 2;
+  }
+
+  *filter_state = state32 >> 16;  // Q(-1)
+}
+
+// SplitFilter() on all lanes.
+BATCH_INLINE void SplitFilterBatch(const VadLanes* data_in, int data_length,
+                                   VadLanes* upper_state,
+                                   VadLanes* lower_state,
+                                   VadLanes* hp_data_out,
+                                   VadLanes* lp_data_out) {
+  int i;
+  int half_length = data_length >> 1;  // Downsampling by 2.
+  VadLanes tmp_out;
+
+  // All-pass filtering upper branch.
+  AllPassFilterBatch(&data_in[0], half_length, kAllPassCoefsQ15[0],
+                     upper_state, hp_data_out);
+
+  // All-pass filtering lower branch.
+  AllPassFilterBatch(&data_in[1], half_length, kAllPassCoefsQ15[1],
+                     lower_state, lp_data_out);
+
+  // Make LP and HP signals.
+  for (i = 0; i < half_length; i++) {
+    tmp_out = hp_data_out[i];
+    hp_data_out[i] = SIGN_EXTEND_16(hp_data_out[i] - lp_data_out[i]);
+    lp_data_out[i] = SIGN_EXTEND_16(lp_data_out[i] + tmp_out);
+  }
+}
+
+// LogOfEnergy() of the first |count| lanes, written to |band| of |features|.
+// The energy is calculated as in WebRtcSpl_Energy().
+BATCH_INLINE void LogOfEnergyBatch(const VadLanes* data_in, int data_length,
+                                   int16_t offset, int count,
+                                   int16_t* total_energy,
+                                   int16_t features[][kNumChannels],
+                                   int band) {
+  int i, lane;
+  int nbits = WebRtcSpl_GetSizeInBits(data_length);
+  VadLanes sign, sabs, larger;
+  VadLanes scaling = { 0 };
+  VadLanes energy = { 0 };
+  VadLanes smax = scaling - 1;
+
+  // Maximum absolute value of each lane, as in WebRtcSpl_GetScalingSquare().
+  for (i = 0; i < data_length; i++) {
+    sign = data_in[i] >> 31;
+    sabs = SIGN_EXTEND_16((data_in[i] ^ sign) - sign);
+    larger = sabs > smax;
+    smax = (sabs & larger) | (smax & ~larger);
+  }
+
+  for (lane = 0; lane < kBatchLanes; lane++) {
+    int t = WebRtcSpl_NormW32(smax[lane] * smax[lane]);
+    if (smax[lane] != 0 && t <= nbits) {
+      scaling[lane] = nbits - t;
+    }
+  }
+
+  for (i = 0; i < data_length; i++) {
+    energy += (data_in[i] * data_in[i]) >> scaling;
+  }
+
+  for (lane = 0; lane < count; lane++) {
+    LogOfScaledEnergy((uint32_t) energy[lane], scaling[lane], offset,
+                      &total_energy[lane], &features[lane][band]);
+  }
+}
+
+BATCH_TARGETS
+void WebRtcVad_CalculateFeaturesBatch(VadInstT** selves,
+                                      int16_t* const* data_in,
+                                      int count, int data_length,
+                                      int16_t features[][kNumChannels],
+                                      int16_t* total_energy) {
+  // As in WebRtcVad_CalculateFeatures(), for the lanes.
+  VadLanes in_240[240];
+  VadLanes hp_120[120], lp_120[120];
+  VadLanes hp_60[60], lp_60[60];
+  VadLanes upper_state[5], lower_state[5], hp_filter_state[4];
+  const int half_data_length = data_length >> 1;
+  int length = half_data_length;
+  int i, lane;
+
+  assert(count > 0);
+  assert(count <= kBatchLanes);
+  assert(data_length >= 0);
+  assert(data_length <= 240);
+
+  // Interleave the samples and filter states, the unused lanes are zero.
+  memset(in_240, 0, sizeof(VadLanes) * data_length);
+  memset(upper_state, 0, sizeof(upper_state));
+  memset(lower_state, 0, sizeof(lower_state));
+  memset(hp_filter_state, 0, sizeof(hp_filter_state));
+
+  for (lane = 0; lane < count; lane++) {
+    for (i = 0; i < data_length; i++) {
+      in_240[i][lane] = data_in[lane][i];
+    }
+    for (i = 0; i < 5; i++) {
+      upper_state[i][lane] = selves[lane]->upper_state[i];
+      lower_state[i][lane] = selves[lane]->lower_state[i];
+    }
+    for (i = 0; i < 4; i++) {
+      hp_filter_state[i][lane] = selves[lane]->hp_filter_state[i];
+    }
+    total_energy[lane] = 0;
+  }
+
+  // Split at 2000 Hz and downsample.
+  SplitFilterBatch(in_240, data_length, &upper_state[0], &lower_state[0],
+                   hp_120, lp_120);
+
+  // For the upper band (2000 Hz - 4000 Hz) split at 3000 Hz and downsample.
+  SplitFilterBatch(hp_120, length, &upper_state[1], &lower_state[1],
+                   hp_60, lp_60);
+
+  // Energy in 3000 Hz - 4000 Hz and in 2000 Hz - 3000 Hz.
+  length >>= 1;
+  LogOfEnergyBatch(hp_60, length, kOffsetVector[5], count, total_energy,
+                   features, 5);
+  LogOfEnergyBatch(lp_60, length, kOffsetVector[4], count, total_energy,
+                   features, 4);
+
+  // For the lower band (0 Hz - 2000 Hz) split at 1000 Hz and downsample.
+  length = half_data_length;
+  SplitFilterBatch(lp_120, length, &upper_state[2], &lower_state[2],
+                   hp_60, lp_60);
+
+  // Energy in 1000 Hz - 2000 Hz.
+  length >>= 1;
+  LogOfEnergyBatch(hp_60, length, kOffsetVector[3], count, total_energy,
+                   features, 3);
+
+  // For the lower band (0 Hz - 1000 Hz) split at 500 Hz and downsample.
+  SplitFilterBatch(lp_60, length, &upper_state[3], &lower_state[3],
+                   hp_120, lp_120);
+
+  // Energy in 500 Hz - 1000 Hz.
+  length >>= 1;
+  LogOfEnergyBatch(hp_120, length, kOffsetVector[2], count, total_energy,
+                   features, 2);
+
+  // For the lower band (0 Hz - 500 Hz) split at 250 Hz and downsample.
+  SplitFilterBatch(lp_120, length, &upper_state[4], &lower_state[4],
+                   hp_60, lp_60);
+
+  // Energy in 250 Hz - 500 Hz.
+  length >>= 1;
+  LogOfEnergyBatch(hp_60, length, kOffsetVector[1], count, total_energy,
+                   features, 1);
+
+  // Remove 0 Hz - 80 Hz, by high pass filtering the lower band.
+  HighPassFilterBatch(lp_60, length, hp_filter_state, hp_120);
+
+  // Energy in 80 Hz - 250 Hz.
+  LogOfEnergyBatch(hp_120, length, kOffsetVector[0], count, total_energy,
+                   features, 0);
+
+  // Deinterleave the filter states.
+  for (lane = 0; lane < count; lane++) {
+    for (i = 0; i < 5; i++) {
+      selves[lane]->upper_state[i] = (int16_t) upper_state[i][lane];
+      selves[lane]->lower_state[i] = (int16_t) lower_state[i][lane];
+    }
+    for (i = 0; i < 4; i++) {
+      selves[lane]->hp_filter_state[i] = (int16_t) hp_filter_state[i][lane];
+    }
+  }
+}
@@ -41,4 +41,20 @@
 int16_t WebRtcVad_CalculateFeatures(VadInstT* self, const int16_t* data_in,
                                     int data_length, int16_t* features);
 
+// Same as WebRtcVad_CalculateFeatures() for up to |kBatchLanes| instances.
+// The samples of the instances are interleaved, one vector lane per instance,
+// so that the filters run on all of them at once.
+//
+// - selves       [i/o] : State information of the VADs.
+// - data_in      [i]   : Input audio data of each VAD.
+// - count        [i]   : Number of VADs, 1 to |kBatchLanes|.
+// - data_length  [i]   : Audio data size, in number of samples.
+// - features     [o]   : Features of each VAD.
+// - total_energy [o]   : Total energy of each VAD.
+void WebRtcVad_CalculateFeaturesBatch(VadInstT** selves,
+                                      int16_t* const* data_in,
+                                      int count, int data_length,
+                                      int16_t features[][kNumChannels],
+                                      int16_t* total_energy);
+
 #endif  // WEBRTC_COMMON_AUDIO_VAD_VAD_FILTERBANK_H_
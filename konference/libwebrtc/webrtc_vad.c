@@ -104,6 +104,59 @@ int WebRtcVad_Process(VadInst* handle, int fs, int16_t* audio_frame,
   return vad;
 }
 
+int WebRtcVad_ProcessBatch(VadInst** handles, int count, int fs,
+                           int16_t* const* audio_frames, int frame_length,
+                           int* vads) {
+  VadInstT** selves = (VadInstT**) handles;
+  int i;
+
+  if (handles == NULL || audio_frames == NULL || vads == NULL) {
+    return -1;
+  }
+  if (WebRtcVad_ValidRateAndFrameLength(fs, frame_length) != 0) {
+    return -1;
+  }
+  for (i = 0; i < count; i++) {
+    if (selves[i] == NULL || selves[i]->init_flag != kInitCheck ||
+        audio_frames[i] == NULL) {
+      return -1;
+    }
+  }
+
+  if (fs == 8000 || fs == 16000) {
+    if (fs == 8000) {
+      WebRtcVad_CalcVad8khzBatch(selves, audio_frames, count, frame_length,
+                                 vads);
+    } else {
+      WebRtcVad_CalcVad16khzBatch(selves, audio_frames, count, frame_length,
+                                  vads);
+    }
+    for (i = 0; i < count; i++) {
+      if (vads[i] > 0) {
+        vads[i] = 1;
+      }
+    }
+  } else {
+    for (i = 0; i < count; i++) {
+      vads[i] = WebRtcVad_Process(handles[i], fs, audio_frames[i],
+                                  frame_length);
+    }
+  }
+
+  return 0;
+}
+
+void WebRtcVad_Prefetch(VadInst* handle) {
+#if defined(__GNUC__)
+  const char* self = (const char*) handle;
+  size_t i;
+
+  for (i = 0; i < sizeof(VadInstT); i += 64) {
+    __builtin_prefetch(self + i, 1);
+  }
+#endif
+}
+
 int WebRtcVad_ValidRateAndFrameLength(int rate, int frame_length) {
   int return_value = -1;
   size_t i;
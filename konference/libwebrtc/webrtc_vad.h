@@ -74,6 +74,30 @@ int WebRtcVad_set_mode(VadInst* handle, int mode);
 int WebRtcVad_Process(VadInst* handle, int fs, int16_t* audio_frame,
                       int frame_length);
 
+// Calculates the VAD decisions of |count| instances, each for its own audio
+// frame. At 8000 and 16000 Hz the instances are processed |kBatchLanes| at a
+// time, with the same results as one WebRtcVad_Process() call per instance.
+//
+// - handles      [i/o] : VAD Instances. Need to be initialized by
+//                        WebRtcVad_Init() before call.
+// - count        [i]   : Number of instances.
+// - fs           [i]   : Sampling frequency (Hz): 8000, 16000, or 32000
+// - audio_frames [i]   : Audio frame buffer of each instance.
+// - frame_length [i]   : Length of the audio frames in number of samples.
+// - vads         [o]   : Decision of each instance, 1 - (Active Voice),
+//                        0 - (Non-active Voice)
+//
+// returns              : 0 - (OK), -1 - (Error)
+int WebRtcVad_ProcessBatch(VadInst** handles, int count, int fs,
+                           int16_t* const* audio_frames, int frame_length,
+                           int* vads);
+
+// Starts loading the state of a VAD instance into the cache, ahead of its
+// WebRtcVad_ProcessBatch() call.
+//
+// - handle       [i]   : VAD Instance.
+void WebRtcVad_Prefetch(VadInst* handle);
+
 // Checks for valid combinations of |rate| and |frame_length|. We support 10,
 // 20 and 30 ms frames and the rates 8000, 16000 and 32000 Hz.
 //
@@ -20,8 +20,13 @@
 #include "asterisk/autoconfig.h"
 #include "member.h"
 #include "frame.h"
+#include "slab.h"
+#include "trans.h"
+#include "sound.h"
 
 #include "asterisk/musiconhold.h"
+#include "asterisk/ulaw.h"
+#include "asterisk/alaw.h"
 
 #ifdef	CACHE_CONTROL_BLOCKS
 AST_MUTEX_DEFINE_STATIC(mbrblocklist_lock);
@@ -33,6 +38,254 @@ AST_MUTEX_DEFINE_STATIC(speaker_scoreboard_lock);
 
 #endif
 
+// mutex for synchronizing the mixer threads' silent frame translations
+AST_MUTEX_DEFINE_STATIC(silent_frame_lock);
+
+// frame ring functions
+static int frameq_put(ast_conf_frameq *q, struct ast_frame *fr);
+static struct ast_frame *frameq_get(ast_conf_frameq *q);
+#if	AST_CONF_SOUND_READERS || AST_CONF_JITTER_BUFFER
+static unsigned int frameq_depth(ast_conf_frameq *q);
+#endif
+#if	AST_CONF_JITTER_BUFFER
+static struct ast_frame *frameq_peek(ast_conf_frameq *q);
+
+// jitter buffer functions
+static void jitter_buffer_arrival(ast_conf_member *member);
+static struct ast_frame *jitter_buffer_get(ast_conf_member *member);
+#endif
+#if	AST_CONF_SOUND_READERS
+
+// sound reader threads
+static pthread_t sound_readers[AST_CONF_SOUND_READERS];
+static int sound_reader_count;
+static int sound_readers_stopping;
+
+// members waiting for a sound reader
+static ast_conf_member *prefetch_queue;
+static ast_conf_member *prefetch_queue_last;
+AST_MUTEX_DEFINE_STATIC(prefetch_lock);
+static ast_cond_t prefetch_work;
+static ast_cond_t prefetch_idle;
+
+// frames read ahead, sound files opened and frames played without one ready
+static unsigned int prefetch_frames;
+static unsigned int prefetch_opens;
+static unsigned int prefetch_underruns;
+#endif
+
+static void add_spoken_frame(ast_conf_tick *tick, conf_frame *cfr, conf_frame **spoken_frames, int *listener_count, int *speaker_count);
+
+// mean amplitude of an incoming voice frame, -1 if it can't be estimated
+static int mean_amplitude(int format_index, const struct ast_frame *f)
+{
+#if	ASTERISK_SRC_VERSION == 104
+	const void *data = f->data;
+#else
+	const void *data = f->data.ptr;
+#endif
+	int i, energy = 0;
+
+	switch (format_index)
+	{
+		case AC_CONF_INDEX:
+#ifdef	AC_USE_G722
+		case AC_SLINEAR_INDEX:
+#endif
+			for (i = 0; i < f->samples; ++i)
+				energy += abs(((short*)data)[i]);
+			break;
+		case AC_ULAW_INDEX:
+			for (i = 0; i < f->samples; ++i)
+				energy += abs(AST_MULAW(((unsigned char*)data)[i]));
+			break;
+		case AC_ALAW_INDEX:
+			for (i = 0; i < f->samples; ++i)
+				energy += abs(AST_ALAW(((unsigned char*)data)[i]));
+			break;
+		default:
+			return -1;
+	}
+
+	return energy / f->samples;
+}
+
+// estimate the speech energy of an incoming voice frame for max_speakers ranking
+static void update_speech_energy(ast_conf_member *member, const struct ast_frame *f)
+{
+	int energy;
+
+	if (f->samples <= 0)
+		return;
+
+	if ((energy = mean_amplitude(member->read_format_index, f)) < 0)
+	{
+		// no cheap estimate for this codec, so the member is always mixed
+		member->speech_energy = -1;
+		return;
+	}
+
+	// peak held and decayed by an eighth per frame
+	member->speech_energy = energy > member->speech_energy ? energy : member->speech_energy - member->speech_energy / 8;
+}
+
+#if	SILDET == 1 || SILDET == 2
+// apply the preprocessor's outcome for a frame, returns 1 if the frame is silent
+// ( run by the mixer with libwebrtc, so the state change is reported by the member thread )
+static int member_vad_is_silent(ast_conf_member *member, int voice)
+{
+	int ignore = __atomic_load_n(&member->ignore_vad_result, __ATOMIC_RELAXED);
+
+	if (!voice)
+	{
+		//
+		// we ignore the preprocessor's outcome if we've seen voice frames
+		// in within the last AST_CONF_FRAMES_TO_SKIP frames
+		//
+
+		if (ignore > 0)
+		{
+			// skip speex_preprocess(), and decrement counter
+			__atomic_store_n(&member->ignore_vad_result, --ignore, __ATOMIC_RELAXED);
+			if (!ignore)
+				__atomic_store_n(&member->vad_speaking, 0, __ATOMIC_RELAXED);
+		}
+		else
+		{
+			// silent frame
+			return 1;
+		}
+	}
+	else
+	{
+		if (!ignore)
+			__atomic_store_n(&member->vad_speaking, 1, __ATOMIC_RELAXED);
+
+		// voice detected, reset skip count
+		__atomic_store_n(&member->ignore_vad_result, AST_CONF_FRAMES_TO_IGNORE, __ATOMIC_RELAXED);
+	}
+
+	return 0;
+}
+
+// report a change of the member's speaking state, called by the member thread
+static void member_vad_report(ast_conf_member *member)
+{
+	int speaking = __atomic_load_n(&member->vad_speaking, __ATOMIC_RELAXED);
+
+	if (speaking == member->vad_reported)
+		return;
+
+	member->vad_reported = speaking;
+
+#if	defined(SPEAKER_SCOREBOARD) && defined(CACHE_CONTROL_BLOCKS)
+	*(speaker_scoreboard + member->score_id) = speaking ? '\x01' : '\x00';
+#else
+	char workspace[1024];
+	char *varval = "<unknown>";
+	get_unison_event_server_node_variable(member->chan, &varval, workspace, sizeof(workspace));
+
+	manager_event(
+		EVENT_FLAG_CONF,
+		"ConferenceState",
+		"Channel: %s\r\n"
+		"UnisonEventServerNode: %s\r\n"
+		"Flags: %s\r\n"
+		"State: %s\r\n",
+#if	ASTERISK_SRC_VERSION < 1100
+		member->chan->name,
+#else
+		ast_channel_name(member->chan),
+#endif
+		S_OR(varval, ""),
+		member->flags,
+		speaking ? "speaking" : "silent"
+	);
+#endif
+}
+#endif
+
+#if	(SILDET == 1 || SILDET == 2) && AST_CONF_VAD_GATE
+// energy pre-gate, returns 1 if a silent member's frame is too quiet to be worth preprocessing
+static int member_vad_gate(ast_conf_member *member, const struct ast_frame *f)
+{
+#if	ASTERISK_SRC_VERSION == 104
+	const short *samples = f->data;
+#else
+	const short *samples = f->data.ptr;
+#endif
+	long long energy = 0;
+	int i;
+
+	if (f->samples <= 0)
+		return 0;
+
+	// mean square of the samples
+	for (i = 0; i < f->samples; ++i)
+		energy += samples[i] * samples[i];
+
+	float level = (float)energy / f->samples;
+
+	// the noise floor drops to quieter frames at once and rises slowly
+	if (level < member->vad_floor)
+		member->vad_floor = level;
+	else
+		member->vad_floor += (level - member->vad_floor) / AST_CONF_VAD_GATE_RISE;
+
+	member->vad_frames++;
+
+	// frames of a speaking member, loud frames, frames above the floor and every nth frame pass
+	if (__atomic_load_n(&member->ignore_vad_result, __ATOMIC_RELAXED) > 0
+		|| level > AST_CONF_VAD_GATE_CEILING
+		|| level > member->vad_floor * powf(10.0f, AST_CONF_VAD_GATE / 10.0f)
+		|| ++member->vad_gate_run == AST_CONF_VAD_GATE_FEED)
+	{
+		member->vad_gate_run = 0;
+		return 0;
+	}
+
+	member->vad_gated++;
+
+	return 1;
+}
+#endif
+
+#if	AST_CONF_MEMBER_CODECS
+// decode an incoming frame to the conference format and queue it
+static void queue_decoded_frame(ast_conf_member *member, ast_conference *conf, struct ast_frame *f)
+{
+	ast_conf_sharedframe *sf = NULL;
+	struct ast_frame *df;
+
+#ifndef	AC_USE_G722
+	if (member->decode_format_index == AC_ULAW_INDEX || member->decode_format_index == AC_ALAW_INDEX)
+		sf = decode_g711_frame(f, member->decode_format_index);
+#endif
+	if (!(df = sf ? &sf->fr : convert_frame(member->to_conference, f, 0)))
+	{
+#if	ASTERISK_SRC_VERSION < 1100
+		ast_log(LOG_WARNING, "unable to translate incoming frame, channel => %s\n", member->chan->name);
+#else
+		ast_log(LOG_WARNING, "unable to translate incoming frame, channel => %s\n", ast_channel_name(member->chan));
+#endif
+		return;
+	}
+
+	if (conf->max_speakers)
+		update_speech_energy(member, df);
+
+	if (!sf)
+	{
+		queue_incoming_frame(member, df);
+	}
+	else if (frameq_put(&member->incomingq, df))
+	{
+		// the decoded frame is a slab copy, so queue it as is
+		release_shared_frame(df);
+	}
+}
+#endif
+
 // process an incoming frame.  Returns 0 normally, 1 if hangup was received.
 static int process_incoming(ast_conf_member *member, ast_conference *conf, struct ast_frame *f)
 {
@@ -48,9 +301,11 @@ static int process_incoming(ast_conf_member *member, ast_conference *conf, struc
 				ast_frfree(f);
 				return 0;
 			}
+#if	AST_CONF_JITTER_BUFFER
+			// every voice frame counts, including the ones gated or decoded below
+			jitter_buffer_arrival(member);
+#endif
 #if	SILDET == 1 || SILDET == 2
-			// reset silence detection flag
-			int is_silent_frame = 0;
 			//
 			// make sure we have a valid dsp and frame type
 			//
@@ -58,99 +313,39 @@ static int process_incoming(ast_conf_member *member, ast_conference *conf, struc
 			{
 				// send the frame to the preprocessor
 				f = convert_frame(member->to_dsp, f, 1);
+#if	AST_CONF_VAD_GATE
 #if	SILDET == 1
-//				ast_log(LOG_NOTICE, "sample rate for webRTC:  %d\n", AST_CONF_SAMPLE_RATE);
-
-#if	ASTERISK_SRC_VERSION == 104
-				if (!WebRtcVad_Process(member->dsp, AST_CONF_SAMPLE_RATE, f->data, AST_CONF_BLOCK_SAMPLES))
-#else
-				if (!WebRtcVad_Process(member->dsp, AST_CONF_SAMPLE_RATE, f->data.ptr, AST_CONF_BLOCK_SAMPLES))
-#endif // ASTERISK_SRC_VERSION == 104
-
+				if (member_vad_gate(member, f))
 #elif	SILDET == 2
-#if	ASTERISK_SRC_VERSION == 104
-				if (!speex_preprocess(member->dsp, f->data, NULL))
-#else
-				if (!speex_preprocess(member->dsp, f->data.ptr, NULL))
+				if (member->vad_flag && member_vad_gate(member, f))
 #endif
+					break;
 #endif
-				{
-					//
-					// we ignore the preprocessor's outcome if we've seen voice frames
-					// in within the last AST_CONF_FRAMES_TO_SKIP frames
-					//
-
-					if (member->ignore_vad_result > 0)
-					{
-						// skip speex_preprocess(), and decrement counter
-						if (!--member->ignore_vad_result) {
-#if	defined(SPEAKER_SCOREBOARD) && defined(CACHE_CONTROL_BLOCKS)
-							*(speaker_scoreboard + member->score_id) = '\x00';
-#else
-							char workspace[1024];
-							char *varval = "<unknown>";
-							get_unison_event_server_node_variable(member->chan, &varval, workspace, sizeof(workspace));
-
-							manager_event(
-								EVENT_FLAG_CONF,
-								"ConferenceState",
-								"Channel: %s\r\n"
-								"UnisonEventServerNode: %s\r\n"
-								"Flags: %s\r\n"
-								"State: %s\r\n",
-#if	ASTERISK_SRC_VERSION < 1100
-								member->chan->name,
-#else
-								ast_channel_name(member->chan),
-#endif
-								S_OR(varval, ""),
-								member->flags,
-								"silent"
-							);
-#endif
-						}
-					}
-					else
-					{
-						// set silent_frame flag
-						is_silent_frame = 1;
-					}
-				}
-				else
-				{
-					if (!member->ignore_vad_result) {
-#if	defined(SPEAKER_SCOREBOARD) && defined(CACHE_CONTROL_BLOCKS)
-						*(speaker_scoreboard + member->score_id) = '\x01';
-#else
-						char workspace[1024];
-						char *varval = "<unknown>";
-						get_unison_event_server_node_variable(member->chan, &varval, workspace, sizeof(workspace));
-
-						manager_event(
-							EVENT_FLAG_CONF,
-							"ConferenceState",
-							"Channel: %s\r\n"
-							"UnisonEventServerNode: %s\r\n"
-							"Flags: %s\r\n"
-							"State: %s\r\n",
-#if	ASTERISK_SRC_VERSION < 1100
-							member->chan->name,
+#if	SILDET == 1
+				// the mixer runs the vad of its members in batches
+				queue_incoming_frame(member, f);
+				break;
+#elif	SILDET == 2
+#if	ASTERISK_SRC_VERSION == 104
+				if (member_vad_is_silent(member, speex_preprocess(member->dsp, f->data, NULL)))
 #else
-							ast_channel_name(member->chan),
+				if (member_vad_is_silent(member, speex_preprocess(member->dsp, f->data.ptr, NULL)))
 #endif
-							S_OR(varval, ""),
-							member->flags,
-							"speaking"
-						);
+					break;
 #endif
-					}
-					// voice detected, reset skip count
-					member->ignore_vad_result = AST_CONF_FRAMES_TO_IGNORE;
-				}
 			}
-			if (!is_silent_frame)
 #endif
-				queue_incoming_frame(member, f);
+#if	AST_CONF_MEMBER_CODECS
+			if (member->to_conference)
+			{
+				queue_decoded_frame(member, conf, f);
+				break;
+			}
+#endif
+			if (conf->max_speakers)
+				update_speech_energy(member, f);
+
+			queue_incoming_frame(member, f);
 			break;
 		}
 		// In Asterisk 1.4 AST_FRAME_DTMF is equivalent to AST_FRAME_DTMF_END
@@ -213,38 +408,411 @@ static int process_incoming(ast_conf_member *member, ast_conference *conf, struc
 			{
 				// hangup received
 
-				// free the input frame
-				ast_frfree(f);
+				// free the input frame
+				ast_frfree(f);
+
+				// break out of the while (42)
+				return 1;
+			}
+			break;
+		}
+		case AST_FRAME_NULL:
+		{
+			if (member->kick_flag)
+			{
+				// free the input frame
+				ast_frfree(f);
+
+				// break out of the while (42)
+				return 1;
+			}
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+
+	// free the input frame
+	ast_frfree(f);
+
+	return 0;
+}
+
+#if	AST_CONF_SOUND_READERS
+//
+// sound reader functions
+//
+// the sounds queued to a member are opened, read and converted to its write
+// format ahead of time by a pool of reader threads, into a ring per sound, so
+// the member's output never waits for the filesystem
+//
+
+// finish a sound, called by the member thread once no reader has it
+static void finish_sound(ast_conf_member *member, ast_conf_soundq *sound)
+{
+	struct ast_frame *f;
+
+	while ((f = frameq_get(&sound->frames)))
+		release_shared_frame(f);
+
+	if (sound->stream)
+	{
+		ast_closestream(sound->stream);
+#ifdef	SOUND_COMPLETE_EVENTS
+		// notify applications via mgr interface that this sound has been played
+		manager_event(
+			EVENT_FLAG_CONF,
+			"ConferenceSoundComplete",
+			"Channel: %s\r\n"
+			"Sound: %s\r\n",
+#if	ASTERISK_SRC_VERSION < 1100
+			member->chan->name,
+#else
+			ast_channel_name(member->chan),
+#endif
+			sound->name
+		);
+#endif
+	}
+
+	trans_free_path(sound->trans);
+
+	ast_free(sound);
+}
+
+// get the next frame from the soundq, NULL when the reader is behind
+static struct ast_frame *get_next_soundframe(ast_conf_member *member)
+{
+	ast_conf_soundq *sound;
+	struct ast_frame *f;
+
+	while ((sound = member->soundq))
+	{
+		if (!(f = frameq_get(&sound->frames)))
+		{
+			ast_mutex_lock(&member->lock);
+
+			// the reader may have finished the sound since the ring was checked
+			if (!(f = frameq_get(&sound->frames)) && (sound->reading || (!sound->eof && !sound->stopped)))
+			{
+				ast_mutex_unlock(&member->lock);
+
+				// the ring ran dry ahead of the reader
+				if (sound->started && !sound->stopped)
+				{
+					member->sound_underruns++;
+					ast_atomic_fetchadd_int((int*)&prefetch_underruns, 1);
+				}
+
+				prefetch_sounds(member);
+
+				return NULL;
+			}
+
+			if (!f)
+			{
+				if (!(member->soundq = sound->next))
+					member->muted = 0;
+
+				ast_mutex_unlock(&member->lock);
+
+				finish_sound(member, sound);
+
+				continue;
+			}
+
+			ast_mutex_unlock(&member->lock);
+		}
+
+		if (sound->stopped)
+		{
+			release_shared_frame(f);
+			continue;
+		}
+
+		sound->started = 1;
+
+		// refill the ring at half its depth
+		if ((member->sound_depth = frameq_depth(&sound->frames)) <= AST_CONF_SOUND_PREFETCH / 2)
+			prefetch_sounds(member);
+
+		return f;
+	}
+
+	member->sound_depth = 0;
+
+	return NULL;
+}
+
+// read a sound ahead into its ring, returns -1 when the ring is full
+static int read_sound(ast_conf_member *member, ast_conf_soundq *sound)
+{
+	struct ast_frame *f, *df;
+	ast_conf_sharedframe *sf;
+
+	if (!sound->stream && !sound->stopped)
+	{
+#if	ASTERISK_SRC_VERSION < 1100
+		if (!(sound->stream = open_sound(sound->name, member->chan->language)))
+#else
+		if (!(sound->stream = open_sound(sound->name, ast_channel_language(member->chan))))
+#endif
+		{
+			ast_log(LOG_NOTICE, "unable to open sound %s\n", sound->name);
+			return 0;
+		}
+
+		ast_atomic_fetchadd_int((int*)&prefetch_opens, 1);
+	}
+
+	while (sound->stream && !sound->stopped)
+	{
+		if (frameq_depth(&sound->frames) >= AST_CONF_SOUND_PREFETCH)
+		{
+			return -1;
+		}
+
+		if (!(f = ast_readframe(sound->stream)))
+		{
+			break;
+		}
+
+		if (f->frametype == AST_FRAME_VOICE)
+		{
+			// the path from the file's format to the member's write format
+			if (!sound->built)
+			{
+				sound->built = 1;
+
+#if	ASTERISK_SRC_VERSION == 104 || ASTERISK_SRC_VERSION == 106
+				sound->trans = trans_build_path(member->chan->writeformat, f->subclass);
+#elif	ASTERISK_SRC_VERSION < 1000
+				sound->trans = trans_build_path(member->chan->writeformat, f->subclass.codec);
+#elif	ASTERISK_SRC_VERSION < 1100
+				sound->trans = trans_build_path(&member->chan->writeformat, &f->subclass.format);
+#else
+				sound->trans = trans_build_path(ast_channel_writeformat(member->chan), &f->subclass.format);
+#endif
+			}
+
+			if ((df = convert_frame(sound->trans, f, 0)))
+			{
+				sf = create_shared_frame(df, ast_tv(0, 0));
+
+				// free the translator's copy
+				if (sound->trans)
+					ast_frfree(df);
+
+				if (sf)
+				{
+					frameq_put(&sound->frames, &sf->fr);
+					ast_atomic_fetchadd_int((int*)&prefetch_frames, 1);
+				}
+			}
+		}
+
+		ast_frfree(f);
+	}
+
+	return 0;
+}
+
+// read the sounds of a member ahead until their rings are full
+static void read_sounds(ast_conf_member *member)
+{
+	ast_conf_soundq *sound;
+	int full = 0;
+
+	while (!full)
+	{
+		ast_mutex_lock(&member->lock);
+
+		// the first sound not read to its end
+		for (sound = member->soundq; sound && sound->eof; sound = sound->next);
+
+		if (sound)
+			sound->reading = 1;
+
+		ast_mutex_unlock(&member->lock);
+
+		if (!sound)
+			break;
+
+		full = read_sound(member, sound);
+
+		ast_mutex_lock(&member->lock);
+		sound->reading = 0;
+		sound->eof = !full;
+		ast_mutex_unlock(&member->lock);
+	}
+}
+
+// called with prefetch_lock
+static void queue_prefetch(ast_conf_member *member)
+{
+	member->prefetch_queued = 1;
+	member->prefetch_next = NULL;
+
+	if (prefetch_queue_last)
+		prefetch_queue_last->prefetch_next = member;
+	else
+		prefetch_queue = member;
+
+	prefetch_queue_last = member;
+
+	ast_cond_signal(&prefetch_work);
+}
+
+void prefetch_sounds(ast_conf_member *member)
+{
+	ast_mutex_lock(&prefetch_lock);
+
+	if (sound_readers_stopping)
+	{
+		// no reader
+	}
+	else if (member->prefetch_busy)
+	{
+		// one reader at a time fills a member's rings
+		member->prefetch_again = 1;
+	}
+	else if (!member->prefetch_queued)
+	{
+		queue_prefetch(member);
+	}
+
+	ast_mutex_unlock(&prefetch_lock);
+}
+
+// called by delete_member(), no reader touches the member after it returns
+static void cancel_prefetch(ast_conf_member *member)
+{
+	ast_conf_member **link;
 
-				// break out of the while (42)
-				return 1;
-			}
-			break;
+	ast_mutex_lock(&prefetch_lock);
+
+	if (member->prefetch_queued)
+	{
+		for (link = &prefetch_queue; *link != member; link = &(*link)->prefetch_next);
+
+		if (!(*link = member->prefetch_next))
+		{
+			// find the new last member
+			for (prefetch_queue_last = prefetch_queue; prefetch_queue_last && prefetch_queue_last->prefetch_next; prefetch_queue_last = prefetch_queue_last->prefetch_next);
 		}
-		case AST_FRAME_NULL:
+
+		member->prefetch_queued = 0;
+	}
+
+	member->prefetch_again = 0;
+
+	while (member->prefetch_busy)
+		ast_cond_wait(&prefetch_idle, &prefetch_lock);
+
+	ast_mutex_unlock(&prefetch_lock);
+}
+
+static void *sound_reader_thread(void *data)
+{
+	ast_conf_member *member;
+
+	ast_mutex_lock(&prefetch_lock);
+
+	while (!sound_readers_stopping)
+	{
+		if (!(member = prefetch_queue))
 		{
-			if (member->kick_flag)
-			{
-				// free the input frame
-				ast_frfree(f);
+			ast_cond_wait(&prefetch_work, &prefetch_lock);
+			continue;
+		}
 
-				// break out of the while (42)
-				return 1;
-			}
-			break;
+		if (!(prefetch_queue = member->prefetch_next))
+			prefetch_queue_last = NULL;
+
+		member->prefetch_queued = 0;
+		member->prefetch_busy = 1;
+
+		ast_mutex_unlock(&prefetch_lock);
+
+		read_sounds(member);
+
+		ast_mutex_lock(&prefetch_lock);
+
+		member->prefetch_busy = 0;
+
+		if (member->prefetch_again)
+		{
+			member->prefetch_again = 0;
+			queue_prefetch(member);
 		}
-		default:
+
+		ast_cond_broadcast(&prefetch_idle);
+	}
+
+	ast_mutex_unlock(&prefetch_lock);
+
+	// return this thread's frame magazines
+	slab_thread_cleanup();
+
+	return NULL;
+}
+
+// called by conference.c:init_conference()
+void start_sound_readers(void)
+{
+	ast_cond_init(&prefetch_work, NULL);
+	ast_cond_init(&prefetch_idle, NULL);
+
+	sound_readers_stopping = 0;
+
+	for (sound_reader_count = 0; sound_reader_count < AST_CONF_SOUND_READERS; ++sound_reader_count)
+	{
+		if (ast_pthread_create(&sound_readers[sound_reader_count], NULL, sound_reader_thread, NULL))
 		{
+			ast_log(LOG_WARNING, "unable to start sound reader thread %d\n", sound_reader_count);
 			break;
 		}
 	}
+}
 
-	// free the input frame
-	ast_frfree(f);
+// called by conference.c:dealloc_conference()
+void stop_sound_readers(void)
+{
+	int i;
 
-	return 0;
+	ast_mutex_lock(&prefetch_lock);
+	sound_readers_stopping = 1;
+	ast_cond_broadcast(&prefetch_work);
+	ast_mutex_unlock(&prefetch_lock);
+
+	for (i = 0; i < sound_reader_count; ++i)
+		pthread_join(sound_readers[i], NULL);
+
+	prefetch_queue = prefetch_queue_last = NULL;
+
+	ast_cond_destroy(&prefetch_work);
+	ast_cond_destroy(&prefetch_idle);
 }
 
+// cli function
+void sound_reader_stats(int fd)
+{
+	ast_conf_member *member;
+	int queued = 0;
+
+	ast_mutex_lock(&prefetch_lock);
+
+	for (member = prefetch_queue; member; member = member->prefetch_next)
+		++queued;
+
+	ast_mutex_unlock(&prefetch_lock);
+
+	ast_cli(fd, "%-20.20s %-20.20s %-20.20s %-20.20s %-20.20s\n", "Sound Readers", "Waiting Members", "Files Opened", "Frames Read", "Underruns");
+	ast_cli(fd, "%-20d %-20d %-20u %-20u %-20u\n", sound_reader_count, queued, prefetch_opens, prefetch_frames, prefetch_underruns);
+}
+#else
 // get the next frame from the soundq
 static struct ast_frame *get_next_soundframe(ast_conf_member *member)
 {
@@ -301,6 +869,7 @@ static struct ast_frame *get_next_soundframe(ast_conf_member *member)
 	return f;
 }
 
+#endif
 
 // process outgoing frames for the channel, playing either normal conference audio,
 // or requested sounds
@@ -310,6 +879,13 @@ static void process_outgoing(ast_conf_member *member)
 
 	while ((cf = get_outgoing_frame(member)))
 	{
+		// drop frames queued before music on hold was started
+		if (!member->ready_for_outgoing)
+		{
+			release_shared_frame(cf);
+			continue;
+		}
+
 		// if we're playing sounds, we can just replace the frame with the
 		// next sound frame, and send it instead
 		if (member->soundq)
@@ -319,25 +895,71 @@ static void process_outgoing(ast_conf_member *member)
 				// use dequeued frame delivery time
 				sf->delivery = cf->delivery;
 		
-				// free voice frame
-				ast_frfree(cf);
+				// release voice frame
+				release_shared_frame(cf);
 
 				// send sound frame
 				ast_write(member->chan, sf);
 
 				// free sound frame
+#if	AST_CONF_SOUND_READERS
+				release_shared_frame(sf);
+#else
 				ast_frfree(sf);
+#endif
 
 				continue;
     			}
 		}
 
-		// send the frame
-		ast_write(member->chan, cf);
-		
-		// free voice frame
-		ast_frfree(cf);
+#if	AST_CONF_MEMBER_CODECS
+		// encode a speaker mix queued in the conference format
+#if	ASTERISK_SRC_VERSION == 104 || ASTERISK_SRC_VERSION == 106
+		if (member->from_slinear && cf->subclass == AST_FORMAT_CONFERENCE)
+#else
+		if (member->from_slinear && cf->subclass.integer == AST_FORMAT_CONFERENCE)
+#endif
+		{
+			ast_conf_sharedframe *ef = encode_frame(member->write_format_index, member->from_slinear, cf, cf->delivery);
+
+			// release voice frame
+			release_shared_frame(cf);
+
+			if (!ef)
+			{
+#if	ASTERISK_SRC_VERSION < 1100
+				ast_log(LOG_WARNING, "unable to translate outgoing speaker frame, channel => %s\n", member->chan->name);
+#else
+				ast_log(LOG_WARNING, "unable to translate outgoing speaker frame, channel => %s\n", ast_channel_name(member->chan));
+#endif
+				continue;
+			}
+
+			cf = &ef->fr;
+		}
+#endif
 
+		// audiohooks may modify the frame, so write a copy of the shared frame
+#if	ASTERISK_SRC_VERSION < 1100
+		if (member->chan->audiohooks)
+#else
+		if (ast_channel_audiohooks(member->chan))
+#endif
+		{
+			if ((sf = ast_frdup(cf)))
+			{
+				ast_write(member->chan, sf);
+				ast_frfree(sf);
+			}
+		}
+		else
+		{
+			// send the frame
+			ast_write(member->chan, cf);
+		}
+
+		// release voice frame
+		release_shared_frame(cf);
 	}
 }
 
@@ -517,6 +1139,12 @@ int member_exec(struct ast_channel* chan, const char* data)
 			break;
 		}
 
+#if	SILDET == 1 || SILDET == 2
+		// report the speaking state outside the mixer
+		if (member->dsp)
+			member_vad_report(member);
+#endif
+
 		// process outgoing frames
 		process_outgoing(member);
 	}
@@ -527,6 +1155,10 @@ int member_exec(struct ast_channel* chan, const char* data)
 	if (member->kick_flag)
 		pbx_builtin_setvar_helper(member->chan, "KONFERENCE", "KICKED");
 	remove_member(member, conf, conf_name);
+
+	// return this thread's frame magazines
+	slab_thread_cleanup();
+
 	return 0;
 }
 
@@ -577,10 +1209,8 @@ ast_conf_member* create_member(struct ast_channel *chan, const char* data, char*
 #endif
 #endif
 
-	// initialize mutexes
+	// initialize mutex
 	ast_mutex_init(&member->lock);
-	ast_mutex_init(&member->incomingq.lock);
-	ast_mutex_init(&member->outgoingq.lock);
 
 	// initialize cv
 	ast_cond_init(&member->delete_var, NULL);
@@ -589,8 +1219,10 @@ ast_conf_member* create_member(struct ast_channel *chan, const char* data, char*
 #if	SILDET == 2
 	member->vad_prob_start = AST_CONF_PROB_START;
 	member->vad_prob_continue = AST_CONF_PROB_CONTINUE;
+	member->fixed_flag = AST_CONF_SPEEX_FIXED;
 #endif
 	member->max_users = AST_CONF_MAX_USERS;
+	member->max_speakers = AST_CONF_MAX_SPEAKERS;
 
 	//
 	// initialize member with passed data values
@@ -633,6 +1265,7 @@ ast_conf_member* create_member(struct ast_channel *chan, const char* data, char*
 		static const char arg_vad_prob_continue[] = "vad_prob_continue";
 #endif
 		static const char arg_max_users[] = "max_users";
+		static const char arg_max_speakers[] = "max_speakers";
 		static const char arg_conf_type[] = "type";
 		static const char arg_chanspy[] = "spy";
 
@@ -648,6 +1281,9 @@ ast_conf_member* create_member(struct ast_channel *chan, const char* data, char*
 		if (!strncasecmp(key, arg_max_users, sizeof(arg_max_users) - 1))
 		{
 			member->max_users = strtol(value, (char **)NULL, 10);
+		} else if (!strncasecmp(key, arg_max_speakers, sizeof(arg_max_speakers) - 1))
+		{
+			member->max_speakers = strtol(value, (char **)NULL, 10);
 		} else if (!strncasecmp(key, arg_conf_type, sizeof(arg_conf_type) - 1))
 		{
 			strncpy(member->type, value, MEMBER_TYPE_LEN);
@@ -709,7 +1345,7 @@ ast_conf_member* create_member(struct ast_channel *chan, const char* data, char*
 	for (i = 0; i < strlen(flags); ++i)
 	{
 		{
-			// flags are L, l, a, T, V, D, A, R, M, x
+			// flags are L, l, a, T, V, D, A, F, R, M, x
 			switch (flags[i])
 			{
 				// mute/no_recv options
@@ -742,6 +1378,9 @@ ast_conf_member* create_member(struct ast_channel *chan, const char* data, char*
 			case 'A':
 				member->agc_flag = 1;
 				break;
+			case 'F':
+				member->fixed_flag = 1;
+				break;
 #endif
 				// dtmf/moderator options
 			case 'R':
@@ -790,7 +1429,7 @@ ast_conf_member* create_member(struct ast_channel *chan, const char* data, char*
 	{
 		// create a speex preprocessor
 
-		if ((member->dsp = speex_preprocess_state_init(AST_CONF_BLOCK_SAMPLES, AST_CONF_SAMPLE_RATE)))
+		if ((member->dsp = (member->fixed_flag ? speex_preprocess_state_init_fixed : speex_preprocess_state_init)(AST_CONF_BLOCK_SAMPLES, AST_CONF_SAMPLE_RATE)))
 		{
 			// set speex preprocessor options
 			speex_preprocess_ctl(member->dsp, SPEEX_PREPROCESS_SET_VAD, &(member->vad_flag));
@@ -811,50 +1450,89 @@ ast_conf_member* create_member(struct ast_channel *chan, const char* data, char*
 	}
 #endif
 
+#if	SILDET == 1 || SILDET == 2
+	// the pre-gate's noise floor starts at the ceiling and drops with the first quiet frame
+	member->vad_floor = AST_CONF_VAD_GATE_CEILING;
+#endif
+
+#if	SILDET == 1
+	member->vad_rate = AST_CONF_SAMPLE_RATE;
+#ifdef	AC_USE_G722
+	// narrowband members run the dsp on their 8 kHz audio, which the mixer then upsamples
+#if	ASTERISK_SRC_VERSION < 1000
+	if (chan->readformat != AST_FORMAT_SLINEAR16 && chan->readformat != AST_FORMAT_G722)
+#else
+#if	ASTERISK_SRC_VERSION < 1100
+	if (chan->readformat.id != AST_FORMAT_SLINEAR16 && chan->readformat.id != AST_FORMAT_G722)
+#else
+	if (ast_channel_readformat(chan)->id != AST_FORMAT_SLINEAR16 && ast_channel_readformat(chan)->id != AST_FORMAT_G722)
+#endif
+#endif
+		member->vad_rate = 8000;
+#endif
+#endif
+
 	// set translation paths
 #if	SILDET == 1 || SILDET == 2
+#if	SILDET == 1 && defined(AC_USE_G722)
+	if (member->dsp && member->vad_rate == 8000)
+	{
+#if	ASTERISK_SRC_VERSION < 1000
+		member->to_dsp = trans_build_path(AST_FORMAT_SLINEAR, chan->readformat);
+		member->to_slinear = trans_build_path(AST_FORMAT_CONFERENCE, AST_FORMAT_SLINEAR);
+#else
+#if	ASTERISK_SRC_VERSION >= 1100
+		member->to_dsp = trans_build_path(&ast_format_slinear, ast_channel_readformat(chan));
+#else
+		member->to_dsp = trans_build_path(&ast_format_slinear, &chan->readformat);
+#endif
+		member->to_slinear = trans_build_path(&ast_format_conference, &ast_format_slinear);
+#endif
+	}
+	else
+#endif
 	if (member->dsp)
 	{
 #if	ASTERISK_SRC_VERSION < 1000
-		member->to_dsp = ast_translator_build_path(AST_FORMAT_CONFERENCE, chan->readformat);
+		member->to_dsp = trans_build_path(AST_FORMAT_CONFERENCE, chan->readformat);
 #else
 #if	ASTERISK_SRC_VERSION >= 1100
-		member->to_dsp = ast_translator_build_path(&ast_format_conference, ast_channel_readformat(chan));
+		member->to_dsp = trans_build_path(&ast_format_conference, ast_channel_readformat(chan));
 #else
-		member->to_dsp = ast_translator_build_path(&ast_format_conference, &chan->readformat);
+		member->to_dsp = trans_build_path(&ast_format_conference, &chan->readformat);
 #endif
 #endif
 	}
 	else
 	{
 #if	ASTERISK_SRC_VERSION < 1000
-		member->to_slinear = ast_translator_build_path(AST_FORMAT_CONFERENCE, member->chan->readformat);
+		member->to_slinear = trans_build_path(AST_FORMAT_CONFERENCE, member->chan->readformat);
 #else
 #if	ASTERISK_SRC_VERSION >= 1100
-		member->to_slinear = ast_translator_build_path(&ast_format_conference, ast_channel_readformat(chan));
+		member->to_slinear = trans_build_path(&ast_format_conference, ast_channel_readformat(chan));
 #else
-		member->to_slinear = ast_translator_build_path(&ast_format_conference, &member->chan->readformat);
+		member->to_slinear = trans_build_path(&ast_format_conference, &member->chan->readformat);
 #endif
 #endif
 	}
 #else
 #if	ASTERISK_SRC_VERSION < 1000
-	member->to_slinear = ast_translator_build_path(AST_FORMAT_CONFERENCE, member->chan->readformat);
+	member->to_slinear = trans_build_path(AST_FORMAT_CONFERENCE, member->chan->readformat);
 #else
 #if	ASTERISK_SRC_VERSION >= 1100
-	member->to_slinear = ast_translator_build_path(&ast_format_conference, ast_channel_readformat(member->chan));
+	member->to_slinear = trans_build_path(&ast_format_conference, ast_channel_readformat(member->chan));
 #else
-	member->to_slinear = ast_translator_build_path(&ast_format_conference, &member->chan->readformat);
+	member->to_slinear = trans_build_path(&ast_format_conference, &member->chan->readformat);
 #endif
 #endif
 #endif
 #if	ASTERISK_SRC_VERSION < 1000
-	member->from_slinear = ast_translator_build_path(member->chan->writeformat, AST_FORMAT_CONFERENCE);
+	member->from_slinear = trans_build_path(member->chan->writeformat, AST_FORMAT_CONFERENCE);
 #else
 #if	ASTERISK_SRC_VERSION >= 1100
-	member->from_slinear = ast_translator_build_path(ast_channel_writeformat(member->chan), &ast_format_conference);
+	member->from_slinear = trans_build_path(ast_channel_writeformat(member->chan), &ast_format_conference);
 #else
-	member->from_slinear = ast_translator_build_path(&member->chan->writeformat, &ast_format_conference);
+	member->from_slinear = trans_build_path(&member->chan->writeformat, &ast_format_conference);
 #endif
 #endif
 
@@ -906,6 +1584,21 @@ ast_conf_member* create_member(struct ast_channel *chan, const char* data, char*
 			break;
 	}
 
+#if	AST_CONF_SHARED_MOH
+	// decode and encode the music on hold of the member's class now, so the
+	// conference only picks its blocks when the member is alone
+	if (!member->norecv_audio)
+	{
+#if	ASTERISK_SRC_VERSION < 1000
+		member->moh = find_moh(S_OR(member->chan->musicclass, AST_CONF_MOH_CLASS), member->write_format_index, member->chan->writeformat);
+#elif	ASTERISK_SRC_VERSION < 1100
+		member->moh = find_moh(S_OR(member->chan->musicclass, AST_CONF_MOH_CLASS), member->write_format_index, &member->chan->writeformat);
+#else
+		member->moh = find_moh(S_OR(ast_channel_musicclass(member->chan), AST_CONF_MOH_CLASS), member->write_format_index, ast_channel_writeformat(member->chan));
+#endif
+	}
+#endif
+
 	// index for converted_frames array
 #if	SILDET == 1 || SILDET == 2
 #if	ASTERISK_SRC_VERSION < 1000
@@ -965,6 +1658,29 @@ ast_conf_member* create_member(struct ast_channel *chan, const char* data, char*
 		default:
 			break;
 	}
+
+#if	SILDET == 1 && defined(AC_USE_G722)
+	// the frames of narrowband dsp members are queued in 8 kHz signed linear
+	if (member->dsp && member->vad_rate == 8000)
+		member->read_format_index = AC_SLINEAR_INDEX;
+#endif
+
+#if	AST_CONF_MEMBER_CODECS
+	// the member thread decodes its frames to the conference format, so the mixer
+	// only mixes ( the frames of dsp members are already converted for the preprocessor )
+#if	SILDET == 1 || SILDET == 2
+	if (member->to_slinear && !member->dsp)
+#else
+	if (member->to_slinear)
+#endif
+	{
+		member->to_conference = member->to_slinear;
+		member->to_slinear = NULL;
+		member->decode_format_index = member->read_format_index;
+		member->read_format_index = AC_CONF_INDEX;
+	}
+#endif
+
 	//
 	// finish up
 	//
@@ -982,26 +1698,27 @@ ast_conf_member* delete_member(ast_conf_member* member)
 
 	ast_mutex_unlock(&member->lock);
 
+#if	AST_CONF_SOUND_READERS
+	// take the member out of the sound readers' hands
+	cancel_prefetch(member);
+#endif
+
 	// destroy member mutex and condition variable
 	ast_mutex_destroy(&member->lock);
 	ast_cond_destroy(&member->delete_var);
 
-	// destroy incoming/outgoing queue mutexes
-	ast_mutex_destroy(&member->incomingq.lock);
-	ast_mutex_destroy(&member->outgoingq.lock);
-
 	//
 	// delete the members frames
 	//
 	struct ast_frame* fr;
 
 	// incoming frames
-	while ((fr = AST_LIST_REMOVE_HEAD(&member->incomingq.frames, frame_list)))
-		ast_frfree(fr);
+	while ((fr = frameq_get(&member->incomingq)))
+		is_shared_frame(fr) ? release_shared_frame(fr) : ast_frfree(fr);
 
 	// outgoing frames
-	while ((fr = AST_LIST_REMOVE_HEAD(&member->outgoingq.frames, frame_list)))
-		ast_frfree(fr);
+	while ((fr = frameq_get(&member->outgoingq)))
+		release_shared_frame(fr);
 
 	// speaker buffer
 	if (member->speakerBuffer)
@@ -1022,90 +1739,262 @@ ast_conf_member* delete_member(ast_conf_member* member)
 	if (member->dsp)
 	{
 		WebRtcVad_Free(member->dsp);
-		ast_translator_free_path(member->to_dsp);
+		trans_free_path(member->to_dsp);
 	}
 #elif	SILDET == 2
 	if (member->dsp)
 	{
 		speex_preprocess_state_destroy(member->dsp);
-		ast_translator_free_path(member->to_dsp);
+		trans_free_path(member->to_dsp);
+	}
+#endif
+
+	// free the mixing translators
+	trans_free_path(member->to_slinear);
+	trans_free_path(member->from_slinear);
+#if	AST_CONF_MEMBER_CODECS
+	trans_free_path(member->to_conference);
+#endif
+
+	// get a pointer to the next
+	// member so we can return it
+	ast_conf_member* nm = member->next;
+
+	// free the member's copy of the spyee channel name
+	if (member->spyee_channel_name)
+	{
+		ast_free(member->spyee_channel_name);
+	}
+
+	// free join/leave sound file names (NULL if not set)
+	ast_free(member->join_sound);
+	ast_free(member->leave_sound);
+
+	// clear all sounds
+	ast_conf_soundq *sound = member->soundq;
+	ast_conf_soundq *next;
+
+	while (sound)
+	{
+		next = sound->next;
+#if	AST_CONF_SOUND_READERS
+		while ((fr = frameq_get(&sound->frames)))
+			release_shared_frame(fr);
+		if (sound->stream)
+			ast_closestream(sound->stream);
+		trans_free_path(sound->trans);
+#else
+		if (sound->stream)
+			ast_stopstream(member->chan);
+#endif
+		ast_free(sound);
+		sound = next;
+	}
+
+#ifdef	CACHE_CONTROL_BLOCKS
+	// put the member control block on the free list
+	ast_mutex_lock(&mbrblocklist_lock);
+	member->next = mbrblocklist;
+	mbrblocklist = member;
+	ast_mutex_unlock(&mbrblocklist_lock);
+#else
+	ast_free(member);
+#endif
+	return nm;
+}
+
+//
+// frame ring functions
+//
+
+// called by the producer, returns -1 if the ring is full
+static int frameq_put(ast_conf_frameq *q, struct ast_frame *fr)
+{
+	unsigned int tail = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+
+	if (tail - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == AST_CONF_MAX_QUEUE)
+	{
+		q->overruns++;
+		return -1;
+	}
+
+	q->frames[tail & (AST_CONF_MAX_QUEUE - 1)] = fr;
+
+	// publish the slot
+	__atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+#if	AST_CONF_SOUND_READERS || AST_CONF_JITTER_BUFFER
+// frames in the ring, called by either side
+static unsigned int frameq_depth(ast_conf_frameq *q)
+{
+	return __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+}
+#endif
+
+// called by the consumer, returns NULL if the ring is empty
+static struct ast_frame *frameq_get(ast_conf_frameq *q)
+{
+	unsigned int head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+
+	if (head == __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE))
+	{
+		return NULL;
+	}
+
+	struct ast_frame *fr = q->frames[head & (AST_CONF_MAX_QUEUE - 1)];
+
+	// release the slot
+	__atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+
+	return fr;
+}
+
+#if	AST_CONF_JITTER_BUFFER
+// called by the consumer, returns the next frame without taking it or NULL if the ring is empty
+static struct ast_frame *frameq_peek(ast_conf_frameq *q)
+{
+	unsigned int head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+
+	if (head == __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE))
+	{
+		return NULL;
 	}
+
+	return q->frames[head & (AST_CONF_MAX_QUEUE - 1)];
+}
 #endif
 
-	// free the mixing translators
-	ast_translator_free_path(member->to_slinear);
-	ast_translator_free_path(member->from_slinear);
+//
+// incoming frame functions
+//
+
+#if	AST_CONF_JITTER_BUFFER
+// track the arrival jitter of the member's voice frames against the mixer clock
+static void jitter_buffer_arrival(ast_conf_member *member)
+{
+	struct timeval now = ast_tvnow();
+
+	if (!ast_tvzero(member->jb_arrival))
+	{
+		int64_t delta = ast_tvdiff_us(now, member->jb_arrival);
+
+		// a gap longer than the buffer is a pause between talkspurts, not jitter
+		if (delta < AST_CONF_JB_MAX_DEPTH * AST_CONF_FRAME_INTERVAL * 1000)
+		{
+			int jitter = member->jb_jitter;
+
+			delta -= AST_CONF_FRAME_INTERVAL * 1000;
+			jitter += ((delta < 0 ? -delta : delta) - jitter) / 16;
+
+			__atomic_store_n(&member->jb_jitter, jitter, __ATOMIC_RELAXED);
+		}
+	}
+
+	member->jb_arrival = now;
+}
+
+// take the member's next incoming frame on a mixer tick, holding the queue at
+// a target depth of twice the arrival jitter and dropping frames above it
+static struct ast_frame *jitter_buffer_get(ast_conf_member *member)
+{
+	struct ast_frame *fr;
+	int depth = frameq_depth(&member->incomingq);
+	int jitter = __atomic_load_n(&member->jb_jitter, __ATOMIC_RELAXED);
+	int dropped = 0;
 
-	// get a pointer to the next
-	// member so we can return it
-	ast_conf_member* nm = member->next;
+	member->jb_target = 1 + (2 * jitter + AST_CONF_FRAME_INTERVAL * 1000 - 1) / (AST_CONF_FRAME_INTERVAL * 1000);
+	if (member->jb_target > AST_CONF_JB_MAX_DEPTH)
+		member->jb_target = AST_CONF_JB_MAX_DEPTH;
 
-	// free the member's copy of the spyee channel name
-	if (member->spyee_channel_name)
+	member->jb_depth = depth;
+
+	if (!depth)
 	{
-		ast_free(member->spyee_channel_name);
+		// the member was speaking on the previous tick, the frame is late
+		if (member->tick->is_speaking)
+			member->incomingq.underruns++;
+
+		// fill up to the target again before the next frame is mixed
+		member->jb_filling = 1;
+		member->jb_wait = 0;
+
+		return NULL;
 	}
 
-	// free join/leave sound file names (NULL if not set)
-	ast_free(member->join_sound);
-	ast_free(member->leave_sound);
+	if (member->jb_filling)
+	{
+		// wait for the target depth, at most as many ticks as it takes to play it
+		if (depth < member->jb_target && member->jb_wait++ < member->jb_target)
+			return NULL;
 
-	// clear all sounds
-	ast_conf_soundq *sound = member->soundq;
-	ast_conf_soundq *next;
+		member->jb_filling = 0;
+	}
 
-	while (sound)
+	// quiet frames above the target are dropped at once, speech ( and the
+	// frames of a codec without an energy estimate ) a frame a tick once the
+	// queue is past the slack
+	while (depth > member->jb_target)
 	{
-		next = sound->next;
-		if (sound->stream)
-			ast_stopstream(member->chan);
-		ast_free(sound);
-		sound = next;
+		fr = frameq_peek(&member->incomingq);
+
+		int amplitude = fr->samples > 0 ? mean_amplitude(member->read_format_index, fr) : -1;
+
+		if (amplitude < 0 || amplitude >= AST_CONF_JB_QUIET)
+		{
+			if (dropped || depth <= member->jb_target + AST_CONF_JB_SLACK)
+				break;
+
+			dropped = 1;
+		}
+
+		fr = frameq_get(&member->incomingq);
+		is_shared_frame(fr) ? release_shared_frame(fr) : ast_frfree(fr);
+
+		member->jb_dropped++;
+		depth--;
 	}
 
-#ifdef	CACHE_CONTROL_BLOCKS
-	// put the member control block on the free list
-	ast_mutex_lock(&mbrblocklist_lock);
-	member->next = mbrblocklist;
-	mbrblocklist = member;
-	ast_mutex_unlock(&mbrblocklist_lock);
-#else
-	ast_free(member);
-#endif
-	return nm;
+	return frameq_get(&member->incomingq);
 }
-
-//
-// incoming frame functions
-//
+#endif
 
 conf_frame* get_incoming_frame(ast_conf_member *member)
 {
-	if (!member->incomingq.count)
+	struct ast_frame* fr;
+
+#if	AST_CONF_JITTER_BUFFER
+	if (!(fr = jitter_buffer_get(member)))
 	{
 		return NULL;
 	}
+#else
+	if (!(fr = frameq_get(&member->incomingq)))
+	{
+		// the member was speaking on the previous tick
+		if (member->tick->is_speaking)
+			member->incomingq.underruns++;
 
-	ast_mutex_lock(&member->incomingq.lock);
-
-	// get first frame
-	struct ast_frame* fr = AST_LIST_REMOVE_HEAD(&member->incomingq.frames, frame_list);
-
-	// decrement frame count
-	member->incomingq.count--;
-
-	ast_mutex_unlock(&member->incomingq.lock);
+		return NULL;
+	}
+#endif
 
 	conf_frame *cfr  = create_conf_frame(member, NULL);
 
 	if (cfr)
 	{
 		cfr->fr = fr;
+
+		// the conf frame owns the slab copy
+		if (is_shared_frame(fr))
+			cfr->copy = (ast_conf_sharedframe*)fr;
 	}
 	else
 	{
 		ast_log(LOG_ERROR, "unable to malloc conf_frame\n");
-		ast_frfree(fr);
+		is_shared_frame(fr) ? release_shared_frame(fr) : ast_frfree(fr);
 	}
 
 	return cfr;
@@ -1115,8 +2004,20 @@ void queue_incoming_frame(ast_conf_member* member, struct ast_frame* fr)
 {
 	//
 	// create new frame from passed data frame
+	// (a slab copy unless the frame is too large)
 	//
-	if (!(fr = ast_frdup(fr)))
+	ast_conf_sharedframe* sf;
+
+	if (fr->datalen <= AST_CONF_FRAME_DATA_SIZE)
+	{
+		if (!(sf = create_shared_frame(fr, fr->delivery)))
+		{
+			return;
+		}
+
+		fr = &sf->fr;
+	}
+	else if (!(fr = ast_frdup(fr)))
 	{
 		ast_log(LOG_ERROR, "unable to malloc incoming ast_frame\n");
 		return;
@@ -1125,22 +2026,13 @@ void queue_incoming_frame(ast_conf_member* member, struct ast_frame* fr)
 	//
 	// add new frame to members incoming frame queue
 	// (i.e. save this frame data, so we can distribute it in conference_exec later)
+	// and drop it if the queue is full
 	//
 
-	ast_mutex_lock(&member->incomingq.lock);
-
-	AST_LIST_INSERT_TAIL(&member->incomingq.frames, fr, frame_list);
-
-	//
-	// drop a frame if more than AST_CONF_MAX_QUEUE
-	//
-	if (++member->incomingq.count > AST_CONF_MAX_QUEUE)
+	if (frameq_put(&member->incomingq, fr))
 	{
-		ast_frfree(AST_LIST_REMOVE_HEAD(&member->incomingq.frames, frame_list));
-		member->incomingq.count--;
+		is_shared_frame(fr) ? release_shared_frame(fr) : ast_frfree(fr);
 	}
-
-	ast_mutex_unlock(&member->incomingq.lock);
 }
 
 //
@@ -1149,19 +2041,21 @@ void queue_incoming_frame(ast_conf_member* member, struct ast_frame* fr)
 
 struct ast_frame* get_outgoing_frame(ast_conf_member *member)
 {
-	if (member->outgoingq.count)
-	{
-		ast_mutex_lock(&member->outgoingq.lock);
+	return frameq_get(&member->outgoingq);
+}
 
-		struct ast_frame* fr = AST_LIST_REMOVE_HEAD(&member->outgoingq.frames, frame_list);
+// queue a new shared frame, handing its reference to the queue
+static void queue_new_shared_frame(ast_conf_member* member, ast_conf_sharedframe* sf)
+{
+	//
+	// add new frame to members outgoing frame queue
+	// and drop it if the queue is full
+	//
 
-		// decrement frame count
-		member->outgoingq.count--;
-		ast_mutex_unlock(&member->outgoingq.lock);
-		return fr;
+	if (frameq_put(&member->outgoingq, &sf->fr))
+	{
+		release_shared_frame(&sf->fr);
 	}
-
-	return NULL;
 }
 
 void queue_outgoing_frame(ast_conf_member* member, struct ast_frame* fr, struct timeval delivery)
@@ -1169,91 +2063,164 @@ void queue_outgoing_frame(ast_conf_member* member, struct ast_frame* fr, struct
 	//
 	// create new frame from passed data frame
 	//
-	if (!(fr  = ast_frdup(fr)))
+	ast_conf_sharedframe* sf;
+
+	if (!(sf = create_shared_frame(fr, delivery)))
 	{
-		ast_log(LOG_ERROR, "unable to malloc outgoing ast_frame\n");
 		return;
 	}
 
-	// set delivery timestamp
-	fr->delivery = delivery;
+	queue_new_shared_frame(member, sf);
+}
 
-	//
-	// add new frame to members outgoing frame queue
-	//
+// queue a frame shared by the members receiving the same audio on this tick
+static void queue_shared_frame(ast_conf_member* member, ast_conf_sharedframe** sf, struct ast_frame* fr, struct timeval delivery)
+{
+	// the first member creates the shared frame
+	if (!*sf && !(*sf = create_shared_frame(fr, delivery)))
+	{
+		return;
+	}
 
-	ast_mutex_lock(&member->outgoingq.lock);
+	ast_atomic_fetchadd_int(&(*sf)->refcount, 1);
 
-	AST_LIST_INSERT_TAIL(&member->outgoingq.frames, fr, frame_list);
+	if (frameq_put(&member->outgoingq, &(*sf)->fr))
+	{
+		release_shared_frame(&(*sf)->fr);
+	}
+}
 
-	//
-	// drop a frame if more than AST_CONF_MAX_QUEUE
-	//
-	if (++member->outgoingq.count > AST_CONF_MAX_QUEUE)
+#if	AST_CONF_SHARED_MOH
+// queue a reference to the next block of the music on hold ring, encoded at the member's format
+static void queue_moh_frame(ast_conf_tick* tick)
+{
+	ast_conf_member* member = tick->member;
+	ast_conf_sharedframe* sf = member->moh->frames[tick->write_format_index][member->moh_block];
+
+	if (++member->moh_block == member->moh->blocks)
+		member->moh_block = 0;
+
+	if (!sf)
+	{
+		return;
+	}
+
+	ast_atomic_fetchadd_int(&sf->refcount, 1);
+
+	if (frameq_put(&member->outgoingq, &sf->fr))
+	{
+		release_shared_frame(&sf->fr);
+	}
+}
+#endif
+
+// queue the listener frame at the member's listen volume, converted once
+// per tick for the listeners at the same format and volume
+// (returns -1 when the frame can't be converted)
+static int queue_volume_frame_for_listener(
+	ast_conference* conf,
+	ast_conf_tick* tick,
+	conf_frame* frame
+)
+{
+	ast_conf_member* member = tick->member;
+	struct ast_frame* qf;
+	ast_conf_sharedframe* sf;
+	int i;
+
+	for (i = 0; i < frame->volume_frame_count; ++i)
+	{
+		if (frame->volume_frames[i].format_index == tick->write_format_index && frame->volume_frames[i].volume == tick->listen_volume)
+		{
+			conf->encode_hits++;
+			queue_shared_frame(member, &frame->volume_frames[i].shared, NULL, conf->delivery_time);
+			return 0;
+		}
+	}
+
+	conf->encode_misses++;
+
+	// make a copy of the slinear version of the frame
+	if (!(qf = ast_frdup(frame->fr)))
+	{
+		ast_log(LOG_WARNING, "unable to duplicate frame\n");
+		return -1;
+	}
+
+	ast_frame_adjust_volume(qf, tick->listen_volume);
+
+	// convert using the conference's translation path
+	sf = encode_frame(tick->write_format_index, conf->from_slinear_paths[tick->write_format_index], qf, conf->delivery_time);
+
+	// free the slinear copy
+	ast_frfree(qf);
+
+	if (!sf)
 	{
-		ast_frfree(AST_LIST_REMOVE_HEAD(&member->outgoingq.frames, frame_list));
-		member->outgoingq.count--;
+		return -1;
+	}
+
+	// keep the frame for the next listeners at this volume, while there is room
+	if (frame->volume_frame_count < AST_CONF_VOLUME_FRAMES)
+	{
+		frame->volume_frames[frame->volume_frame_count].format_index = tick->write_format_index;
+		frame->volume_frames[frame->volume_frame_count].volume = tick->listen_volume;
+		frame->volume_frames[frame->volume_frame_count].shared = sf;
+
+		queue_shared_frame(member, &frame->volume_frames[frame->volume_frame_count++].shared, NULL, conf->delivery_time);
+	}
+	else
+	{
+		queue_new_shared_frame(member, sf);
 	}
 
-	ast_mutex_unlock(&member->outgoingq.lock);
+	return 0;
 }
 
 void queue_frame_for_listener(
 	ast_conference* conf,
-	ast_conf_member* member
+	ast_conf_tick* tick
 )
 {
+	ast_conf_member* member = tick->member;
 	struct ast_frame* qf;
+	ast_conf_sharedframe* sf;
 	conf_frame* frame = conf->listener_frame;
 
 	if (frame)
 	{
+		if (tick->listen_volume)
+		{
+			qf = !queue_volume_frame_for_listener(conf, tick, frame) ? frame->fr : NULL;
+		}
 		// try for a pre-converted frame; otherwise, convert (and store) the frame
-		if (!(qf = !member->listen_volume && !frame->talk_volume ? frame->converted[member->write_format_index] : 0))
+		else if ((qf = !frame->talk_volume ? frame->converted[tick->write_format_index] : 0))
 		{
-			if (!member->listen_volume)
-			{
-				qf = frame->fr;
-			}
-			else
-			{
-				// make a copy of the slinear version of the frame
-				if (!(qf = ast_frdup(frame->fr)))
-				{
-					ast_log(LOG_WARNING, "unable to duplicate frame\n");
-					queue_silent_frame(conf, member);
-					return;
-				}
-
-				ast_frame_adjust_volume(qf, member->listen_volume);
-			}
+			conf->encode_hits++;
+			queue_shared_frame(member, &frame->shared[tick->write_format_index], qf, conf->delivery_time);
+		}
+		else
+		{
+			conf->encode_misses++;
 
 			// convert using the conference's translation path
-			qf = convert_frame(conf->from_slinear_paths[member->write_format_index], qf, member->listen_volume);
-
-			// store the converted frame
-			// (the frame will be free'd next time through the loop)
-			if (!member->listen_volume)
+			if ((sf = encode_frame(tick->write_format_index, conf->from_slinear_paths[tick->write_format_index], frame->fr, conf->delivery_time)))
 			{
-				if (frame->converted[member->write_format_index] && conf->from_slinear_paths[member->write_format_index])
-					ast_frfree(frame->converted[member->write_format_index]);
-				frame->converted[member->write_format_index] = qf;
+				// store the converted frame and its shared copy
+				// (the frame will be free'd next time through the loop)
+				if (frame->converted[tick->write_format_index] && conf->from_slinear_paths[tick->write_format_index])
+					ast_frfree(frame->converted[tick->write_format_index]);
+				frame->converted[tick->write_format_index] = &sf->fr;
+				frame->shared[tick->write_format_index] = sf;
 				frame->talk_volume = 0;
-			}
-		}
-
-		if (qf)
-		{
-			queue_outgoing_frame(member, qf, conf->delivery_time);
 
-			if (member->listen_volume)
-			{
-				// free frame (the translator's copy)
-				if (conf->from_slinear_paths[member->write_format_index])
-					ast_frfree(qf);
+				queue_shared_frame(member, &frame->shared[tick->write_format_index], NULL, conf->delivery_time);
 			}
+
+			qf = sf ? &sf->fr : NULL;
 		}
-		else
+
+		if (!qf)
 		{
 #if	ASTERISK_SRC_VERSION < 1100
 			ast_log(LOG_WARNING, "unable to translate outgoing listener frame, channel => %s\n", member->chan->name);
@@ -1265,17 +2232,19 @@ void queue_frame_for_listener(
 	}
 	else
 	{
-		queue_silent_frame(conf, member);
+		queue_silent_frame(conf, tick);
 	}
 }
 
 void queue_frame_for_speaker(
 	ast_conference* conf,
-	ast_conf_member* member
+	ast_conf_tick* tick
 )
 {
+	ast_conf_member* member = tick->member;
 	struct ast_frame* qf;
-	conf_frame* frame = member->speaker_frame;
+	ast_conf_sharedframe* sf;
+	conf_frame* frame = tick->speaker_frame;
 
 	if (frame)
 	{
@@ -1283,7 +2252,7 @@ void queue_frame_for_speaker(
 		// convert and queue frame
 		//
 
-		if ((qf = frame->converted[member->write_format_index]) && !member->listen_volume && !frame->talk_volume)
+		if ((qf = frame->converted[tick->write_format_index]) && !tick->listen_volume && !frame->talk_volume)
 		{
 			// frame is already in correct format, so just queue it
 
@@ -1291,24 +2260,26 @@ void queue_frame_for_speaker(
 		}
 		else
 		{
-			if (member->listen_volume)
+			if (tick->listen_volume)
 			{
-				ast_frame_adjust_volume(frame->fr, member->listen_volume);
+				ast_frame_adjust_volume(frame->fr, tick->listen_volume);
 			}
+#if	AST_CONF_MEMBER_CODECS
+			// the member thread encodes the mix
+			if (member->from_slinear)
+			{
+				queue_outgoing_frame(member, frame->fr, conf->delivery_time);
+				return;
+			}
+#endif
 
 			//
 			// convert frame to member's write format
 			//
-			qf = convert_frame(member->from_slinear, frame->fr, 0);
-
-			if (qf)
+			if ((sf = encode_frame(tick->write_format_index, member->from_slinear, frame->fr, conf->delivery_time)))
 			{
 				// queue frame
-				queue_outgoing_frame(member, qf, conf->delivery_time);
-
-				// free frame (the translator's copy)
-				if (member->from_slinear)
-					ast_frfree(qf);
+				queue_new_shared_frame(member, sf);
 			}
 			else
 			{
@@ -1322,7 +2293,7 @@ void queue_frame_for_speaker(
 	}
 	else
 	{
-		queue_silent_frame(conf, member);
+		queue_silent_frame(conf, tick);
 	}
 }
 
@@ -1330,44 +2301,54 @@ void queue_frame_for_speaker(
 
 void queue_silent_frame(
 	ast_conference* conf,
-	ast_conf_member* member
+	ast_conf_tick* tick
 )
 {
+	ast_conf_member* member = tick->member;
 	// get the appropriate silent frame
-	struct ast_frame* qf = silent_conf_frame->converted[member->write_format_index];
+	struct ast_frame* qf = silent_conf_frame->converted[tick->write_format_index];
 
 	if (!qf)
 	{
+		// serialize the mixer threads
+		ast_mutex_lock(&silent_frame_lock);
+
+		// recheck, another mixer thread may have translated it
+		if (!(qf = silent_conf_frame->converted[tick->write_format_index]))
+		{
 #if	ASTERISK_SRC_VERSION < 1000
-		struct ast_trans_pvt* trans = ast_translator_build_path(member->chan->writeformat, AST_FORMAT_CONFERENCE);
+			struct ast_trans_pvt* trans = ast_translator_build_path(member->chan->writeformat, AST_FORMAT_CONFERENCE);
 #else
 #if	ASTERISK_SRC_VERSION < 1100
-		struct ast_trans_pvt* trans = ast_translator_build_path(&member->chan->writeformat, &ast_format_conference);
+			struct ast_trans_pvt* trans = ast_translator_build_path(&member->chan->writeformat, &ast_format_conference);
 #else
-		struct ast_trans_pvt* trans = ast_translator_build_path(ast_channel_writeformat(member->chan), &ast_format_conference);
+			struct ast_trans_pvt* trans = ast_translator_build_path(ast_channel_writeformat(member->chan), &ast_format_conference);
 #endif
 #endif
 
-		if (trans)
-		{
-			// translate the frame
-			if ((qf = ast_translate(trans, silent_conf_frame->fr, 0)))
+			if (trans)
 			{
-				// isolate the frame so we can keep it around after trans is free'd
-				qf = ast_frisolate(qf);
+				// translate the frame
+				if ((qf = ast_translate(trans, silent_conf_frame->fr, 0)))
+				{
+					// isolate the frame so we can keep it around after trans is free'd
+					qf = ast_frisolate(qf);
 
-				// cache the new, isolated frame
-				silent_conf_frame->converted[member->write_format_index] = qf;
-			}
+					// cache the new, isolated frame
+					silent_conf_frame->converted[tick->write_format_index] = qf;
+				}
 
-			ast_translator_free_path(trans);
+				ast_translator_free_path(trans);
+			}
 		}
+
+		ast_mutex_unlock(&silent_frame_lock);
 	}
 
 	// if it's not null queue the frame
 	if (qf)
 	{
-		queue_outgoing_frame(member, qf, conf->delivery_time);
+		queue_shared_frame(member, &conf->silent_frames[tick->write_format_index], qf, conf->delivery_time);
 	}
 	else
 	{
@@ -1382,8 +2363,10 @@ void queue_silent_frame(
 
 
 void member_process_outgoing_frames(ast_conference* conf,
-				  ast_conf_member *member)
+				  ast_conf_tick *tick)
 {
+	ast_conf_member *member = tick->member;
+
 	// skip members that are not ready
 	// skip no receive audio clients
 	if (!member->ready_for_outgoing || member->norecv_audio)
@@ -1391,18 +2374,27 @@ void member_process_outgoing_frames(ast_conference* conf,
 		return;
 	}
 
+#if	AST_CONF_SHARED_MOH
+	// a lone member hears the next block of the shared music on hold
+	if (member->moh_playing)
+	{
+		queue_moh_frame(tick);
+		return;
+	}
+#endif
+
 	if (!member->spy_partner)
 	{
 		// neither a spyer nor a spyee
-		if (!member->is_speaking) 
+		if (!tick->is_speaking)
 		{
 			// queue listener frame
-			queue_frame_for_listener(conf, member);
+			queue_frame_for_listener(conf, tick);
 		}
 		else
 		{
 			// queue speaker frame
-			queue_frame_for_speaker(conf, member);
+			queue_frame_for_speaker(conf, tick);
 		}
 	}
 	else
@@ -1411,37 +2403,149 @@ void member_process_outgoing_frames(ast_conference* conf,
 		if (member->spyee_channel_name)
 		{
 			// spyer -- always use member translator
-			queue_frame_for_speaker(conf, member);
+			queue_frame_for_speaker(conf, tick);
 		}
 		else
 		{
 			// spyee -- use member translator if spyee speaking or spyer whispering to spyee
-			if (member->is_speaking || member->spy_partner->is_speaking)
+			if (tick->is_speaking || member->spy_partner->tick->is_speaking)
 			{
-				queue_frame_for_speaker(conf, member);
+				queue_frame_for_speaker(conf, tick);
 			}
 			else
 			{
-				queue_frame_for_listener(conf, member);
+				queue_frame_for_listener(conf, tick);
 			}
 		}
 	}
 }
 
 void member_process_spoken_frames(ast_conference* conf,
-				 ast_conf_member *member,
+				 ast_conf_tick *tick,
 				 conf_frame **spoken_frames,
 				 int *listener_count,
 				 int *speaker_count
 	)
 {
-	conf_frame *cfr;
+	conf_frame *cfr  = get_incoming_frame(tick->member);
+
+#if	SILDET == 1
+	// the frames of members with a vad wait for the batch
+	if (cfr && tick->member->dsp)
+	{
+#if	ASTERISK_SRC_VERSION == 104
+		const char *data = cfr->fr->data;
+#else
+		const char *data = cfr->fr->data.ptr;
+#endif
+		int i;
+
+		// start loading the vad state and samples while the batch fills
+		WebRtcVad_Prefetch(tick->member->dsp);
+		for (i = 0; i < cfr->fr->datalen; i += 64)
+			__builtin_prefetch(data + i);
+
+		conf->vad_ticks[conf->vad_count] = tick;
+		conf->vad_frames[conf->vad_count] = cfr;
+
+		if (++conf->vad_count == AST_CONF_VAD_BATCH)
+			member_process_vad_batch(conf, spoken_frames, listener_count, speaker_count);
+
+		return;
+	}
+#endif
+
+	add_spoken_frame(tick, cfr, spoken_frames, listener_count, speaker_count);
+}
+
+#if	SILDET == 1
+void member_process_vad_batch(ast_conference* conf,
+			      conf_frame **spoken_frames,
+			      int *listener_count,
+			      int *speaker_count
+	)
+{
+#ifdef	AC_USE_G722
+	// narrowband and wideband members are run separately
+	static const int rates[] = { 8000, 16000 };
+#else
+	static const int rates[] = { AST_CONF_SAMPLE_RATE };
+#endif
+	VadInst *handles[AST_CONF_VAD_BATCH];
+	int16_t *frames[AST_CONF_VAD_BATCH];
+	int vads[AST_CONF_VAD_BATCH], results[AST_CONF_VAD_BATCH], indexes[AST_CONF_VAD_BATCH];
+	int i, r, count;
+
+	if (!conf->vad_count)
+		return;
+
+	for (r = 0; r < sizeof(rates) / sizeof(rates[0]); ++r)
+	{
+		for (i = 0, count = 0; i < conf->vad_count; ++i)
+		{
+			if (conf->vad_ticks[i]->member->vad_rate != rates[r])
+				continue;
+
+			handles[count] = conf->vad_ticks[i]->member->dsp;
+#if	ASTERISK_SRC_VERSION == 104
+			frames[count] = conf->vad_frames[i]->fr->data;
+#else
+			frames[count] = conf->vad_frames[i]->fr->data.ptr;
+#endif
+			indexes[count++] = i;
+		}
+
+		if (!count)
+			continue;
+
+		// a failed vad lets the frames through
+		if (WebRtcVad_ProcessBatch(handles, count, rates[r], frames, rates[r] / 1000 * AST_CONF_FRAME_INTERVAL, results))
+		{
+			for (i = 0; i < count; ++i)
+				results[i] = 1;
+		}
+
+		for (i = 0; i < count; ++i)
+			vads[indexes[i]] = results[i];
+	}
+
+	for (i = 0; i < conf->vad_count; ++i)
+	{
+		ast_conf_tick *tick = conf->vad_ticks[i];
+		conf_frame *cfr = conf->vad_frames[i];
+
+		if (member_vad_is_silent(tick->member, vads[i]))
+		{
+			// drop the silent frame
+			delete_conf_frame(cfr);
+			cfr = NULL;
+		}
+		else if (conf->max_speakers)
+		{
+			update_speech_energy(tick->member, cfr->fr);
+		}
+
+		add_spoken_frame(tick, cfr, spoken_frames, listener_count, speaker_count);
+	}
+
+	conf->vad_count = 0;
+}
+#endif
 
+// add a member's frame to the spoken frames, or count the member as a listener
+static void add_spoken_frame(ast_conf_tick *tick,
+			     conf_frame *cfr,
+			     conf_frame **spoken_frames,
+			     int *listener_count,
+			     int *speaker_count
+	)
+{
 	// handle retrieved frames
-	if (!(cfr  = get_incoming_frame(member)))
+	if (!cfr)
 	{
-		// clear speaking state
-		member->is_speaking = 0;
+		// clear speaking and mixed state
+		tick->is_speaking = 0;
+		tick->is_mixed = 0;
 
 		// increment listener count
 		(*listener_count)++;
@@ -1449,7 +2553,7 @@ void member_process_spoken_frames(ast_conference* conf,
 	else
 	{
 		// set speaking state
-		member->is_speaking = 1;
+		tick->is_speaking = 1;
 
 		// add the frame to the list of spoken frames
 		if (*spoken_frames)
@@ -1467,56 +2571,3 @@ void member_process_spoken_frames(ast_conference* conf,
 
 	return;
 }
-
-// Add sound file to a member's sound queue
-void member_play_sound ( struct ast_conf_member *member, const char *filename )
-{
-	struct ast_conf_soundq *newsound;
-	struct ast_conf_soundq **q;
-
-	newsound = calloc(1,sizeof(struct ast_conf_soundq));
-
-	ast_mutex_lock(&member->lock);
-	if (newsound == NULL) {
-		perror("calloc for struct ast_conf_soundq failed");
-	}
-	else
-	{
-#if	ASTERISK_SRC_VERSION < 1100
-		newsound->stream = ast_openstream(member->chan, filename, member->chan->language);
-#else
-		newsound->stream = ast_openstream(member->chan, filename, ast_channel_language(member->chan));
-#endif
-		if (newsound->stream)
-		{
-//#if ASTERISK_SRC_VERSION < 1100
-//			member->chan->stream = NULL;
-//#else
-//			ast_channel_stream_set(member->chan, NULL);
-//#endif
-			ast_copy_string(newsound->name, filename, sizeof(newsound->name));
-			// append sound to the end of the list.
-			for (q=&member->soundq; *q; q = &((*q)->next));
-			*q = newsound;
-
-#if ASTERISK_SRC_VERSION < 1100
-			ast_log( LOG_VERBOSE, "Playing conference message %s to channel %s\n", filename, member->chan->name ) ;
-#else
-			ast_log( LOG_VERBOSE, "Playing conference message %s to channel %s\n", filename, ast_channel_name(member->chan)) ;
-#endif
-		}
-		else
-		{
-			char fmt[256];
-#if ASTERISK_SRC_VERSION < 1100
-			ast_log(LOG_ERROR, "Unable to open %s (format %s): %s\n",
-					filename, ast_getformatname_multiple(fmt, sizeof(fmt), member->chan->nativeformats), strerror(errno));
-#else
-			ast_log(LOG_ERROR, "Unable to open %s (format %s): %s\n",
-								filename, ast_getformatname_multiple(fmt, sizeof(fmt), ast_channel_nativeformats(member->chan)), strerror(errno));
-#endif
-			ast_free(newsound);
-		}
-	}
-	ast_mutex_unlock(&member->lock);
-}
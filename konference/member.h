@@ -25,6 +25,7 @@
 
 #include "app_conference.h"
 #include "conference.h"
+#include "moh.h"
 
 //
 // defines
@@ -37,23 +38,132 @@
 // struct declarations
 //
 
+// single-producer/single-consumer frame ring: the incoming queue is written
+// by the member thread and read by the mixer thread, the outgoing queue the
+// other way around, so neither side takes a lock
+struct ast_conf_frameq
+{
+	// frame slots
+	struct ast_frame *frames[AST_CONF_MAX_QUEUE];
+
+	// next slot to read, advanced by the consumer
+	unsigned int head __attribute((aligned(64)));
+	// reads that found the ring empty mid-talkspurt (incoming queue only)
+	unsigned int underruns;
+
+	// next slot to write, advanced by the producer
+	unsigned int tail __attribute((aligned(64)));
+	// frames dropped because the ring was full
+	unsigned int overruns;
+};
+
 struct ast_conf_soundq
 {
 	char name[256];
 	struct ast_filestream *stream; // the stream
 	int stopped;
 	struct ast_conf_soundq *next;
+#if	AST_CONF_SOUND_READERS
+	// frames read ahead by a sound reader in the member's write format
+	ast_conf_frameq frames;
+
+	// translator path to the write format, built on the first frame
+	struct ast_trans_pvt *trans;
+	int built;
+
+	// a reader is reading the sound, has read all of it, the member has played some of it
+	int reading;
+	int eof;
+	int started;
+#endif
 };
 
-struct ast_conf_frameq
+// per tick mixer state of a member, kept in a contiguous
+// per-conference array so that the mixer doesn't walk the member list
+struct ast_conf_tick
 {
-	ast_mutex_t lock;
-	AST_LIST_HEAD_NOLOCK(, ast_frame) frames;
-	unsigned int count;
+	// the member
+	ast_conf_member* member;
+
+	// member speaker frame
+	conf_frame *speaker_frame;
+
+	// speaking flag
+	short is_speaking;
+
+	// mixed speaker flag (max_speakers)
+	short is_mixed;
+
+	// audio format of the member, copied when it joins
+	int write_format_index;
+
+	// listen volume level adjustment for the member
+	int listen_volume;
 };
 
 struct ast_conf_member
 {
+	//
+	// fields read by the mixer on every tick are kept together at the
+	// front of the structure, the rest is only touched by the member thread,
+	// the cli, the manager and when the member joins or leaves
+	//
+
+	// member's entry in the conference tick array
+	ast_conf_tick* tick;
+
+	// spyer pointer to spyee or vice versa
+	ast_conf_member* spy_partner;
+
+	// peak speech energy (max_speakers), -1 if it can't be estimated
+	int speech_energy;
+
+	// ready flag (the member thread reads it too, without the conference lock)
+	short ready_for_outgoing;
+
+#if	AST_CONF_SOUND_READERS
+	// next member waiting for a sound reader
+	ast_conf_member* prefetch_next;
+
+	// waiting for a reader, being read, asked to be read again
+	short prefetch_queued;
+	short prefetch_busy;
+	short prefetch_again;
+
+	// frames read ahead of the playing sound and frames it had none ready for
+	int sound_depth;
+	unsigned int sound_underruns;
+#endif
+
+#if	AST_CONF_JITTER_BUFFER
+	// arrival of the last voice frame and the smoothed arrival jitter in microseconds
+	struct timeval jb_arrival;
+	int jb_jitter;
+
+	// target depth, ticks waited while filling up to it, frames queued on the last tick
+	int jb_target;
+	int jb_wait;
+	short jb_filling;
+	int jb_depth;
+
+	// frames dropped above the target depth
+	unsigned int jb_dropped;
+#endif
+
+#if	AST_CONF_SHARED_MOH
+	// music on hold of the member's class and the next block of its ring,
+	// queued by the mixer while the member is alone in the conference
+	ast_conf_moh* moh;
+	int moh_block;
+	short moh_playing;
+#endif
+
+	// this member will not hear/see
+	short norecv_audio;
+
+	// audio format this member is using (the mixer reads its tick entry's copy)
+	int write_format_index;
+
 	ast_mutex_t lock; // member data mutex
 
 	struct ast_channel* chan; // member's channel
@@ -64,14 +174,13 @@ struct ast_conf_member
 	char delete_flag; // delete flag
 	int use_count; // use count
 
-	conf_frame *speaker_frame; // member speaker frame
-
 	// values passed to create_member() via *data
 	char flags[MEMBER_FLAGS_LEN + 1];	// raw member-type flags
 	char type[MEMBER_TYPE_LEN + 1];		// conference type
 	char *spyee_channel_name; // spyee  channel name
 
 	int max_users; // zero or max users for this conference
+	int max_speakers; // zero or max speakers mixed by this conference
 
 	// sounds to play to the member when somebody joins/leaves the conference
 	char * join_sound;
@@ -86,20 +195,14 @@ struct ast_conf_member
 	// muting options - this member will not be heard/seen
 	int mute_audio;
 	int muted; // should incoming audio be muted while we play?
-	// volume level adjustment for this member
+	// talk volume level adjustment for this member
 	int talk_volume;
-	int listen_volume;
 
-	// this member will not hear/see
-	int norecv_audio;
 	// is this person a moderator?
 	int ismoderator;
 	int kick_conferees;
 	int kick_flag;
 
-	// ready flag
-	short ready_for_outgoing;
-
 	// input frame queue
 	ast_conf_frameq incomingq;
 
@@ -109,9 +212,6 @@ struct ast_conf_member
 	// relay dtmf to manager?
 	short dtmf_relay;
 
-	// speaking flag
-	short is_speaking;
-
 	// pointer to next member in linked list
 	ast_conf_member* next;
 
@@ -123,8 +223,6 @@ struct ast_conf_member
 	// list entry for member's bucket list
 	AST_LIST_ENTRY(ast_conf_member) hash_entry;
 
-	// spyer pointer to spyee or vice versa
-	ast_conf_member* spy_partner;
 	// spyee pointer to whisper frame
 	conf_frame* whisper_frame;
 
@@ -138,6 +236,8 @@ struct ast_conf_member
 	VadInst *dsp;
 	// translator for dsp
 	struct ast_trans_pvt *to_dsp;
+	// sample rate of the audio the dsp runs on
+	int vad_rate;
         // number of "silent" frames to ignore
 	int ignore_vad_result;
 
@@ -147,6 +247,7 @@ struct ast_conf_member
 	int vad_flag;
 	int denoise_flag;
 	int agc_flag;
+	int fixed_flag;
 
 	// vad voice probability thresholds
 	float vad_prob_start;
@@ -160,14 +261,32 @@ struct ast_conf_member
 	int ignore_vad_result;
 #endif
 
+#if	SILDET == 1 || SILDET == 2
+	// energy pre-gate noise floor (mean square) and frames gated in a row
+	float vad_floor;
+	int vad_gate_run;
+	// frames seen by the pre-gate and frames kept from the preprocessor
+	unsigned int vad_frames;
+	unsigned int vad_gated;
+	// speaking state from the preprocessor's outcome ( set by the mixer with libwebrtc )
+	// and the state the member thread last reported
+	int vad_speaking;
+	int vad_reported;
+#endif
+
 	// audio format this member is using
-	int write_format_index;
 	int read_format_index;
 
 	// member frame translators
 	struct ast_trans_pvt* to_slinear;
 	struct ast_trans_pvt* from_slinear;
 
+#if	AST_CONF_MEMBER_CODECS
+	// translator and format index of the frames decoded by the member thread
+	struct ast_trans_pvt* to_conference;
+	int decode_format_index;
+#endif
+
 	// For playing sounds
 	ast_conf_soundq *soundq;
 
@@ -189,8 +308,6 @@ int member_exec(struct ast_channel* chan, void* data);
 int member_exec(struct ast_channel* chan, const char* data);
 #endif
 
-void member_play_sound( struct ast_conf_member *, const char *) ;
-
 ast_conf_member* create_member(struct ast_channel* chan, const char* data, char* conf_name);
 ast_conf_member* delete_member(ast_conf_member* member);
 
@@ -203,12 +320,33 @@ void queue_outgoing_frame(ast_conf_member* member, struct ast_frame* fr, struct
 struct ast_frame* get_outgoing_frame(ast_conf_member* member);
 
 void member_process_spoken_frames(ast_conference* conf,
-				  ast_conf_member *member,
+				  ast_conf_tick *tick,
 				  conf_frame **spoken_frames,
 				 int *listener_count,
 				 int *speaker_count);
 
+#if	SILDET == 1
+// run the vad on the frames waiting for it and add them to the spoken frames
+void member_process_vad_batch(ast_conference* conf,
+			      conf_frame **spoken_frames,
+			      int *listener_count,
+			      int *speaker_count);
+#endif
+
 void member_process_outgoing_frames(ast_conference* conf,
-				    ast_conf_member *member);
+				    ast_conf_tick *tick);
+
+#if	AST_CONF_SOUND_READERS
+// ask a sound reader to read the member's sounds ahead ( called after queueing a sound )
+void prefetch_sounds(ast_conf_member* member);
+
+// called by conference.c:init_conference()
+void start_sound_readers(void);
+// called by conference.c:dealloc_conference()
+void stop_sound_readers(void);
+
+// cli function
+void sound_reader_stats(int fd);
+#endif
 
 #endif
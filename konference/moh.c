@@ -0,0 +1,271 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * Copyright (C) 2002, 2003 Junghanns.NET GmbH
+ * Copyright (C) 2003, 2004 HorizonLive.com, Inc.
+ * Copyright (C) 2005, 2005 Vipadia Limited
+ * Copyright (C) 2005, 2006 HorizonWimba, Inc.
+ * Copyright (C) 2007 Wimba, Inc.
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "asterisk/autoconfig.h"
+#include "asterisk/paths.h"
+#include "moh.h"
+#include "sound.h"
+#include "frame.h"
+#include "slab.h"
+#include "trans.h"
+
+#include <dirent.h>
+#include <limits.h>
+
+//
+// music on hold shared by the single member conferences
+//
+// the files of a class are decoded once into a looping ring of blocks, and the
+// ring is encoded once for each write format, so the mixer queues a waiting
+// member a reference to an encoded block on each tick instead of running a
+// music on hold generator on every waiting channel
+//
+// a class is decoded and encoded under its own lock, so only the members
+// joining with that class wait for it
+//
+
+//
+// static variables
+//
+
+// lock of the class list
+static ast_mutex_t moh_lock;
+
+// decoded classes
+static ast_conf_moh *mohs;
+
+static int compare_files(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+// append the decoded samples of a file to the ring
+static void append_moh(ast_conf_moh *moh, const char *name)
+{
+	ast_conf_sound sound;
+	short *samples;
+	int blocks = AST_CONF_MOH_SECONDS * AST_CONF_FRAMES_PER_SECOND - moh->blocks;
+
+	memset(&sound, 0, sizeof(sound));
+	ast_copy_string(sound.name, name, sizeof(sound.name));
+
+	decode_sound(&sound);
+
+	// the ring stops at its longest
+	if (sound.blocks < blocks)
+		blocks = sound.blocks;
+
+	if (blocks > 0 && (samples = ast_realloc(moh->samples, (moh->blocks + blocks) * AST_CONF_BLOCK_SAMPLES * sizeof(short))))
+	{
+		memcpy(samples + moh->blocks * AST_CONF_BLOCK_SAMPLES, sound.samples, blocks * AST_CONF_BLOCK_SAMPLES * sizeof(short));
+
+		moh->samples = samples;
+		moh->blocks += blocks;
+	}
+
+	free(sound.samples);
+}
+
+// decode the files of a class in name order, each file once whatever its formats
+static void decode_moh(ast_conf_moh *moh)
+{
+	char dir[PATH_MAX], file[PATH_MAX];
+	char **files = NULL, **more, *ext;
+	struct dirent *entry;
+	int count = 0, i;
+	DIR *d;
+
+	if (!strcmp(moh->name, AST_CONF_MOH_CLASS))
+		snprintf(dir, sizeof(dir), "%s/moh", ast_config_AST_DATA_DIR);
+	else
+		snprintf(dir, sizeof(dir), "%s/moh/%s", ast_config_AST_DATA_DIR, moh->name);
+
+	if (!(d = opendir(dir)))
+	{
+		return;
+	}
+
+	while ((entry = readdir(d)))
+	{
+		if (entry->d_name[0] == '.' || !(ext = strrchr(entry->d_name, '.')))
+			continue;
+
+		// a path longer than a sound name can't be decoded
+		if (snprintf(file, sizeof(file), "%s/%.*s", dir, (int)(ext - entry->d_name), entry->d_name) >= sizeof(((ast_conf_sound*)0)->name))
+			continue;
+
+		if (!(more = ast_realloc(files, (count + 1) * sizeof(char*))))
+			break;
+
+		files = more;
+
+		if (!(files[count] = ast_strdup(file)))
+			break;
+
+		++count;
+	}
+
+	closedir(d);
+
+	qsort(files, count, sizeof(char*), compare_files);
+
+	for (i = 0; i < count; ++i)
+	{
+		if (!i || strcmp(files[i], files[i - 1]))
+			append_moh(moh, files[i]);
+	}
+
+	for (i = 0; i < count; ++i)
+	{
+		ast_free(files[i]);
+	}
+
+	ast_free(files);
+}
+
+// encode the ring for a write format
+static void encode_moh(ast_conf_moh *moh, int format_index, ast_conf_format format)
+{
+	struct ast_trans_pvt *trans = NULL;
+	struct ast_frame *fr = NULL;
+	int block;
+
+	if (!(moh->frames[format_index] = ast_calloc(moh->blocks, sizeof(ast_conf_sharedframe*))))
+	{
+		return;
+	}
+
+	if (format_index != AC_CONF_INDEX)
+	{
+#if	ASTERISK_SRC_VERSION < 1000
+		trans = trans_build_path(format, AST_FORMAT_CONFERENCE);
+#else
+		trans = trans_build_path(format, &ast_format_conference);
+#endif
+	}
+
+	// in ring order for the codecs that keep state, no delivery time so the
+	// channels time the blocks they write as they do for a generator
+	for (block = 0; block < moh->blocks; ++block)
+	{
+		if (!create_slinear_frame(&fr, (char*)(moh->samples + block * AST_CONF_BLOCK_SAMPLES)))
+			break;
+
+		moh->frames[format_index][block] = encode_frame(format_index, trans, fr, ast_tv(0, 0));
+	}
+
+	trans_free_path(trans);
+	ast_free(fr);
+}
+
+ast_conf_moh* find_moh(const char *name, int format_index, ast_conf_format format)
+{
+	ast_conf_moh *moh;
+	int found;
+
+	ast_mutex_lock(&moh_lock);
+
+	for (moh = mohs; moh; moh = moh->next)
+	{
+		if (!strcmp(moh->name, name))
+			break;
+	}
+
+	if (!moh && (moh = ast_calloc(1, sizeof(ast_conf_moh))))
+	{
+		ast_copy_string(moh->name, name, sizeof(moh->name));
+		ast_mutex_init(&moh->lock);
+
+		moh->next = mohs;
+		mohs = moh;
+	}
+
+	ast_mutex_unlock(&moh_lock);
+
+	if (!moh)
+	{
+		return NULL;
+	}
+
+	ast_mutex_lock(&moh->lock);
+
+	if (!moh->decoded)
+	{
+		// a class without files is cached without blocks
+		decode_moh(moh);
+		moh->decoded = 1;
+	}
+
+	if (moh->blocks && !moh->frames[format_index])
+	{
+		encode_moh(moh, format_index, format);
+	}
+
+	found = moh->blocks && moh->frames[format_index];
+
+	ast_mutex_unlock(&moh->lock);
+
+	return found ? moh : NULL;
+}
+
+//
+// manage moh functions
+//
+
+// called by conference.c:init_conference()
+int init_moh(void)
+{
+	ast_mutex_init(&moh_lock);
+
+	return 0;
+}
+
+// called by conference.c:dealloc_conference()
+void dealloc_moh(void)
+{
+	ast_conf_moh *moh;
+	int c, block;
+
+	while ((moh = mohs))
+	{
+		mohs = moh->next;
+
+		for (c = 0; c < AC_SUPPORTED_FORMATS; ++c)
+		{
+			if (!moh->frames[c])
+				continue;
+
+			for (block = 0; block < moh->blocks; ++block)
+			{
+				if (moh->frames[c][block])
+					release_shared_frame(&moh->frames[c][block]->fr);
+			}
+
+			ast_free(moh->frames[c]);
+		}
+
+		ast_free(moh->samples);
+		ast_mutex_destroy(&moh->lock);
+		ast_free(moh);
+	}
+
+	// return the frames released by the unloading thread to the depot
+	slab_thread_cleanup();
+
+	ast_mutex_destroy(&moh_lock);
+}
@@ -0,0 +1,80 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * Copyright (C) 2002, 2003 Junghanns.NET GmbH
+ * Copyright (C) 2003, 2004 HorizonLive.com, Inc.
+ * Copyright (C) 2005, 2005 Vipadia Limited
+ * Copyright (C) 2005, 2006 HorizonWimba, Inc.
+ * Copyright (C) 2007 Wimba, Inc.
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _KONFERENCE_MOH_H
+#define _KONFERENCE_MOH_H
+
+//
+// includes
+//
+
+#include "app_conference.h"
+#include "trans.h"
+
+//
+// defines
+//
+
+// music on hold class played when the channel has none
+#define AST_CONF_MOH_CLASS "default"
+
+// longest ring of a class in seconds, the rest of its files are not played
+#define AST_CONF_MOH_SECONDS 120
+
+//
+// struct declarations
+//
+
+typedef struct ast_conf_moh ast_conf_moh;
+
+// the files of a music on hold class decoded into a looping ring of blocks
+struct ast_conf_moh
+{
+	// next class in the cache
+	ast_conf_moh *next;
+
+	// class name
+	char name[80];
+
+	// held while the class is decoded or encoded for a write format
+	ast_mutex_t lock;
+	int decoded;
+
+	// samples of the ring ( no blocks when the class has no files )
+	short *samples;
+	int blocks;
+
+	// the ring encoded for each write format, on the first member at that format
+	ast_conf_sharedframe **frames[AC_SUPPORTED_FORMATS];
+};
+
+//
+// function declarations
+//
+
+// find a class in the cache, decoding its files on the first use and
+// encoding its ring for the write format of a member under the class lock, returns NULL when
+// the class has no files and the channel's music on hold plays instead
+ast_conf_moh* find_moh(const char *name, int format_index, ast_conf_format format);
+
+// called by conference.c:init_conference()
+int init_moh(void);
+// called by conference.c:dealloc_conference()
+void dealloc_moh(void);
+
+#endif
@@ -0,0 +1,389 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * Copyright (C) 2002, 2003 Junghanns.NET GmbH
+ * Copyright (C) 2003, 2004 HorizonLive.com, Inc.
+ * Copyright (C) 2005, 2005 Vipadia Limited
+ * Copyright (C) 2005, 2006 HorizonWimba, Inc.
+ * Copyright (C) 2007 Wimba, Inc.
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "asterisk/autoconfig.h"
+#include "slab.h"
+#include "conf_frame.h"
+
+#include <pthread.h>
+
+//
+// fixed size object caches with per-thread magazines
+//
+// each thread allocates from and frees to its own pair of magazines without
+// locking; only exchanging a full or empty magazine with the slab's depot takes
+// the slab lock, and the heap is used only when the depot runs dry
+//
+
+typedef struct ast_conf_magazine ast_conf_magazine;
+
+struct ast_conf_magazine
+{
+	// next magazine in the depot
+	ast_conf_magazine *next;
+
+	// number of objects in the magazine
+	int rounds;
+
+	// objects
+	void *objs[AST_CONF_SLAB_MAGAZINE_SIZE];
+};
+
+struct ast_conf_slab
+{
+	// slab name and object size
+	const char *name;
+	size_t size;
+
+	// depot lock
+	ast_mutex_t lock;
+
+	// depot of magazines holding objects and of empty magazines
+	ast_conf_magazine *full;
+	ast_conf_magazine *empty;
+
+	// statistics (updated under the depot lock)
+	unsigned int objects;
+	unsigned int full_magazines;
+	unsigned int exchanges;
+	unsigned int heap_allocs;
+};
+
+// per-thread magazines
+struct ast_conf_slab_cache
+{
+	ast_conf_magazine *loaded[AC_SUPPORTED_SLABS];
+	ast_conf_magazine *previous[AC_SUPPORTED_SLABS];
+};
+
+//
+// static variables
+//
+
+static struct ast_conf_slab slabs[AC_SUPPORTED_SLABS] = {
+	[AC_CONF_FRAME_SLAB] = { "conf frames", sizeof(conf_frame) },
+	[AC_FRAME_SLAB] = { "frames", sizeof(ast_conf_sharedframe) },
+};
+
+// key for the per-thread magazines
+static pthread_key_t slab_cache_key;
+
+#ifdef	CACHE_CONF_FRAMES
+
+static ast_conf_magazine* get_magazine(ast_conf_magazine **list)
+{
+	ast_conf_magazine *mag;
+
+	if ((mag = *list))
+	{
+		*list = mag->next;
+	}
+
+	return mag;
+}
+
+static void put_magazine(ast_conf_magazine **list, ast_conf_magazine *mag)
+{
+	mag->next = *list;
+	*list = mag;
+}
+
+static struct ast_conf_slab_cache* get_slab_cache(void)
+{
+	struct ast_conf_slab_cache *cache;
+
+	if (!(cache = pthread_getspecific(slab_cache_key)))
+	{
+		// first use by this thread
+		if (!(cache = ast_calloc(1, sizeof(struct ast_conf_slab_cache))))
+		{
+			return NULL;
+		}
+
+		pthread_setspecific(slab_cache_key, cache);
+	}
+
+	return cache;
+}
+
+void* slab_alloc(int slab_index)
+{
+	struct ast_conf_slab *slab = &slabs[slab_index];
+	struct ast_conf_slab_cache *cache = get_slab_cache();
+	ast_conf_magazine *mag;
+
+	// try the loaded magazine, then the previous one
+	if (cache && (mag = cache->loaded[slab_index]) && mag->rounds)
+	{
+		return mag->objs[--mag->rounds];
+	}
+
+	if (cache && (mag = cache->previous[slab_index]) && mag->rounds)
+	{
+		cache->previous[slab_index] = cache->loaded[slab_index];
+		cache->loaded[slab_index] = mag;
+		return mag->objs[--mag->rounds];
+	}
+
+	// exchange the empty previous magazine for one from the depot
+	ast_mutex_lock(&slab->lock);
+
+	if (cache && (mag = get_magazine(&slab->full)))
+	{
+		slab->full_magazines--;
+		slab->exchanges++;
+
+		if (cache->previous[slab_index])
+			put_magazine(&slab->empty, cache->previous[slab_index]);
+
+		cache->previous[slab_index] = cache->loaded[slab_index];
+		cache->loaded[slab_index] = mag;
+
+		ast_mutex_unlock(&slab->lock);
+
+		return mag->objs[--mag->rounds];
+	}
+
+	ast_mutex_unlock(&slab->lock);
+
+	// the depot is empty
+	void *obj;
+
+	if ((obj = ast_malloc(slab->size)))
+	{
+		ast_mutex_lock(&slab->lock);
+		slab->objects++;
+		slab->heap_allocs++;
+		ast_mutex_unlock(&slab->lock);
+	}
+
+	return obj;
+}
+
+void slab_free(int slab_index, void* obj)
+{
+	struct ast_conf_slab *slab = &slabs[slab_index];
+	struct ast_conf_slab_cache *cache = get_slab_cache();
+	ast_conf_magazine *mag;
+
+	if (!cache)
+	{
+		ast_mutex_lock(&slab->lock);
+		slab->objects--;
+		ast_mutex_unlock(&slab->lock);
+
+		ast_free(obj);
+		return;
+	}
+
+	// try the loaded magazine, then the previous one
+	if ((mag = cache->loaded[slab_index]) && mag->rounds < AST_CONF_SLAB_MAGAZINE_SIZE)
+	{
+		mag->objs[mag->rounds++] = obj;
+		return;
+	}
+
+	if ((mag = cache->previous[slab_index]) && !mag->rounds)
+	{
+		cache->previous[slab_index] = cache->loaded[slab_index];
+		cache->loaded[slab_index] = mag;
+		mag->objs[mag->rounds++] = obj;
+		return;
+	}
+
+	// exchange the full previous magazine for an empty one from the depot
+	ast_mutex_lock(&slab->lock);
+
+	if (!(mag = get_magazine(&slab->empty)) && !(mag = ast_calloc(1, sizeof(ast_conf_magazine))))
+	{
+		slab->objects--;
+		ast_mutex_unlock(&slab->lock);
+
+		ast_free(obj);
+		return;
+	}
+
+	slab->exchanges++;
+
+	if (cache->previous[slab_index])
+	{
+		put_magazine(&slab->full, cache->previous[slab_index]);
+		slab->full_magazines++;
+	}
+
+	ast_mutex_unlock(&slab->lock);
+
+	cache->previous[slab_index] = cache->loaded[slab_index];
+	cache->loaded[slab_index] = mag;
+	mag->objs[mag->rounds++] = obj;
+}
+
+void slab_thread_cleanup(void)
+{
+	struct ast_conf_slab_cache *cache;
+	int i;
+
+	if (!(cache = pthread_getspecific(slab_cache_key)))
+	{
+		return;
+	}
+
+	// return the thread's magazines to the depots
+	for (i = 0; i < AC_SUPPORTED_SLABS; ++i)
+	{
+		ast_conf_magazine *mags[2] = { cache->loaded[i], cache->previous[i] };
+		int j;
+
+		ast_mutex_lock(&slabs[i].lock);
+
+		for (j = 0; j < 2; ++j)
+		{
+			if (!mags[j])
+				continue;
+
+			if (mags[j]->rounds)
+			{
+				put_magazine(&slabs[i].full, mags[j]);
+				slabs[i].full_magazines++;
+			}
+			else
+			{
+				put_magazine(&slabs[i].empty, mags[j]);
+			}
+		}
+
+		ast_mutex_unlock(&slabs[i].lock);
+	}
+
+	pthread_setspecific(slab_cache_key, NULL);
+	ast_free(cache);
+}
+
+#else
+
+void* slab_alloc(int slab_index)
+{
+	return ast_malloc(slabs[slab_index].size);
+}
+
+void slab_free(int slab_index, void* obj)
+{
+	ast_free(obj);
+}
+
+void slab_thread_cleanup(void)
+{
+}
+
+#endif
+
+//
+// manage slab functions
+//
+
+// called by conference.c:init_conference()
+int init_slabs(void)
+{
+	int i;
+
+	if (pthread_key_create(&slab_cache_key, NULL))
+	{
+		ast_log(LOG_ERROR, "unable to create slab cache key\n");
+		return -1;
+	}
+
+	for (i = 0; i < AC_SUPPORTED_SLABS; ++i)
+	{
+		ast_mutex_init(&slabs[i].lock);
+
+#ifdef	CACHE_CONF_FRAMES
+		// fill the depot
+		int n;
+		for (n = 0; n < AST_CONF_SLAB_PREWARM; n += AST_CONF_SLAB_MAGAZINE_SIZE)
+		{
+			ast_conf_magazine *mag;
+
+			if (!(mag = ast_calloc(1, sizeof(ast_conf_magazine))))
+			{
+				break;
+			}
+
+			while (mag->rounds < AST_CONF_SLAB_MAGAZINE_SIZE && (mag->objs[mag->rounds] = ast_malloc(slabs[i].size)))
+			{
+				mag->rounds++;
+				slabs[i].objects++;
+			}
+
+			if (mag->rounds)
+			{
+				put_magazine(&slabs[i].full, mag);
+				slabs[i].full_magazines++;
+			}
+			else
+			{
+				put_magazine(&slabs[i].empty, mag);
+			}
+		}
+#endif
+	}
+
+	return 0;
+}
+
+// called by conference.c:dealloc_conference()
+void dealloc_slabs(void)
+{
+	int i;
+
+	// the module's threads have returned their magazines
+	for (i = 0; i < AC_SUPPORTED_SLABS; ++i)
+	{
+#ifdef	CACHE_CONF_FRAMES
+		ast_conf_magazine *mag;
+
+		while ((mag = get_magazine(&slabs[i].full)))
+		{
+			while (mag->rounds)
+				ast_free(mag->objs[--mag->rounds]);
+			ast_free(mag);
+		}
+
+		while ((mag = get_magazine(&slabs[i].empty)))
+		{
+			ast_free(mag);
+		}
+#endif
+		ast_mutex_destroy(&slabs[i].lock);
+	}
+
+	pthread_key_delete(slab_cache_key);
+}
+
+void slab_stats(int fd)
+{
+	int i;
+
+	ast_cli(fd, "%-20.20s %-20.20s %-20.20s %-20.20s %-20.20s %-20.20s\n", "Slab", "Object Size", "Objects", "Depot Magazines", "Exchanges", "Heap Allocs");
+
+	for (i = 0; i < AC_SUPPORTED_SLABS; ++i)
+	{
+		ast_cli(fd, "%-20.20s %-20d %-20u %-20u %-20u %-20u\n", slabs[i].name, (int)slabs[i].size,
+			slabs[i].objects, slabs[i].full_magazines, slabs[i].exchanges, slabs[i].heap_allocs);
+	}
+}
@@ -0,0 +1,67 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * Copyright (C) 2002, 2003 Junghanns.NET GmbH
+ * Copyright (C) 2003, 2004 HorizonLive.com, Inc.
+ * Copyright (C) 2005, 2005 Vipadia Limited
+ * Copyright (C) 2005, 2006 HorizonWimba, Inc.
+ * Copyright (C) 2007 Wimba, Inc.
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef _KONFERENCE_SLAB_H
+#define _KONFERENCE_SLAB_H
+
+//
+// includes
+//
+
+#include "app_conference.h"
+
+//
+// defines
+//
+
+// objects per magazine
+#define AST_CONF_SLAB_MAGAZINE_SIZE 32
+
+// objects allocated per slab when the module is loaded
+#ifndef	AST_CONF_SLAB_PREWARM
+#define AST_CONF_SLAB_PREWARM 1024
+#endif
+
+// slabs
+enum
+{
+	AC_CONF_FRAME_SLAB = 0,
+	AC_FRAME_SLAB,
+	AC_SUPPORTED_SLABS
+};
+
+//
+// function declarations
+//
+
+void* slab_alloc(int slab);
+void slab_free(int slab, void* obj);
+
+// called by a thread that allocated or freed objects before it exits
+void slab_thread_cleanup(void);
+
+// called by conference.c:init_conference()
+int init_slabs(void);
+// called by conference.c:dealloc_conference()
+void dealloc_slabs(void);
+
+// cli function
+void slab_stats(int fd);
+
+#endif
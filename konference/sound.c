@@ -0,0 +1,428 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * Copyright (C) 2002, 2003 Junghanns.NET GmbH
+ * Copyright (C) 2003, 2004 HorizonLive.com, Inc.
+ * Copyright (C) 2005, 2005 Vipadia Limited
+ * Copyright (C) 2005, 2006 HorizonWimba, Inc.
+ * Copyright (C) 2007 Wimba, Inc.
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "asterisk/autoconfig.h"
+#include "sound.h"
+#include "frame.h"
+#include "trans.h"
+
+#include <fcntl.h>
+
+//
+// sound files decoded to the conference format
+//
+// the module's own sounds are decoded once, when the module is loaded, and
+// cached; an announcement is decoded for its request and freed when it ends,
+// so a file recorded or replaced since is played as it is now. every
+// conference playing a sound mixes its blocks into the conference audio, so a
+// sound played to a conference costs one mix per tick whatever its size
+//
+
+//
+// static variables
+//
+
+static ast_mutex_t sound_lock;
+
+// decoded sounds
+static ast_conf_sound *sounds;
+
+// file formats tried for a sound, the conference format first
+static const char *sound_formats[] = {
+#ifdef	AC_USE_G722
+	"sln16",
+#endif
+	"sln",
+	"wav",
+	"gsm",
+	"ulaw",
+	"alaw",
+	"g722",
+};
+
+// sound directories tried for a sound after the language's, relative to the asterisk sounds directory
+static const char *sound_dirs[] = { "", "en/" };
+
+struct ast_filestream* open_sound(const char *name, const char *language)
+{
+	struct ast_filestream *fs;
+	char filename[256];
+	int d, f;
+
+	for (d = ast_strlen_zero(language) ? 0 : -1; d < (int)(sizeof(sound_dirs) / sizeof(sound_dirs[0])); ++d)
+	{
+		if (name[0] == '/')
+			snprintf(filename, sizeof(filename), "%s", name);
+		else if (d < 0)
+			snprintf(filename, sizeof(filename), "%s/%s", language, name);
+		else
+			snprintf(filename, sizeof(filename), "%s%s", sound_dirs[d], name);
+
+		for (f = 0; f < sizeof(sound_formats) / sizeof(sound_formats[0]); ++f)
+		{
+			if ((fs = ast_readfile(filename, sound_formats[f], NULL, O_RDONLY, 0, 0)))
+			{
+				return fs;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+// append a decoded frame to the samples of a sound, growing them by doubling
+// ( the samples are aligned for the mix kernels, so they are freed with free() )
+static int append_sound(ast_conf_sound *sound, int *count, int *size, const struct ast_frame *fr)
+{
+	short *samples;
+
+	if (*count + fr->samples > *size)
+	{
+		int grown = *size ? *size * 2 : AST_CONF_FRAMES_PER_SECOND * AST_CONF_BLOCK_SAMPLES;
+
+		while (grown < *count + fr->samples + AST_CONF_BLOCK_SAMPLES)
+			grown *= 2;
+
+		if (posix_memalign((void**)&samples, 64, grown * sizeof(short)))
+		{
+			ast_log(LOG_ERROR, "unable to malloc sound samples\n");
+			return -1;
+		}
+
+		if (sound->samples)
+			memcpy(samples, sound->samples, *count * sizeof(short));
+		free(sound->samples);
+
+		sound->samples = samples;
+		*size = grown;
+	}
+
+#if	ASTERISK_SRC_VERSION == 104
+	memcpy(sound->samples + *count, fr->data, fr->samples * sizeof(short));
+#else
+	memcpy(sound->samples + *count, fr->data.ptr, fr->samples * sizeof(short));
+#endif
+	*count += fr->samples;
+
+	return 0;
+}
+
+void decode_sound(ast_conf_sound *sound)
+{
+	struct ast_filestream *fs;
+	struct ast_trans_pvt *trans = NULL;
+	struct ast_frame *f, *df;
+	int count = 0, size = 0, built = 0;
+
+	if (!(fs = open_sound(sound->name, NULL)))
+	{
+		ast_log(LOG_NOTICE, "unable to open sound %s\n", sound->name);
+		return;
+	}
+
+	while ((f = ast_readframe(fs)))
+	{
+		if (f->frametype == AST_FRAME_VOICE)
+		{
+			// the path from the file's format
+			if (!built)
+			{
+#if	ASTERISK_SRC_VERSION == 104 || ASTERISK_SRC_VERSION == 106
+				trans = trans_build_path(AST_FORMAT_CONFERENCE, f->subclass);
+#elif	ASTERISK_SRC_VERSION < 1000
+				trans = trans_build_path(AST_FORMAT_CONFERENCE, f->subclass.codec);
+#else
+				trans = trans_build_path(&ast_format_conference, &f->subclass.format);
+#endif
+				built = 1;
+			}
+
+			if ((df = convert_frame(trans, f, 0)))
+			{
+				int res = append_sound(sound, &count, &size, df);
+
+				// free the translator's copy
+				if (trans)
+					ast_frfree(df);
+
+				if (res)
+				{
+					ast_frfree(f);
+					break;
+				}
+			}
+		}
+
+		ast_frfree(f);
+	}
+
+	ast_closestream(fs);
+	trans_free_path(trans);
+
+	// silence the rest of the last block
+	if ((sound->blocks = (count + AST_CONF_BLOCK_SAMPLES - 1) / AST_CONF_BLOCK_SAMPLES))
+	{
+		memset(sound->samples + count, 0, (sound->blocks * AST_CONF_BLOCK_SAMPLES - count) * sizeof(short));
+	}
+}
+
+ast_conf_sound* find_sound(const char *name)
+{
+	ast_conf_sound *sound;
+
+	ast_mutex_lock(&sound_lock);
+
+	for (sound = sounds; sound; sound = sound->next)
+	{
+		if (!strcmp(sound->name, name))
+			break;
+	}
+
+	if (!sound && (sound = ast_calloc(1, sizeof(ast_conf_sound))))
+	{
+		ast_copy_string(sound->name, name, sizeof(sound->name));
+
+		// a file that can't be read is cached without blocks
+		decode_sound(sound);
+
+		sound->next = sounds;
+		sounds = sound;
+	}
+
+	ast_mutex_unlock(&sound_lock);
+
+	return sound && sound->blocks ? sound : NULL;
+}
+
+ast_conf_sound* load_sound(const char *name)
+{
+	ast_conf_sound *sound;
+
+	if (!(sound = ast_calloc(1, sizeof(ast_conf_sound))))
+	{
+		return NULL;
+	}
+
+	ast_copy_string(sound->name, name, sizeof(sound->name));
+
+	decode_sound(sound);
+
+	if (!sound->blocks)
+	{
+		free_sound(sound);
+		return NULL;
+	}
+
+	return sound;
+}
+
+void free_sound(ast_conf_sound *sound)
+{
+	if (sound)
+	{
+		free(sound->samples);
+		ast_free(sound);
+	}
+}
+
+// free a playback and the announcement it owns
+static void free_playback(ast_conf_playback *playback)
+{
+	if (playback->queued)
+		free_sound(playback->sound);
+
+	ast_free(playback);
+}
+
+int play_sound(ast_conf_playback **playbacks, ast_conf_sound *sound)
+{
+	ast_conf_playback *playback;
+
+	if (!sound)
+	{
+		return -1;
+	}
+
+	for (playback = *playbacks; playback; playback = playback->next)
+	{
+		if (playback->sound == sound)
+			return 0;
+	}
+
+	if (!(playback = ast_calloc(1, sizeof(ast_conf_playback))))
+	{
+		return -1;
+	}
+
+	playback->sound = sound;
+	playback->next = *playbacks;
+	*playbacks = playback;
+
+	return 0;
+}
+
+int queue_sound(ast_conf_playback **playbacks, ast_conf_sound *sound, int duck)
+{
+	ast_conf_playback **link, *playback;
+	int wait = 0;
+
+	if (!sound)
+	{
+		return -1;
+	}
+
+	// wait for the blocks left of the queued announcements
+	for (link = playbacks; (playback = *link); link = &playback->next)
+	{
+		if (playback->queued && playback->sound->blocks - playback->block > wait)
+			wait = playback->sound->blocks - playback->block;
+	}
+
+	if (!(playback = ast_calloc(1, sizeof(ast_conf_playback))))
+	{
+		return -1;
+	}
+
+	playback->sound = sound;
+	playback->block = -wait;
+	playback->queued = 1;
+	playback->duck = duck;
+	*link = playback;
+
+	return 0;
+}
+
+int queued_sounds(ast_conf_playback *playbacks)
+{
+	int count = 0;
+
+	for (; playbacks; playbacks = playbacks->next)
+	{
+		if (playbacks->queued)
+			++count;
+	}
+
+	return count;
+}
+
+void stop_queued_sounds(ast_conf_playback **playbacks)
+{
+	ast_conf_playback **link, *playback;
+
+	for (link = playbacks; (playback = *link); )
+	{
+		if (playback->queued)
+		{
+			*link = playback->next;
+			free_playback(playback);
+		}
+		else
+		{
+			link = &playback->next;
+		}
+	}
+}
+
+void stop_sounds(ast_conf_playback **playbacks)
+{
+	ast_conf_playback *playback;
+
+	while ((playback = *playbacks))
+	{
+		*playbacks = playback->next;
+		free_playback(playback);
+	}
+}
+
+int next_sound_block(ast_conf_playback **playbacks, short *block, int *duck)
+{
+	ast_conf_playback **link, *playback;
+	int mixed = 0;
+
+	*duck = AST_CONF_SOUND_MIX;
+
+	for (link = playbacks; (playback = *link); )
+	{
+		// an announcement waiting for the ones before it
+		if (playback->block < 0)
+		{
+			++playback->block;
+			link = &playback->next;
+			continue;
+		}
+
+		if (playback->duck > *duck)
+			*duck = playback->duck;
+
+		const short *samples = playback->sound->samples + playback->block * AST_CONF_BLOCK_SAMPLES;
+
+		if (!mixed++)
+		{
+			memcpy(block, samples, AST_CONF_BLOCK_SAMPLES * sizeof(short));
+		}
+		else
+		{
+			mix_slinear_frames((char*)block, (const char*)samples);
+		}
+
+		// remove a finished sound
+		if (++playback->block == playback->sound->blocks)
+		{
+			*link = playback->next;
+			free_playback(playback);
+		}
+		else
+		{
+			link = &playback->next;
+		}
+	}
+
+	return mixed;
+}
+
+//
+// manage sound functions
+//
+
+// called by conference.c:init_conference()
+int init_sounds(void)
+{
+	ast_mutex_init(&sound_lock);
+
+	// decode the join and leave sounds now, so no member waits for them
+	find_sound(AST_CONF_JOIN_SOUND);
+	find_sound(AST_CONF_LEAVE_SOUND);
+
+	return 0;
+}
+
+// called by conference.c:dealloc_conference()
+void dealloc_sounds(void)
+{
+	ast_conf_sound *sound;
+
+	while ((sound = sounds))
+	{
+		sounds = sound->next;
+		free(sound->samples);
+		ast_free(sound);
+	}
+
+	ast_mutex_destroy(&sound_lock);
+}
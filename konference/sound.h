@@ -0,0 +1,116 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * Copyright (C) 2002, 2003 Junghanns.NET GmbH
+ * Copyright (C) 2003, 2004 HorizonLive.com, Inc.
+ * Copyright (C) 2005, 2005 Vipadia Limited
+ * Copyright (C) 2005, 2006 HorizonWimba, Inc.
+ * Copyright (C) 2007 Wimba, Inc.
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef _KONFERENCE_SOUND_H
+#define _KONFERENCE_SOUND_H
+
+//
+// includes
+//
+
+#include "app_conference.h"
+
+//
+// defines
+//
+
+// sounds overlaid on the conference audio when a member joins or leaves
+#define AST_CONF_JOIN_SOUND "join"
+#define AST_CONF_LEAVE_SOUND "leave"
+
+// conference audio while an announcement plays
+#define AST_CONF_SOUND_MIX 0
+#define AST_CONF_SOUND_DUCK 1
+#define AST_CONF_SOUND_MUTE 2
+
+//
+// struct declarations
+//
+
+typedef struct ast_conf_sound ast_conf_sound;
+typedef struct ast_conf_playback ast_conf_playback;
+
+// a sound file decoded to the conference format
+struct ast_conf_sound
+{
+	// next sound in the cache ( unused by announcements )
+	ast_conf_sound *next;
+
+	// file name
+	char name[80];
+
+	// samples padded to whole blocks ( no blocks when the file can't be read ),
+	// aligned for the mix kernels and freed with free()
+	short *samples;
+	int blocks;
+};
+
+// a sound playing in a conference
+struct ast_conf_playback
+{
+	// next playing sound
+	ast_conf_playback *next;
+
+	// sound and its next block ( negative while it waits for the announcements before it )
+	ast_conf_sound *sound;
+	int block;
+
+	// an announcement queued behind the others and what it does to the conference audio
+	int queued;
+	int duck;
+};
+
+//
+// function declarations
+//
+
+// open a sound file in the language's sounds directory or the default ones, in any format
+struct ast_filestream* open_sound(const char *name, const char *language);
+
+// decode a sound file without caching it
+void decode_sound(ast_conf_sound *sound);
+
+// find one of the module's sounds in the cache, decoding the file on the first use
+ast_conf_sound* find_sound(const char *name);
+// decode a sound for one announcement, returns NULL if the file can't be read
+ast_conf_sound* load_sound(const char *name);
+// free a sound that isn't cached
+void free_sound(ast_conf_sound *sound);
+
+// start playing a sound unless it is already playing ( called with the conference write lock )
+int play_sound(ast_conf_playback **playbacks, ast_conf_sound *sound);
+// queue an announcement to play after the others, the playback owns the loaded sound
+// and frees it when it ends ( called with the conference write lock )
+int queue_sound(ast_conf_playback **playbacks, ast_conf_sound *sound, int duck);
+// count the queued announcements
+int queued_sounds(ast_conf_playback *playbacks);
+// stop playing the queued announcements ( called with the conference write lock )
+void stop_queued_sounds(ast_conf_playback **playbacks);
+// stop playing the sounds
+void stop_sounds(ast_conf_playback **playbacks);
+// mix the next block of the playing sounds and set the strongest ducking of the conference audio,
+// returns 0 when no sound is playing
+int next_sound_block(ast_conf_playback **playbacks, short *block, int *duck);
+
+// called by conference.c:init_conference()
+int init_sounds(void);
+// called by conference.c:dealloc_conference()
+void dealloc_sounds(void);
+
+#endif
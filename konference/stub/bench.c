@@ -0,0 +1,371 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// conference tick benchmark built against the asterisk stub
+//
+// usage: konference_bench [-m members] [-s speakers] [-t seconds] [-f slin|ulaw|alaw] [-a arguments] [-n] [-v]
+//
+// joins members stub channels to one conference, feeds a tone to the
+// speakers every 20 milliseconds and reports the conference mix cost
+// ( microseconds per tick, as smoothed by the mixer ) and the cpu time used.
+// with -n the other members send low level noise, as telephones do
+//
+// with -v it instead times the silence detection of members frames at
+// 8 kHz and 16 kHz, one instance at a time and batched as the mixer does
+// ( libwebrtc ) or through the speex preprocessor ( libspeex ), in float
+// and fixed point with the memory of a preprocessor state
+//
+
+#include <math.h>
+#include <sys/resource.h>
+
+#include "stub.h"
+
+#if	SILDET == 1
+#include "webrtc_vad.h"
+#elif	SILDET == 2
+#include <malloc.h>
+#include "speex_preprocess.h"
+#endif
+
+struct bench_member
+{
+	struct ast_channel *chan;
+	pthread_t thread;
+};
+
+static char bench_data[256];
+
+static void *member_thread(void *data)
+{
+	struct bench_member *m = data;
+
+	stub_app_exec("Konference", m->chan, bench_data);
+
+	return NULL;
+}
+
+// mix cost of the bench conference from the konference stats command, -1 if not found
+static int mix_cost(void)
+{
+	char out[4096], name[64];
+	char *line;
+	int members, cost;
+	unsigned int in_overruns, in_underruns, out_overruns;
+
+	stub_cli_capture("konference stats", out, sizeof(out));
+
+	for (line = strtok(out, "\n"); line; line = strtok(NULL, "\n"))
+	{
+		if (sscanf(line, "%63s %d %u %u %u %d", name, &members, &in_overruns, &in_underruns, &out_overruns, &cost) == 6 && !strcmp(name, "bench"))
+			return cost;
+	}
+
+	return -1;
+}
+
+static double cpu_seconds(void)
+{
+	struct rusage ru;
+
+	getrusage(RUSAGE_SELF, &ru);
+
+	return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+#if	SILDET == 1 || SILDET == 2
+static double thread_cpu_seconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+#endif
+
+#if	SILDET == 1
+// silence detection cost of members frames at rate, per frame and as a share of one core
+static void vad_bench(int members, int seconds, int rate)
+{
+	int length = rate / 50, i, n, tick, batched;
+
+	VadInst **handles = calloc(members, sizeof(*handles));
+	int16_t *samples = calloc(members, length * sizeof(*samples));
+	int16_t **frames = calloc(members, sizeof(*frames));
+	int *vads = calloc(members, sizeof(*vads));
+
+	for (i = 0; i < members; ++i)
+	{
+		WebRtcVad_Create(&handles[i]);
+		frames[i] = samples + i * length;
+	}
+
+	for (batched = 0; batched < 2; ++batched)
+	{
+		for (i = 0; i < members; ++i)
+		{
+			WebRtcVad_Init(handles[i]);
+			WebRtcVad_set_mode(handles[i], 1);
+		}
+
+		srand(1);
+		double cpu = 0;
+
+		for (tick = 0; tick < seconds * 50; ++tick)
+		{
+			// a few talkers over the hiss of the rest
+			for (i = 0; i < members; ++i)
+				for (n = 0; n < length; ++n)
+					frames[i][n] = (i % 16 ? 0 : 8000 * sin(2 * M_PI * 400 * (tick * length + n) / rate)) + rand() % 64 - 32;
+
+			double start = thread_cpu_seconds();
+
+			if (batched)
+				WebRtcVad_ProcessBatch(handles, members, rate, frames, length, vads);
+			else
+				for (i = 0; i < members; ++i)
+					vads[i] = WebRtcVad_Process(handles[i], rate, frames[i], length);
+
+			cpu += thread_cpu_seconds() - start;
+		}
+
+		printf("vad %d Hz %s %.2f us/frame %.1f%% of one core\n", rate, batched ? "batched" : "single ", 1e6 * cpu / ((double)members * seconds * 50), 100 * cpu / seconds);
+	}
+
+	for (i = 0; i < members; ++i)
+		WebRtcVad_Free(handles[i]);
+
+	free(vads);
+	free(frames);
+	free(samples);
+	free(handles);
+}
+#elif	SILDET == 2
+// speex preprocessor cost of members frames at rate ( vad only, as members default to )
+static void vad_bench(int members, int seconds, int rate, int fixed)
+{
+	int length = rate / 50, vad = 1, i, n, tick;
+
+	SpeexPreprocessState **states = calloc(members, sizeof(*states));
+	short *samples = calloc(length, sizeof(*samples));
+
+	size_t heap = mallinfo2().uordblks;
+
+	for (i = 0; i < members; ++i)
+	{
+		states[i] = (fixed ? speex_preprocess_state_init_fixed : speex_preprocess_state_init)(length, rate);
+		speex_preprocess_ctl(states[i], SPEEX_PREPROCESS_SET_VAD, &vad);
+	}
+
+	heap = mallinfo2().uordblks - heap;
+
+	srand(1);
+	double cpu = 0;
+
+	for (tick = 0; tick < seconds * 50; ++tick)
+	{
+		for (i = 0; i < members; ++i)
+		{
+			// a few talkers over the hiss of the rest
+			for (n = 0; n < length; ++n)
+				samples[n] = (i % 16 ? 0 : 8000 * sin(2 * M_PI * 400 * (tick * length + n) / rate)) + rand() % 64 - 32;
+
+			double start = thread_cpu_seconds();
+
+			speex_preprocess(states[i], samples, NULL);
+
+			cpu += thread_cpu_seconds() - start;
+		}
+	}
+
+	printf("vad %d Hz preprocess %s %.2f us/frame %.1f%% of one core %zu bytes/state\n", rate, fixed ? "fixed" : "float", 1e6 * cpu / ((double)members * seconds * 50), 100 * cpu / seconds, heap / members);
+
+	for (i = 0; i < members; ++i)
+		speex_preprocess_state_destroy(states[i]);
+
+	free(samples);
+	free(states);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+	int members = 1000, speakers = 3, seconds = 5;
+	format_t format = AST_FORMAT_ULAW;
+	const char *args = "";
+	int noise = 0, vad = 0;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "m:s:t:f:a:nv")) != -1)
+	{
+		switch (opt)
+		{
+			case 'm':
+				members = atoi(optarg);
+				break;
+			case 's':
+				speakers = atoi(optarg);
+				break;
+			case 't':
+				seconds = atoi(optarg);
+				break;
+			case 'f':
+				format = !strcmp(optarg, "slin") ? AST_FORMAT_SLINEAR : !strcmp(optarg, "alaw") ? AST_FORMAT_ALAW : AST_FORMAT_ULAW;
+				break;
+			case 'a':
+				args = optarg;
+				break;
+			case 'n':
+				noise = 1;
+				break;
+			case 'v':
+				vad = 1;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-m members] [-s speakers] [-t seconds] [-f slin|ulaw|alaw] [-a arguments] [-n] [-v]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if (vad)
+	{
+#if	SILDET == 1 || SILDET == 2
+		printf("members %d seconds %d\n", members, seconds);
+#if	SILDET == 1
+		vad_bench(members, seconds, 8000);
+		vad_bench(members, seconds, 16000);
+#else
+		vad_bench(members, seconds, 8000, 0);
+		vad_bench(members, seconds, 8000, 1);
+		vad_bench(members, seconds, 16000, 0);
+		vad_bench(members, seconds, 16000, 1);
+#endif
+		return 0;
+#else
+		fprintf(stderr, "silence detection is off\n");
+		return 1;
+#endif
+	}
+
+	if (speakers > members)
+		speakers = members;
+
+	snprintf(bench_data, sizeof(bench_data), "bench,%s", args);
+
+	stub_log_level = LOG_ERROR;
+
+	if (stub_load_module())
+	{
+		fprintf(stderr, "unable to load module\n");
+		return 1;
+	}
+
+	struct bench_member *m = calloc(members, sizeof(*m));
+
+	//
+	// join the members and wait until they're all in the conference
+	//
+
+	for (i = 0; i < members; ++i)
+	{
+		char name[32];
+
+		snprintf(name, sizeof(name), "Stub/%d", i);
+
+		if (!(m[i].chan = stub_channel_new(name, format)) || pthread_create(&m[i].thread, NULL, member_thread, &m[i]))
+		{
+			fprintf(stderr, "unable to start member %d\n", i);
+			return 1;
+		}
+	}
+
+	while (stub_manager_total() < members)
+		usleep(10000);
+
+	//
+	// feed the speakers and sample the mix cost
+	//
+
+	short tone[160], hiss[160];
+
+	for (i = 0; i < 160; ++i)
+	{
+		tone[i] = 8000 * sin(2 * M_PI * 400 * i / 8000);
+		hiss[i] = rand() % 64 - 32;
+	}
+
+	unsigned long written = 0;
+	for (i = 0; i < members; ++i)
+		written -= m[i].chan->stub_frames_written;
+
+	struct timeval next = ast_tvnow();
+	double cpu_start = cpu_seconds();
+	long cost_sum = 0;
+	int cost_samples = 0, tick;
+
+	for (tick = 0; tick < seconds * 50; ++tick)
+	{
+		for (i = 0; i < speakers; ++i)
+			stub_channel_queue_voice(m[i].chan, tone, 160);
+		for (i = speakers; noise && i < members; ++i)
+			stub_channel_queue_voice(m[i].chan, hiss, 160);
+
+		// sample five times a second once the smoothed cost has settled
+		if (tick >= 50 && !(tick % 10))
+		{
+			int cost = mix_cost();
+
+			if (cost >= 0)
+			{
+				cost_sum += cost;
+				cost_samples++;
+			}
+		}
+
+		next = ast_tvadd(next, ast_tv(0, 20000));
+
+		long wait = ast_tvdiff_us(next, ast_tvnow());
+		if (wait > 0)
+			usleep(wait);
+	}
+
+	double cpu = cpu_seconds() - cpu_start;
+
+	for (i = 0; i < members; ++i)
+		written += m[i].chan->stub_frames_written;
+
+	//
+	// hang up
+	//
+
+	for (i = 0; i < members; ++i)
+		stub_channel_hangup(m[i].chan);
+
+	for (i = 0; i < members; ++i)
+	{
+		pthread_join(m[i].thread, NULL);
+		stub_channel_free(m[i].chan);
+	}
+
+	free(m);
+
+	stub_unload_module();
+
+	printf("members %d speakers %d format %s seconds %d%s\n", members, speakers, ast_getformatname(format), seconds, noise ? " noise" : "");
+	printf("mix cost %.1f us/tick\n", cost_samples ? (double)cost_sum / cost_samples : -1.0);
+	printf("cpu %.1f%% of one core\n", 100 * cpu / seconds);
+	printf("frames written %.1f per member per second\n", (double)written / members / seconds);
+
+	return 0;
+}
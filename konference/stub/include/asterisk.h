@@ -0,0 +1,580 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// minimal stand-in for the asterisk 1.8 api used by the conference engine
+//
+// every asterisk/*.h include used by the module resolves to this file,
+// so the engine can be built, tested and benchmarked without an asterisk
+// source tree (see stub.c for the implementation)
+//
+
+#ifndef _KONFERENCE_STUB_ASTERISK_H
+#define _KONFERENCE_STUB_ASTERISK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/time.h>
+
+#define PACKAGE_VERSION "1.8"
+
+#define ASTERISK_FILE_VERSION(file, version)
+#define ASTERISK_GPL_KEY "stub"
+
+//
+// options and paths
+//
+
+extern int ast_opt_high_priority;
+extern char ast_config_AST_SYSTEM_NAME[];
+extern const char *ast_config_AST_DATA_DIR;
+
+//
+// logging
+//
+
+enum { LOG_DEBUG, LOG_VERBOSE, LOG_NOTICE, LOG_WARNING, LOG_ERROR };
+
+void stub_log(int level, const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
+#define ast_log stub_log
+
+//
+// memory and strings
+//
+
+#define ast_malloc(len) malloc(len)
+#define ast_calloc(num, len) calloc(num, len)
+#define ast_realloc(p, len) realloc(p, len)
+#define ast_free(p) free(p)
+static inline char *ast_strdup(const char *s)
+{
+	return s ? strdup(s) : NULL;
+}
+#define ast_strdupa(s) \
+	({ const char *__old = (s); size_t __len = strlen(__old) + 1; \
+	   char *__new = alloca(__len); memcpy(__new, __old, __len); __new; })
+
+static inline int ast_strlen_zero(const char *s)
+{
+	return !s || *s == '\0';
+}
+
+static inline void ast_copy_string(char *dst, const char *src, size_t size)
+{
+	if (!size)
+		return;
+	strncpy(dst, src, size - 1);
+	dst[size - 1] = '\0';
+}
+
+#define S_OR(a, b) (!ast_strlen_zero(a) ? (a) : (b))
+#define S_COR(a, b, c) ((a) && !ast_strlen_zero(b) ? (b) : (c))
+
+//
+// locking
+//
+
+typedef pthread_mutex_t ast_mutex_t;
+typedef pthread_rwlock_t ast_rwlock_t;
+typedef pthread_cond_t ast_cond_t;
+
+#define AST_MUTEX_DEFINE_STATIC(m) static ast_mutex_t m = PTHREAD_MUTEX_INITIALIZER
+
+#define ast_mutex_init(m) pthread_mutex_init(m, NULL)
+#define ast_mutex_destroy(m) pthread_mutex_destroy(m)
+#define ast_mutex_lock(m) pthread_mutex_lock(m)
+#define ast_mutex_trylock(m) pthread_mutex_trylock(m)
+#define ast_mutex_unlock(m) pthread_mutex_unlock(m)
+
+#define ast_rwlock_init(l) pthread_rwlock_init(l, NULL)
+#define ast_rwlock_destroy(l) pthread_rwlock_destroy(l)
+#define ast_rwlock_rdlock(l) pthread_rwlock_rdlock(l)
+#define ast_rwlock_wrlock(l) pthread_rwlock_wrlock(l)
+#define ast_rwlock_unlock(l) pthread_rwlock_unlock(l)
+
+#define ast_cond_init(c, a) pthread_cond_init(c, a)
+#define ast_cond_destroy(c) pthread_cond_destroy(c)
+#define ast_cond_signal(c) pthread_cond_signal(c)
+#define ast_cond_broadcast(c) pthread_cond_broadcast(c)
+#define ast_cond_wait(c, m) pthread_cond_wait(c, m)
+#define ast_cond_timedwait(c, m, t) pthread_cond_timedwait(c, m, t)
+
+#define ast_pthread_create(a, b, c, d) pthread_create(a, b, c, d)
+
+#define ast_atomic_fetchadd_int(p, v) __sync_fetch_and_add(p, v)
+#define ast_atomic_dec_and_test(p) (__sync_sub_and_fetch(p, 1) == 0)
+
+//
+// linked lists
+//
+
+#define AST_LIST_HEAD(name, type) \
+struct name { \
+	struct type *first; \
+	struct type *last; \
+	ast_mutex_t lock; \
+}
+
+#define AST_LIST_HEAD_NOLOCK(name, type) \
+struct name { \
+	struct type *first; \
+	struct type *last; \
+}
+
+#define AST_LIST_ENTRY(type) \
+struct { \
+	struct type *next; \
+}
+
+#define AST_LIST_HEAD_INIT(head) \
+	do { (head)->first = (head)->last = NULL; ast_mutex_init(&(head)->lock); } while (0)
+#define AST_LIST_HEAD_INIT_NOLOCK(head) \
+	do { (head)->first = (head)->last = NULL; } while (0)
+#define AST_LIST_HEAD_DESTROY(head) \
+	do { (head)->first = (head)->last = NULL; ast_mutex_destroy(&(head)->lock); } while (0)
+
+#define AST_LIST_LOCK(head) ast_mutex_lock(&(head)->lock)
+#define AST_LIST_UNLOCK(head) ast_mutex_unlock(&(head)->lock)
+
+#define AST_LIST_FIRST(head) ((head)->first)
+#define AST_LIST_EMPTY(head) (AST_LIST_FIRST(head) == NULL)
+#define AST_LIST_NEXT(elm, field) ((elm)->field.next)
+
+#define AST_LIST_TRAVERSE(head, var, field) \
+	for ((var) = (head)->first; (var); (var) = (var)->field.next)
+
+#define AST_LIST_INSERT_HEAD(head, elm, field) \
+	do { \
+		(elm)->field.next = (head)->first; \
+		(head)->first = (elm); \
+		if (!(head)->last) \
+			(head)->last = (elm); \
+	} while (0)
+
+#define AST_LIST_INSERT_TAIL(head, elm, field) \
+	do { \
+		(elm)->field.next = NULL; \
+		if (!(head)->first) { \
+			(head)->first = (elm); \
+			(head)->last = (elm); \
+		} else { \
+			(head)->last->field.next = (elm); \
+			(head)->last = (elm); \
+		} \
+	} while (0)
+
+#define AST_LIST_REMOVE_HEAD(head, field) \
+	({ \
+		typeof((head)->first) __cur = (head)->first; \
+		if (__cur) { \
+			(head)->first = __cur->field.next; \
+			__cur->field.next = NULL; \
+			if ((head)->last == __cur) \
+				(head)->last = NULL; \
+		} \
+		__cur; \
+	})
+
+#define AST_LIST_REMOVE(head, elm, field) \
+	({ \
+		typeof(elm) __elm = (elm); \
+		if (__elm) { \
+			if ((head)->first == __elm) { \
+				(head)->first = __elm->field.next; \
+				if ((head)->last == __elm) \
+					(head)->last = NULL; \
+			} else { \
+				typeof(elm) __prev = (head)->first; \
+				while (__prev && __prev->field.next != __elm) \
+					__prev = __prev->field.next; \
+				if (__prev) { \
+					__prev->field.next = __elm->field.next; \
+					if ((head)->last == __elm) \
+						(head)->last = __prev; \
+				} else { \
+					__elm = NULL; \
+				} \
+			} \
+			if (__elm) \
+				__elm->field.next = NULL; \
+		} \
+		__elm; \
+	})
+
+//
+// time
+//
+
+static inline struct timeval ast_tvnow(void)
+{
+	struct timeval t;
+	gettimeofday(&t, NULL);
+	return t;
+}
+
+static inline struct timeval ast_tv(time_t sec, suseconds_t usec)
+{
+	struct timeval t = { .tv_sec = sec, .tv_usec = usec };
+	return t;
+}
+
+static inline int ast_tvzero(const struct timeval t)
+{
+	return t.tv_sec == 0 && t.tv_usec == 0;
+}
+
+static inline struct timeval ast_tvadd(struct timeval a, struct timeval b)
+{
+	a.tv_sec += b.tv_sec;
+	a.tv_usec += b.tv_usec;
+	if (a.tv_usec >= 1000000)
+	{
+		a.tv_sec++;
+		a.tv_usec -= 1000000;
+	}
+	return a;
+}
+
+static inline struct timeval ast_tvsub(struct timeval a, struct timeval b)
+{
+	a.tv_sec -= b.tv_sec;
+	a.tv_usec -= b.tv_usec;
+	if (a.tv_usec < 0)
+	{
+		a.tv_sec--;
+		a.tv_usec += 1000000;
+	}
+	return a;
+}
+
+static inline int64_t ast_tvdiff_us(struct timeval end, struct timeval start)
+{
+	return (end.tv_sec - start.tv_sec) * (int64_t) 1000000 + end.tv_usec - start.tv_usec;
+}
+
+static inline int64_t ast_tvdiff_ms(struct timeval end, struct timeval start)
+{
+	return ((end.tv_sec - start.tv_sec) * 1000) + (((1000000 + end.tv_usec - start.tv_usec) / 1000) - 1000);
+}
+
+//
+// formats
+//
+
+typedef int64_t format_t;
+
+#define AST_FORMAT_G723_1	(1ULL << 0)
+#define AST_FORMAT_GSM		(1ULL << 1)
+#define AST_FORMAT_ULAW		(1ULL << 2)
+#define AST_FORMAT_ALAW		(1ULL << 3)
+#define AST_FORMAT_SLINEAR	(1ULL << 6)
+#define AST_FORMAT_G729A	(1ULL << 8)
+#define AST_FORMAT_SPEEX	(1ULL << 9)
+#define AST_FORMAT_G722		(1ULL << 12)
+#define AST_FORMAT_SLINEAR16	(1ULL << 15)
+
+char *ast_getformatname(format_t format);
+char *ast_getformatname_multiple(char *buf, size_t size, format_t format);
+
+//
+// frames
+//
+
+enum ast_frame_type {
+	AST_FRAME_DTMF_END = 1,
+	AST_FRAME_VOICE,
+	AST_FRAME_VIDEO,
+	AST_FRAME_CONTROL,
+	AST_FRAME_NULL,
+	AST_FRAME_IAX,
+	AST_FRAME_TEXT,
+	AST_FRAME_IMAGE,
+	AST_FRAME_HTML,
+	AST_FRAME_CNG,
+	AST_FRAME_MODEM,
+	AST_FRAME_DTMF_BEGIN,
+};
+#define AST_FRAME_DTMF AST_FRAME_DTMF_END
+
+enum ast_control_frame_type {
+	AST_CONTROL_HANGUP = 1,
+};
+
+#define AST_FRIENDLY_OFFSET 64
+
+#define AST_MALLOCD_HDR		(1 << 0)
+#define AST_MALLOCD_DATA	(1 << 1)
+#define AST_MALLOCD_SRC		(1 << 2)
+
+struct ast_frame {
+	enum ast_frame_type frametype;
+	union {
+		int integer;
+		format_t codec;
+	} subclass;
+	int datalen;
+	int samples;
+	int mallocd;
+	size_t mallocd_hdr_len;
+	int offset;
+	const char *src;
+	union {
+		void *ptr;
+		uint32_t uint32;
+		char pad[8];
+	} data;
+	struct timeval delivery;
+	AST_LIST_ENTRY(ast_frame) frame_list;
+	unsigned int flags;
+	long ts;
+	long len;
+	int seqno;
+};
+
+extern struct ast_frame ast_null_frame;
+
+struct ast_frame *ast_frdup(const struct ast_frame *fr);
+struct ast_frame *ast_frisolate(struct ast_frame *fr);
+void ast_frame_free(struct ast_frame *fr, int cache);
+#define ast_frfree(fr) ast_frame_free(fr, 1)
+int ast_frame_adjust_volume(struct ast_frame *f, int adjustment);
+
+//
+// translation
+//
+
+/* g.711 tables, the encoders indexed by the top 14 bits of a sample */
+extern short __ast_mulaw[256];
+extern short __ast_alaw[256];
+extern unsigned char __ast_lin2mu[16384];
+extern unsigned char __ast_lin2a[16384];
+#define AST_MULAW(a) (__ast_mulaw[(a)])
+#define AST_ALAW(a) (__ast_alaw[(a)])
+#define AST_LIN2MU(a) (__ast_lin2mu[((unsigned short)(a)) >> 2])
+#define AST_LIN2A(a) (__ast_lin2a[((unsigned short)(a)) >> 2])
+
+/* the fields asterisk's translator core shares with its users, and the stub's own */
+struct ast_trans_pvt {
+	struct ast_frame f;
+	int samples;
+	int datalen;
+	struct ast_trans_pvt *next;
+	struct timeval nextin;
+	struct timeval nextout;
+	/* stub: formats and output buffer, reused by every translation like asterisk's */
+	format_t dest;
+	format_t source;
+	char buf[AST_FRIENDLY_OFFSET + 1280 * sizeof(short)];
+};
+
+struct ast_trans_pvt *ast_translator_build_path(format_t dest, format_t source);
+void ast_translator_free_path(struct ast_trans_pvt *tr);
+struct ast_frame *ast_translate(struct ast_trans_pvt *tr, struct ast_frame *f, int consume);
+
+//
+// channels
+//
+
+#define AST_FLAG_MOH (1 << 6)
+
+#define ast_test_flag(p, flag) ((p)->flags & (flag))
+#define ast_set_flag(p, flag) ((p)->flags |= (flag))
+#define ast_clear_flag(p, flag) ((p)->flags &= ~(flag))
+
+enum ast_channel_state {
+	AST_STATE_DOWN,
+	AST_STATE_RESERVED,
+	AST_STATE_OFFHOOK,
+	AST_STATE_DIALING,
+	AST_STATE_RING,
+	AST_STATE_RINGING,
+	AST_STATE_UP,
+	AST_STATE_BUSY,
+};
+
+struct ast_party_name {
+	char *str;
+	int valid;
+};
+
+struct ast_party_number {
+	char *str;
+	int valid;
+};
+
+struct ast_party_id {
+	struct ast_party_name name;
+	struct ast_party_number number;
+};
+
+struct ast_party_caller {
+	struct ast_party_id id;
+};
+
+struct ast_filestream;
+struct stub_var;
+
+struct stub_channel_queue {
+	struct ast_frame *first;
+	struct ast_frame *last;
+	int count;
+};
+
+struct ast_channel {
+	char name[80];
+	char uniqueid[32];
+	char language[20];
+	const char *musicclass;
+	struct ast_party_caller caller;
+	format_t nativeformats;
+	format_t readformat;
+	format_t writeformat;
+	int _state;
+	unsigned int flags;
+	struct ast_filestream *stream;
+	struct ast_audiohook_list *audiohooks;
+
+	// stub state: frames waiting to be read, frames written
+	pthread_mutex_t stub_lock;
+	pthread_cond_t stub_cond;
+	struct stub_channel_queue stub_readq;
+	int stub_hangup;
+	unsigned long stub_frames_written;
+	unsigned long stub_bytes_written;
+	void (*stub_write_hook)(struct ast_channel *chan, struct ast_frame *f);
+	void *stub_data;
+	struct stub_var *stub_vars;
+	struct ast_filestream *stub_streams;
+};
+
+int ast_answer(struct ast_channel *chan);
+int ast_waitfor(struct ast_channel *chan, int ms);
+struct ast_frame *ast_read(struct ast_channel *chan);
+int ast_write(struct ast_channel *chan, struct ast_frame *frame);
+int ast_queue_frame(struct ast_channel *chan, struct ast_frame *f);
+
+#define ast_channel_lock(chan) pthread_mutex_lock(&(chan)->stub_lock)
+#define ast_channel_unlock(chan) pthread_mutex_unlock(&(chan)->stub_lock)
+
+//
+// files and music on hold
+//
+
+struct ast_filestream *ast_openstream(struct ast_channel *chan, const char *filename, const char *preflang);
+struct ast_filestream *ast_readfile(const char *filename, const char *type, const char *comment, int flags, int check, mode_t mode);
+struct ast_frame *ast_readframe(struct ast_filestream *s);
+int ast_closestream(struct ast_filestream *f);
+int ast_stopstream(struct ast_channel *c);
+
+int ast_moh_start(struct ast_channel *chan, const char *mclass, const char *interpclass);
+void ast_moh_stop(struct ast_channel *chan);
+
+int ast_say_number(struct ast_channel *chan, int num, const char *ints, const char *lang, const char *options);
+
+//
+// pbx, applications and modules
+//
+
+int pbx_builtin_setvar_helper(struct ast_channel *chan, const char *name, const char *value);
+void pbx_retrieve_variable(struct ast_channel *c, const char *var, char **ret, char *workspace, int workspacelen, void *headp);
+
+struct ast_module_user;
+
+struct ast_module_user *ast_module_user_add(struct ast_channel *chan);
+void ast_module_user_remove(struct ast_module_user *u);
+void ast_module_user_hangup_all(void);
+
+int ast_register_application(const char *app, int (*execute)(struct ast_channel *, const char *), const char *synopsis, const char *description);
+int ast_unregister_application(const char *app);
+
+#define AST_MODULE_INFO_STANDARD(keystr, desc) \
+	int stub_load_module(void) { return load_module(); } \
+	int stub_unload_module(void) { return unload_module(); }
+
+int stub_load_module(void);
+int stub_unload_module(void);
+
+#define AST_APP_ARG(name) char *name;
+#define AST_DECLARE_APP_ARGS(name, arglist) \
+	struct { unsigned int argc; char *argv[0]; arglist } name = { 0, }
+#define AST_STANDARD_APP_ARGS(args, parse) \
+	args.argc = stub_app_separate_args(parse, ',', args.argv, \
+		((sizeof(args) - offsetof(typeof(args), argv)) / sizeof(args.argv[0])))
+
+unsigned int stub_app_separate_args(char *buf, char delim, char **array, int arraylen);
+
+//
+// manager
+//
+
+#define EVENT_FLAG_USER (1 << 6)
+
+int manager_event(int category, const char *event, const char *fmt, ...) __attribute__ ((format (printf, 3, 4)));
+
+//
+// cli
+//
+
+#define RESULT_SUCCESS 0
+#define RESULT_SHOWUSAGE 1
+#define RESULT_FAILURE 2
+
+#define CLI_SUCCESS ((char *) RESULT_SUCCESS)
+#define CLI_SHOWUSAGE ((char *) RESULT_SHOWUSAGE)
+#define CLI_FAILURE ((char *) RESULT_FAILURE)
+
+enum ast_cli_command {
+	CLI_INIT = -2,
+	CLI_GENERATE = -3,
+};
+
+struct ast_cli_args {
+	const int fd;
+	const int argc;
+	const char * const *argv;
+	const char *line;
+	const char *word;
+	const int pos;
+	int n;
+};
+
+struct ast_cli_entry {
+	const char *summary;
+	const char *usage;
+	const char *command;
+	int args;
+	char *(*handler)(struct ast_cli_entry *e, int cmd, struct ast_cli_args *a);
+};
+
+#define AST_CLI_DEFINE(fn, txt) { .handler = fn, .summary = txt }
+
+void ast_cli(int fd, const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
+char *ast_cli_complete(const char *word, const char * const choices[], int pos);
+int ast_cli_register_multiple(struct ast_cli_entry *e, int len);
+int ast_cli_unregister_multiple(struct ast_cli_entry *e, int len);
+
+// run a registered cli command line, output goes to fd
+int stub_cli_command(int fd, const char *line);
+
+#endif
@@ -0,0 +1,2 @@
+/* see ../asterisk.h */
+#include "asterisk.h"
@@ -0,0 +1,1227 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// implementation of the asterisk stub: logging, frames, a slinear/ulaw/alaw
+// translator, in-memory channels, applications, an in-memory manager event
+// sink and a cli command dispatcher
+//
+
+#include <math.h>
+
+#include "stub.h"
+
+//
+// options and paths
+//
+
+int ast_opt_high_priority = 0;
+char ast_config_AST_SYSTEM_NAME[20] = "";
+const char *ast_config_AST_DATA_DIR = "/var/lib/asterisk";
+
+//
+// logging
+//
+
+int stub_log_level = LOG_WARNING;
+
+static const char *log_levels[] = { "DEBUG", "VERBOSE", "NOTICE", "WARNING", "ERROR" };
+
+// watched text and the messages of any level containing it
+static char log_watch[80];
+static int log_matches;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void stub_log(int level, const char *fmt, ...)
+{
+	char message[512];
+	va_list ap;
+
+	pthread_mutex_lock(&log_lock);
+	if (log_watch[0])
+	{
+		va_start(ap, fmt);
+		vsnprintf(message, sizeof(message), fmt, ap);
+		va_end(ap);
+
+		if (strstr(message, log_watch))
+			log_matches++;
+	}
+	pthread_mutex_unlock(&log_lock);
+
+	if (level < stub_log_level)
+		return;
+
+	fprintf(stderr, "[%s] ", log_levels[level]);
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+void stub_log_watch(const char *text)
+{
+	pthread_mutex_lock(&log_lock);
+	snprintf(log_watch, sizeof(log_watch), "%s", text);
+	log_matches = 0;
+	pthread_mutex_unlock(&log_lock);
+}
+
+int stub_log_matches(void)
+{
+	int matches;
+
+	pthread_mutex_lock(&log_lock);
+	matches = log_matches;
+	pthread_mutex_unlock(&log_lock);
+
+	return matches;
+}
+
+//
+// formats
+//
+
+char *ast_getformatname(format_t format)
+{
+	switch (format)
+	{
+		case AST_FORMAT_G723_1: return "g723";
+		case AST_FORMAT_GSM: return "gsm";
+		case AST_FORMAT_ULAW: return "ulaw";
+		case AST_FORMAT_ALAW: return "alaw";
+		case AST_FORMAT_SLINEAR: return "slin";
+		case AST_FORMAT_G729A: return "g729";
+		case AST_FORMAT_SPEEX: return "speex";
+		case AST_FORMAT_G722: return "g722";
+		case AST_FORMAT_SLINEAR16: return "slin16";
+		default: return "unknown";
+	}
+}
+
+char *ast_getformatname_multiple(char *buf, size_t size, format_t format)
+{
+	format_t bit;
+	size_t len;
+
+	snprintf(buf, size, "0x%llx (", (unsigned long long)format);
+
+	for (bit = 1; bit && bit <= format; bit <<= 1)
+	{
+		if (format & bit)
+		{
+			len = strlen(buf);
+			snprintf(buf + len, size - len, "%s|", ast_getformatname(bit));
+		}
+	}
+
+	len = strlen(buf);
+	if (buf[len - 1] == '|')
+		buf[len - 1] = ')';
+	else
+		snprintf(buf + len, size - len, "nothing)");
+
+	return buf;
+}
+
+//
+// frames
+//
+
+struct ast_frame ast_null_frame = { .frametype = AST_FRAME_NULL, };
+
+static const char frame_src[] = "stub";
+
+struct ast_frame *ast_frdup(const struct ast_frame *fr)
+{
+	struct ast_frame *out;
+	size_t len = sizeof(struct ast_frame) + AST_FRIENDLY_OFFSET + fr->datalen;
+
+	if (!(out = malloc(len)))
+		return NULL;
+
+	*out = *fr;
+	out->mallocd = AST_MALLOCD_HDR;
+	out->mallocd_hdr_len = len;
+	out->offset = AST_FRIENDLY_OFFSET;
+	out->src = frame_src;
+	out->frame_list.next = NULL;
+
+	if (fr->datalen)
+	{
+		out->data.ptr = (char *)(out + 1) + AST_FRIENDLY_OFFSET;
+		memcpy(out->data.ptr, fr->data.ptr, fr->datalen);
+	}
+	else
+	{
+		out->data.ptr = NULL;
+	}
+
+	return out;
+}
+
+struct ast_frame *ast_frisolate(struct ast_frame *fr)
+{
+	struct ast_frame *out;
+
+	// a frame from ast_frdup() is already self contained
+	if (fr->mallocd == AST_MALLOCD_HDR)
+		return fr;
+
+	if ((out = ast_frdup(fr)))
+		ast_frfree(fr);
+
+	return out;
+}
+
+void ast_frame_free(struct ast_frame *fr, int cache)
+{
+	if (!fr)
+		return;
+
+	if (fr->mallocd & AST_MALLOCD_DATA)
+		free((char *)fr->data.ptr - fr->offset);
+
+	if (fr->mallocd & AST_MALLOCD_SRC)
+		free((char *)fr->src);
+
+	if (fr->mallocd & AST_MALLOCD_HDR)
+		free(fr);
+}
+
+int ast_frame_adjust_volume(struct ast_frame *f, int adjustment)
+{
+	short *samples = f->data.ptr;
+	int count;
+
+	if (f->frametype != AST_FRAME_VOICE || (f->subclass.codec != AST_FORMAT_SLINEAR && f->subclass.codec != AST_FORMAT_SLINEAR16))
+		return -1;
+
+	if (!adjustment)
+		return 0;
+
+	for (count = 0; count < f->samples; ++count)
+	{
+		int sample = adjustment > 0 ? samples[count] * adjustment : samples[count] / -adjustment;
+
+		samples[count] = sample > 32767 ? 32767 : sample < -32768 ? -32768 : sample;
+	}
+
+	return 0;
+}
+
+//
+// g.711 ( the encoders are indexed by the top 14 bits of a sample like asterisk's )
+//
+
+short __ast_mulaw[256];
+short __ast_alaw[256];
+
+unsigned char __ast_lin2mu[16384];
+unsigned char __ast_lin2a[16384];
+
+static unsigned char linear2ulaw(int sample)
+{
+	static const int exp_lut[256] = {
+		0,0,1,1,2,2,2,2,3,3,3,3,3,3,3,3,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
+		5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,
+		6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,
+		6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,
+		7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+		7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+		7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,
+		7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7
+	};
+	int sign = (sample >> 8) & 0x80;
+
+	if (sign)
+		sample = -sample;
+	if (sample > 32635)
+		sample = 32635;
+
+	sample += 0x84;
+
+	int exponent = exp_lut[(sample >> 7) & 0xff];
+	int mantissa = (sample >> (exponent + 3)) & 0x0f;
+
+	return ~(sign | (exponent << 4) | mantissa);
+}
+
+static int ulaw2linear(unsigned char u)
+{
+	static const int exp_lut[8] = { 0, 132, 396, 924, 1980, 4092, 8316, 16764 };
+
+	u = ~u;
+
+	int sign = u & 0x80;
+	int exponent = (u >> 4) & 0x07;
+	int mantissa = u & 0x0f;
+	int sample = exp_lut[exponent] + (mantissa << (exponent + 3));
+
+	return sign ? -sample : sample;
+}
+
+static unsigned char linear2alaw(int sample)
+{
+	int mask, seg, aval;
+
+	if (sample >= 0)
+	{
+		mask = 0xd5;
+	}
+	else
+	{
+		mask = 0x55;
+		sample = -sample - 1;
+	}
+
+	sample >>= 3;
+
+	for (seg = 0; seg < 8 && sample > (0xff >> (7 - seg)) * 2 + 1; ++seg)
+		;
+
+	if (seg >= 8)
+		return 0x7f ^ mask;
+
+	aval = seg << 4;
+	aval |= seg < 2 ? (sample >> 1) & 0x0f : (sample >> seg) & 0x0f;
+
+	return aval ^ mask;
+}
+
+static int alaw2linear(unsigned char a)
+{
+	int t, seg;
+
+	a ^= 0x55;
+
+	t = (a & 0x0f) << 4;
+	seg = (a & 0x70) >> 4;
+
+	switch (seg)
+	{
+		case 0:
+			t += 8;
+			break;
+		case 1:
+			t += 0x108;
+			break;
+		default:
+			t += 0x108;
+			t <<= seg - 1;
+	}
+
+	return a & 0x80 ? t : -t;
+}
+
+static void __attribute__((constructor)) init_g711(void)
+{
+	int i;
+
+	for (i = 0; i < 256; ++i)
+	{
+		__ast_mulaw[i] = ulaw2linear(i);
+		__ast_alaw[i] = alaw2linear(i);
+	}
+
+	for (i = 0; i < 16384; ++i)
+	{
+		short sample = (short)(i << 2);
+
+		__ast_lin2mu[i] = linear2ulaw(sample);
+		__ast_lin2a[i] = linear2alaw(sample);
+	}
+}
+
+//
+// translation ( between ulaw, alaw, slinear and slinear16, and a gsm stand-in
+// whose frames carry ulaw samples, so a member can talk in a codec the
+// conference can't estimate the energy of )
+//
+
+#define STUB_MAX_SAMPLES 1280
+
+static int stub_translatable(format_t format)
+{
+	return format == AST_FORMAT_ULAW || format == AST_FORMAT_ALAW || format == AST_FORMAT_SLINEAR || format == AST_FORMAT_SLINEAR16 || format == AST_FORMAT_GSM;
+}
+
+struct ast_trans_pvt *ast_translator_build_path(format_t dest, format_t source)
+{
+	struct ast_trans_pvt *tr;
+
+	if (dest == source || !stub_translatable(dest) || !stub_translatable(source))
+	{
+		ast_log(LOG_DEBUG, "no translator path from %s to %s\n", ast_getformatname(source), ast_getformatname(dest));
+		return NULL;
+	}
+
+	if (!(tr = calloc(1, sizeof(*tr))))
+		return NULL;
+
+	tr->dest = dest;
+	tr->source = source;
+
+	return tr;
+}
+
+void ast_translator_free_path(struct ast_trans_pvt *tr)
+{
+	free(tr);
+}
+
+int stub_translate_delay = 0;
+
+struct ast_frame *ast_translate(struct ast_trans_pvt *tr, struct ast_frame *f, int consume)
+{
+	short in[STUB_MAX_SAMPLES], samples[STUB_MAX_SAMPLES];
+	int count = f->samples, i;
+	int delay = __atomic_load_n(&stub_translate_delay, __ATOMIC_RELAXED);
+
+	if (delay)
+		usleep(delay);
+
+	if (f->frametype != AST_FRAME_VOICE || f->subclass.codec != tr->source || count > STUB_MAX_SAMPLES / 2)
+	{
+		if (consume)
+			ast_frfree(f);
+		return NULL;
+	}
+
+	// decode, resample ( by repeating or averaging samples ) and encode
+	stub_decode_frame(f, in, count);
+
+	if (tr->source != AST_FORMAT_SLINEAR16 && tr->dest == AST_FORMAT_SLINEAR16)
+	{
+		for (i = 0; i < count; ++i)
+			samples[2 * i] = samples[2 * i + 1] = in[i];
+		count *= 2;
+	}
+	else if (tr->source == AST_FORMAT_SLINEAR16 && tr->dest != AST_FORMAT_SLINEAR16)
+	{
+		count /= 2;
+		for (i = 0; i < count; ++i)
+			samples[i] = (in[2 * i] + in[2 * i + 1]) / 2;
+	}
+	else
+	{
+		memcpy(samples, in, count * sizeof(short));
+	}
+
+	char *out = tr->buf + AST_FRIENDLY_OFFSET;
+	unsigned char *dst = (unsigned char *)out;
+
+	switch (tr->dest)
+	{
+		case AST_FORMAT_ULAW:
+		case AST_FORMAT_GSM:
+			for (i = 0; i < count; ++i) dst[i] = AST_LIN2MU(samples[i]);
+			tr->f.datalen = count;
+			break;
+		case AST_FORMAT_ALAW:
+			for (i = 0; i < count; ++i) dst[i] = AST_LIN2A(samples[i]);
+			tr->f.datalen = count;
+			break;
+		default:
+			memcpy(out, samples, count * sizeof(short));
+			tr->f.datalen = count * sizeof(short);
+			break;
+	}
+
+	tr->f.frametype = AST_FRAME_VOICE;
+	tr->f.subclass.codec = tr->dest;
+	tr->f.samples = count;
+	tr->f.mallocd = 0;
+	tr->f.offset = AST_FRIENDLY_OFFSET;
+	tr->f.src = frame_src;
+	tr->f.data.ptr = out;
+	tr->f.delivery = f->delivery;
+	tr->f.frame_list.next = NULL;
+
+	if (consume)
+		ast_frfree(f);
+
+	return &tr->f;
+}
+
+int stub_decode_frame(const struct ast_frame *f, short *samples, int count)
+{
+	const unsigned char *in = f->data.ptr;
+	int i;
+
+	if (f->frametype != AST_FRAME_VOICE)
+		return 0;
+
+	if (count > f->samples)
+		count = f->samples;
+
+	switch (f->subclass.codec)
+	{
+		case AST_FORMAT_SLINEAR:
+		case AST_FORMAT_SLINEAR16:
+			memcpy(samples, in, count * sizeof(short));
+			break;
+		case AST_FORMAT_ULAW:
+		case AST_FORMAT_GSM:
+			for (i = 0; i < count; ++i) samples[i] = AST_MULAW(in[i]);
+			break;
+		case AST_FORMAT_ALAW:
+			for (i = 0; i < count; ++i) samples[i] = AST_ALAW(in[i]);
+			break;
+		default:
+			return 0;
+	}
+
+	return count;
+}
+
+//
+// channels
+//
+
+struct stub_var
+{
+	char *name;
+	char *value;
+	struct stub_var *next;
+};
+
+// sound file stream, freed with its channel
+struct ast_filestream
+{
+	struct ast_filestream *next;
+	int frames;
+	int level;
+	// read without a channel, freed when closed
+	int unowned;
+};
+
+static int channel_uniqueint;
+
+struct ast_channel *stub_channel_new(const char *name, format_t format)
+{
+	struct ast_channel *chan;
+
+	if (!(chan = calloc(1, sizeof(*chan))))
+		return NULL;
+
+	ast_copy_string(chan->name, name, sizeof(chan->name));
+	snprintf(chan->uniqueid, sizeof(chan->uniqueid), "stub-%d", ast_atomic_fetchadd_int(&channel_uniqueint, 1));
+	ast_copy_string(chan->language, "en", sizeof(chan->language));
+
+	chan->nativeformats = chan->readformat = chan->writeformat = format;
+	chan->_state = AST_STATE_DOWN;
+
+	pthread_mutex_init(&chan->stub_lock, NULL);
+	pthread_cond_init(&chan->stub_cond, NULL);
+
+	return chan;
+}
+
+void stub_channel_free(struct ast_channel *chan)
+{
+	struct ast_frame *f;
+	struct stub_var *var;
+	struct ast_filestream *stream;
+
+	while ((f = chan->stub_readq.first))
+	{
+		chan->stub_readq.first = f->frame_list.next;
+		ast_frfree(f);
+	}
+
+	while ((var = chan->stub_vars))
+	{
+		chan->stub_vars = var->next;
+		free(var->name);
+		free(var->value);
+		free(var);
+	}
+
+	while ((stream = chan->stub_streams))
+	{
+		chan->stub_streams = stream->next;
+		free(stream);
+	}
+
+	pthread_mutex_destroy(&chan->stub_lock);
+	pthread_cond_destroy(&chan->stub_cond);
+
+	free(chan);
+}
+
+void stub_channel_hangup(struct ast_channel *chan)
+{
+	pthread_mutex_lock(&chan->stub_lock);
+	chan->stub_hangup = 1;
+	pthread_cond_signal(&chan->stub_cond);
+	pthread_mutex_unlock(&chan->stub_lock);
+}
+
+int ast_answer(struct ast_channel *chan)
+{
+	chan->_state = AST_STATE_UP;
+	return 0;
+}
+
+int ast_queue_frame(struct ast_channel *chan, struct ast_frame *f)
+{
+	struct ast_frame *dup;
+
+	if (!(dup = ast_frdup(f)))
+		return -1;
+
+	pthread_mutex_lock(&chan->stub_lock);
+
+	if (chan->stub_readq.last)
+		chan->stub_readq.last->frame_list.next = dup;
+	else
+		chan->stub_readq.first = dup;
+	chan->stub_readq.last = dup;
+	chan->stub_readq.count++;
+
+	pthread_cond_signal(&chan->stub_cond);
+	pthread_mutex_unlock(&chan->stub_lock);
+
+	return 0;
+}
+
+int stub_channel_queue_voice(struct ast_channel *chan, const short *samples, int count)
+{
+	struct ast_frame f = { .frametype = AST_FRAME_VOICE, };
+	unsigned char buf[STUB_MAX_SAMPLES * sizeof(short)];
+	int i;
+
+	if (count > STUB_MAX_SAMPLES)
+		return -1;
+
+	f.subclass.codec = chan->readformat;
+	f.samples = count;
+	f.src = frame_src;
+	f.data.ptr = buf;
+
+	switch (chan->readformat)
+	{
+		case AST_FORMAT_SLINEAR:
+		case AST_FORMAT_SLINEAR16:
+			memcpy(buf, samples, count * sizeof(short));
+			f.datalen = count * sizeof(short);
+			break;
+		case AST_FORMAT_ULAW:
+		case AST_FORMAT_GSM:
+			for (i = 0; i < count; ++i) buf[i] = AST_LIN2MU(samples[i]);
+			f.datalen = count;
+			break;
+		case AST_FORMAT_ALAW:
+			for (i = 0; i < count; ++i) buf[i] = AST_LIN2A(samples[i]);
+			f.datalen = count;
+			break;
+		default:
+			return -1;
+	}
+
+	return ast_queue_frame(chan, &f);
+}
+
+int stub_channel_queue_dtmf(struct ast_channel *chan, char digit)
+{
+	struct ast_frame f = { .frametype = AST_FRAME_DTMF, };
+
+	f.subclass.integer = digit;
+	f.src = frame_src;
+
+	return ast_queue_frame(chan, &f);
+}
+
+int ast_waitfor(struct ast_channel *chan, int ms)
+{
+	int ready;
+
+	pthread_mutex_lock(&chan->stub_lock);
+
+	if (!chan->stub_readq.first && !chan->stub_hangup && ms)
+	{
+		struct timeval now = ast_tvnow();
+		struct timeval end = ast_tvadd(now, ast_tv(ms / 1000, (ms % 1000) * 1000));
+		struct timespec ts = { .tv_sec = end.tv_sec, .tv_nsec = end.tv_usec * 1000 };
+
+		while (!chan->stub_readq.first && !chan->stub_hangup)
+		{
+			if (pthread_cond_timedwait(&chan->stub_cond, &chan->stub_lock, &ts) == ETIMEDOUT)
+				break;
+		}
+	}
+
+	ready = chan->stub_readq.first || chan->stub_hangup;
+
+	pthread_mutex_unlock(&chan->stub_lock);
+
+	return ready ? ms > 0 ? ms : 1 : 0;
+}
+
+struct ast_frame *ast_read(struct ast_channel *chan)
+{
+	struct ast_frame *f;
+
+	pthread_mutex_lock(&chan->stub_lock);
+
+	if ((f = chan->stub_readq.first))
+	{
+		if (!(chan->stub_readq.first = f->frame_list.next))
+			chan->stub_readq.last = NULL;
+		chan->stub_readq.count--;
+		f->frame_list.next = NULL;
+	}
+	else if (!chan->stub_hangup)
+	{
+		f = &ast_null_frame;
+	}
+
+	pthread_mutex_unlock(&chan->stub_lock);
+
+	return f;
+}
+
+int ast_write(struct ast_channel *chan, struct ast_frame *frame)
+{
+	pthread_mutex_lock(&chan->stub_lock);
+
+	chan->stub_frames_written++;
+	chan->stub_bytes_written += frame->datalen;
+
+	if (chan->stub_write_hook)
+		chan->stub_write_hook(chan, frame);
+
+	pthread_mutex_unlock(&chan->stub_lock);
+
+	return 0;
+}
+
+//
+// files ( every sound is a stream of a tone or of silence ) and music on hold
+//
+
+// frames read from each sound file and their tone level
+int stub_sound_frames = 0;
+int stub_sound_level = 0;
+
+int stub_stream_opens = 0;
+int stub_file_reads = 0;
+
+int stub_sound_open_delay = 0;
+
+struct ast_filestream *ast_openstream(struct ast_channel *chan, const char *filename, const char *preflang)
+{
+	struct ast_filestream *s;
+
+	if (stub_sound_open_delay)
+		usleep(stub_sound_open_delay * 1000);
+
+	if (!(s = calloc(1, sizeof(*s))))
+		return NULL;
+
+	s->frames = stub_sound_frames;
+	s->level = stub_sound_level;
+
+	__atomic_add_fetch(&stub_stream_opens, 1, __ATOMIC_RELAXED);
+
+	pthread_mutex_lock(&chan->stub_lock);
+	s->next = chan->stub_streams;
+	chan->stub_streams = s;
+	chan->stream = s;
+	pthread_mutex_unlock(&chan->stub_lock);
+
+	return s;
+}
+
+struct ast_filestream *ast_readfile(const char *filename, const char *type, const char *comment, int flags, int check, mode_t mode)
+{
+	struct ast_filestream *s;
+
+	if (stub_sound_open_delay)
+		usleep(stub_sound_open_delay * 1000);
+
+	if (!(s = calloc(1, sizeof(*s))))
+		return NULL;
+
+	s->frames = stub_sound_frames;
+	s->level = stub_sound_level;
+	s->unowned = 1;
+
+	__atomic_add_fetch(&stub_file_reads, 1, __ATOMIC_RELAXED);
+
+	return s;
+}
+
+struct ast_frame *ast_readframe(struct ast_filestream *s)
+{
+	short samples[160];
+	struct ast_frame f = { .frametype = AST_FRAME_VOICE, };
+	int i;
+
+	if (!s->frames)
+		return NULL;
+
+	s->frames--;
+
+	for (i = 0; i < 160; ++i)
+		samples[i] = s->level * sin(2 * M_PI * 1000 * i / 8000);
+
+	f.subclass.codec = AST_FORMAT_SLINEAR;
+	f.samples = 160;
+	f.datalen = sizeof(samples);
+	f.data.ptr = samples;
+
+	return ast_frdup(&f);
+}
+
+int ast_closestream(struct ast_filestream *f)
+{
+	// streams opened for a channel are freed with it
+	if (f->unowned)
+		free(f);
+	return 0;
+}
+
+int ast_stopstream(struct ast_channel *c)
+{
+	c->stream = NULL;
+	return 0;
+}
+
+int ast_moh_start(struct ast_channel *chan, const char *mclass, const char *interpclass)
+{
+	ast_set_flag(chan, AST_FLAG_MOH);
+	return 0;
+}
+
+void ast_moh_stop(struct ast_channel *chan)
+{
+	ast_clear_flag(chan, AST_FLAG_MOH);
+}
+
+int ast_say_number(struct ast_channel *chan, int num, const char *ints, const char *lang, const char *options)
+{
+	char value[16];
+
+	snprintf(value, sizeof(value), "%d", num);
+
+	return pbx_builtin_setvar_helper(chan, "STUB_SAID", value);
+}
+
+//
+// pbx
+//
+
+int pbx_builtin_setvar_helper(struct ast_channel *chan, const char *name, const char *value)
+{
+	struct stub_var *var;
+
+	pthread_mutex_lock(&chan->stub_lock);
+
+	for (var = chan->stub_vars; var && strcmp(var->name, name); var = var->next)
+		;
+
+	if (!var && (var = calloc(1, sizeof(*var))))
+	{
+		var->name = strdup(name);
+		var->next = chan->stub_vars;
+		chan->stub_vars = var;
+	}
+
+	if (var)
+	{
+		free(var->value);
+		var->value = strdup(value ? value : "");
+	}
+
+	pthread_mutex_unlock(&chan->stub_lock);
+
+	return var ? 0 : -1;
+}
+
+const char *stub_channel_getvar(struct ast_channel *chan, const char *name)
+{
+	struct stub_var *var;
+
+	for (var = chan->stub_vars; var && strcmp(var->name, name); var = var->next)
+		;
+
+	return var ? var->value : NULL;
+}
+
+void pbx_retrieve_variable(struct ast_channel *c, const char *var, char **ret, char *workspace, int workspacelen, void *headp)
+{
+	const char *value;
+
+	pthread_mutex_lock(&c->stub_lock);
+
+	if ((value = stub_channel_getvar(c, var)))
+	{
+		ast_copy_string(workspace, value, workspacelen);
+		*ret = workspace;
+	}
+	else
+	{
+		*ret = NULL;
+	}
+
+	pthread_mutex_unlock(&c->stub_lock);
+}
+
+//
+// modules and applications
+//
+
+struct ast_module_user
+{
+	struct ast_channel *chan;
+	struct ast_module_user *next;
+};
+
+static ast_mutex_t module_user_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct ast_module_user *module_users;
+
+struct ast_module_user *ast_module_user_add(struct ast_channel *chan)
+{
+	struct ast_module_user *u;
+
+	if (!(u = calloc(1, sizeof(*u))))
+		return NULL;
+
+	u->chan = chan;
+
+	ast_mutex_lock(&module_user_lock);
+	u->next = module_users;
+	module_users = u;
+	ast_mutex_unlock(&module_user_lock);
+
+	return u;
+}
+
+void ast_module_user_remove(struct ast_module_user *u)
+{
+	struct ast_module_user **p;
+
+	if (!u)
+		return;
+
+	ast_mutex_lock(&module_user_lock);
+	for (p = &module_users; *p; p = &(*p)->next)
+	{
+		if (*p == u)
+		{
+			*p = u->next;
+			break;
+		}
+	}
+	ast_mutex_unlock(&module_user_lock);
+
+	free(u);
+}
+
+void ast_module_user_hangup_all(void)
+{
+	struct ast_module_user *u;
+
+	ast_mutex_lock(&module_user_lock);
+	for (u = module_users; u; u = u->next)
+		stub_channel_hangup(u->chan);
+	ast_mutex_unlock(&module_user_lock);
+}
+
+#define STUB_MAX_APPS 8
+
+static struct
+{
+	const char *name;
+	int (*execute)(struct ast_channel *, const char *);
+} apps[STUB_MAX_APPS];
+
+int ast_register_application(const char *app, int (*execute)(struct ast_channel *, const char *), const char *synopsis, const char *description)
+{
+	int i;
+
+	for (i = 0; i < STUB_MAX_APPS; ++i)
+	{
+		if (!apps[i].name)
+		{
+			apps[i].name = app;
+			apps[i].execute = execute;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+int ast_unregister_application(const char *app)
+{
+	int i;
+
+	for (i = 0; i < STUB_MAX_APPS; ++i)
+	{
+		if (apps[i].name && !strcasecmp(apps[i].name, app))
+		{
+			apps[i].name = NULL;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+int stub_app_exec(const char *app, struct ast_channel *chan, const char *data)
+{
+	int i;
+
+	for (i = 0; i < STUB_MAX_APPS; ++i)
+	{
+		if (apps[i].name && !strcasecmp(apps[i].name, app))
+			return apps[i].execute(chan, data);
+	}
+
+	ast_log(LOG_ERROR, "no application %s\n", app);
+	return -1;
+}
+
+unsigned int stub_app_separate_args(char *buf, char delim, char **array, int arraylen)
+{
+	unsigned int argc = 0;
+	char delims[2] = { delim, '\0' };
+
+	while (buf && argc < arraylen)
+		array[argc++] = strsep(&buf, delims);
+
+	return argc;
+}
+
+//
+// manager event sink
+//
+
+static struct
+{
+	char name[64];
+	char body[1024];
+} events[STUB_MANAGER_EVENTS];
+
+static int event_total;
+static ast_mutex_t event_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int manager_event(int category, const char *event, const char *fmt, ...)
+{
+	va_list ap;
+
+	ast_mutex_lock(&event_lock);
+
+	int slot = event_total++ % STUB_MANAGER_EVENTS;
+
+	ast_copy_string(events[slot].name, event, sizeof(events[slot].name));
+	va_start(ap, fmt);
+	vsnprintf(events[slot].body, sizeof(events[slot].body), fmt, ap);
+	va_end(ap);
+
+	ast_mutex_unlock(&event_lock);
+
+	return 0;
+}
+
+int stub_manager_total(void)
+{
+	return event_total;
+}
+
+int stub_manager_count(const char *event)
+{
+	int slot, count = 0;
+
+	ast_mutex_lock(&event_lock);
+	for (slot = 0; slot < event_total && slot < STUB_MANAGER_EVENTS; ++slot)
+	{
+		if (!strcmp(events[slot].name, event))
+			count++;
+	}
+	ast_mutex_unlock(&event_lock);
+
+	return count;
+}
+
+int stub_manager_find(const char *event, const char *text)
+{
+	int slot, found = 0;
+
+	ast_mutex_lock(&event_lock);
+	for (slot = 0; slot < event_total && slot < STUB_MANAGER_EVENTS && !found; ++slot)
+	{
+		found = !strcmp(events[slot].name, event) && strstr(events[slot].body, text);
+	}
+	ast_mutex_unlock(&event_lock);
+
+	return found;
+}
+
+void stub_manager_reset(void)
+{
+	ast_mutex_lock(&event_lock);
+	event_total = 0;
+	ast_mutex_unlock(&event_lock);
+}
+
+//
+// cli
+//
+
+#define STUB_MAX_CLI 64
+#define STUB_MAX_ARGS 32
+
+static struct ast_cli_entry *cli_entries[STUB_MAX_CLI];
+
+void ast_cli(int fd, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vdprintf(fd, fmt, ap);
+	va_end(ap);
+}
+
+char *ast_cli_complete(const char *word, const char * const choices[], int pos)
+{
+	int i, which = 0;
+
+	for (i = 0; choices[i]; ++i)
+	{
+		if (!strncasecmp(word, choices[i], strlen(word)) && ++which > pos)
+			return strdup(choices[i]);
+	}
+
+	return NULL;
+}
+
+int ast_cli_register_multiple(struct ast_cli_entry *e, int len)
+{
+	int i, j;
+
+	for (i = 0; i < len; ++i)
+	{
+		// the handler fills in its command and usage
+		e[i].handler(&e[i], CLI_INIT, NULL);
+
+		for (j = 0; j < STUB_MAX_CLI && cli_entries[j]; ++j)
+			;
+		if (j == STUB_MAX_CLI)
+			return -1;
+
+		cli_entries[j] = &e[i];
+	}
+
+	return 0;
+}
+
+int ast_cli_unregister_multiple(struct ast_cli_entry *e, int len)
+{
+	int i, j;
+
+	for (i = 0; i < len; ++i)
+	{
+		for (j = 0; j < STUB_MAX_CLI; ++j)
+		{
+			if (cli_entries[j] == &e[i])
+				cli_entries[j] = NULL;
+		}
+	}
+
+	return 0;
+}
+
+// number of leading words of argv that match command, 0 if it doesn't match
+static int cli_match(const char *command, char **argv, int argc)
+{
+	char words[256];
+	char *word, *stringp = words;
+	int count = 0;
+
+	ast_copy_string(words, command, sizeof(words));
+
+	while ((word = strsep(&stringp, " ")))
+	{
+		if (!*word)
+			continue;
+		if (count >= argc || strcasecmp(word, argv[count]))
+			return 0;
+		count++;
+	}
+
+	return count;
+}
+
+int stub_cli_command(int fd, const char *line)
+{
+	char buf[1024];
+	char *argv[STUB_MAX_ARGS];
+	char *word, *stringp = buf;
+	int argc = 0, i, best = -1, best_words = 0;
+
+	ast_copy_string(buf, line, sizeof(buf));
+
+	while ((word = strsep(&stringp, " \t")) && argc < STUB_MAX_ARGS)
+	{
+		if (*word)
+			argv[argc++] = word;
+	}
+
+	for (i = 0; i < STUB_MAX_CLI; ++i)
+	{
+		int words;
+
+		if (cli_entries[i] && (words = cli_match(cli_entries[i]->command, argv, argc)) > best_words)
+		{
+			best = i;
+			best_words = words;
+		}
+	}
+
+	if (best < 0)
+	{
+		ast_cli(fd, "No such command '%s'\n", line);
+		return RESULT_FAILURE;
+	}
+
+	struct ast_cli_args a = { .fd = fd, .argc = argc, .argv = (const char * const *)argv, .line = line, .word = "", .pos = 0, .n = 0 };
+
+	char *res = cli_entries[best]->handler(cli_entries[best], 0, &a);
+
+	if (res == CLI_SHOWUSAGE)
+		ast_cli(fd, "%s", cli_entries[best]->usage);
+
+	return (int)(intptr_t)res;
+}
+
+int stub_cli_capture(const char *line, char *buf, size_t size)
+{
+	FILE *out;
+	int res;
+	size_t len;
+
+	if (!(out = tmpfile()))
+		return -1;
+
+	res = stub_cli_command(fileno(out), line);
+
+	rewind(out);
+	len = fread(buf, 1, size - 1, out);
+	buf[len] = '\0';
+
+	fclose(out);
+
+	return res;
+}
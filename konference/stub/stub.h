@@ -0,0 +1,104 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _KONFERENCE_STUB_H
+#define _KONFERENCE_STUB_H
+
+//
+// driver side of the asterisk stub, used by the test and bench programs
+//
+
+#include "asterisk.h"
+
+//
+// logging
+//
+
+// messages below this level are discarded ( default LOG_WARNING )
+extern int stub_log_level;
+
+// count the messages of any level containing text from now on
+void stub_log_watch(const char *text);
+// messages containing the watched text since it was set
+int stub_log_matches(void);
+
+//
+// channels
+//
+
+// create a channel that reads and writes frames in format
+struct ast_channel *stub_channel_new(const char *name, format_t format);
+// free a channel once its application has returned
+void stub_channel_free(struct ast_channel *chan);
+
+// hang up a channel, ast_read() returns NULL once its frames are read
+void stub_channel_hangup(struct ast_channel *chan);
+
+// encode samples of signed linear audio in the channel's read format and queue them
+int stub_channel_queue_voice(struct ast_channel *chan, const short *samples, int count);
+// queue a dtmf digit
+int stub_channel_queue_dtmf(struct ast_channel *chan, char digit);
+
+// value of a channel variable or NULL
+const char *stub_channel_getvar(struct ast_channel *chan, const char *name);
+
+// decode a voice frame to signed linear samples, returns the sample count
+int stub_decode_frame(const struct ast_frame *f, short *samples, int count);
+
+// microseconds a translation takes, a costly codec ( default 0 )
+extern int stub_translate_delay;
+
+//
+// sound files
+//
+
+// frames read from each sound file ( default 0 ) and their 1 kHz tone level ( default 0, silence )
+extern int stub_sound_frames;
+extern int stub_sound_level;
+
+// sound files opened for a channel and read without one
+extern int stub_stream_opens;
+extern int stub_file_reads;
+
+// milliseconds a sound file takes to open, a slow disk ( default 0 )
+extern int stub_sound_open_delay;
+
+//
+// applications
+//
+
+// run a registered dialplan application on a channel (blocks like the pbx)
+int stub_app_exec(const char *app, struct ast_channel *chan, const char *data);
+
+//
+// manager event sink ( the most recent STUB_MANAGER_EVENTS are kept )
+//
+
+#define STUB_MANAGER_EVENTS 1024
+
+// number of events raised since the last reset
+int stub_manager_total(void);
+// number of kept events named event
+int stub_manager_count(const char *event);
+// non-zero if a kept event named event has a body containing text
+int stub_manager_find(const char *event, const char *text);
+// forget the events raised so far
+void stub_manager_reset(void);
+
+//
+// cli
+//
+
+// run a cli command line and capture its output, returns the command result
+int stub_cli_capture(const char *line, char *buf, size_t size);
+
+#endif
@@ -0,0 +1,1313 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// functional tests of the conference engine built against the asterisk stub
+//
+
+#include <math.h>
+#include <sys/stat.h>
+
+#include "stub.h"
+#include "../frame.h"
+
+#if	SILDET == 1
+#include "webrtc_vad.h"
+#elif	SILDET == 2
+#include "smallft.h"
+#include "fftwrap.h"
+#include "speex_preprocess.h"
+#endif
+
+//
+// a member is a stub channel running the Konference application in its own thread
+//
+
+struct probe
+{
+	// frames written to the channel and their peak amplitude
+	long frames;
+	int peak;
+
+	// sign of the tone heard, and how often it changed between frames
+	int speaker;
+	int swaps;
+
+	// delivery time of the last frame, and frames delivered less than half
+	// a tick or more than a tick and a half after the one before them
+	struct timeval delivery;
+	int duplicated;
+	int dropped;
+};
+
+struct test_member
+{
+	struct ast_channel *chan;
+	char data[256];
+	pthread_t thread;
+	int result;
+	struct probe probe;
+};
+
+static void probe_write(struct ast_channel *chan, struct ast_frame *f)
+{
+	struct probe *probe = chan->stub_data;
+	short samples[1280];
+	int count, i;
+
+	count = stub_decode_frame(f, samples, sizeof(samples) / sizeof(samples[0]));
+
+	probe->frames++;
+
+	if (!ast_tvzero(f->delivery))
+	{
+		if (!ast_tvzero(probe->delivery))
+		{
+			int64_t gap = ast_tvdiff_us(f->delivery, probe->delivery);
+
+			if (gap < AST_CONF_FRAME_INTERVAL * 500)
+				probe->duplicated++;
+			else if (gap > AST_CONF_FRAME_INTERVAL * 1500)
+				probe->dropped++;
+		}
+
+		probe->delivery = f->delivery;
+	}
+
+	if (count > 1 && samples[1])
+	{
+		int speaker = samples[1] > 0 ? 1 : -1;
+
+		if (probe->speaker && probe->speaker != speaker)
+			probe->swaps++;
+		probe->speaker = speaker;
+	}
+
+	for (i = 0; i < count; ++i)
+	{
+		int sample = abs(samples[i]);
+		if (sample > probe->peak)
+			probe->peak = sample;
+	}
+}
+
+static void *member_thread(void *data)
+{
+	struct test_member *m = data;
+
+	m->result = stub_app_exec("Konference", m->chan, m->data);
+
+	return NULL;
+}
+
+static int member_join(struct test_member *m, const char *name, format_t format, const char *data)
+{
+	memset(m, 0, sizeof(*m));
+
+	if (!(m->chan = stub_channel_new(name, format)))
+		return -1;
+
+	m->chan->stub_data = &m->probe;
+	m->chan->stub_write_hook = probe_write;
+
+	ast_copy_string(m->data, data, sizeof(m->data));
+
+	return pthread_create(&m->thread, NULL, member_thread, m);
+}
+
+static void member_leave(struct test_member *m)
+{
+	stub_channel_hangup(m->chan);
+	pthread_join(m->thread, NULL);
+	stub_channel_free(m->chan);
+}
+
+static void probe_reset(struct test_member *m)
+{
+	ast_channel_lock(m->chan);
+	m->probe.frames = 0;
+	m->probe.peak = 0;
+	m->probe.speaker = 0;
+	m->probe.swaps = 0;
+	m->probe.delivery = ast_tv(0, 0);
+	m->probe.duplicated = 0;
+	m->probe.dropped = 0;
+	ast_channel_unlock(m->chan);
+}
+
+// feed a 400 Hz tone to the talkers for ms milliseconds, one frame per 20 milliseconds
+static void talk(struct test_member **talkers, int count, int ms)
+{
+	short tone[160];
+	int i, t;
+
+	for (i = 0; i < 160; ++i)
+		tone[i] = 8000 * sin(2 * M_PI * 400 * i / 8000);
+
+	for (t = 0; t < ms; t += 20)
+	{
+		for (i = 0; i < count; ++i)
+			stub_channel_queue_voice(talkers[i]->chan, tone, 160);
+		usleep(20000);
+	}
+}
+
+// feed each talker a 400 Hz tone at its own level for ms milliseconds, cycling
+// through phases rows of count levels, one row per frame, and paced against
+// the clock so that no talker misses a mixer tick
+static void talk_levels(struct test_member **talkers, const int *levels, int count, int phases, int ms)
+{
+	struct timeval next = ast_tvnow();
+	short tone[160];
+	int i, j, t;
+
+	for (t = 0; t < ms; t += 20)
+	{
+		for (i = 0; i < count; ++i)
+		{
+			for (j = 0; j < 160; ++j)
+				tone[j] = levels[t / 20 % phases * count + i] * sin(2 * M_PI * 400 * j / 8000);
+			stub_channel_queue_voice(talkers[i]->chan, tone, 160);
+		}
+
+		next = ast_tvadd(next, ast_tv(0, 20000));
+		if ((j = ast_tvdiff_us(next, ast_tvnow())) > 0)
+			usleep(j);
+	}
+}
+
+//
+// tests
+//
+
+static const char *failure;
+
+#define CHECK(cond) do { if (!(cond)) { failure = #cond; return -1; } } while (0)
+
+static int test_mix_minus(void)
+{
+	struct test_member a, b, c;
+	struct test_member *talkers[] = { &a };
+
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_SLINEAR, "mix"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ULAW, "mix"));
+	CHECK(!member_join(&c, "Stub/c", AST_FORMAT_ALAW, "mix"));
+
+	// let the members join, then measure
+	talk(talkers, 1, 200);
+	probe_reset(&a);
+	probe_reset(&b);
+	probe_reset(&c);
+	talk(talkers, 1, 1000);
+
+	member_leave(&c);
+	member_leave(&b);
+	member_leave(&a);
+
+	// the listeners hear the speaker, the speaker doesn't hear itself
+	CHECK(b.probe.frames >= 40 && b.probe.peak > 6000);
+	CHECK(c.probe.frames >= 40 && c.probe.peak > 6000);
+	CHECK(a.probe.frames >= 40 && a.probe.peak == 0);
+
+	return 0;
+}
+
+static int test_max_speakers(void)
+{
+	struct test_member a, b, c, d;
+	struct test_member *talkers[] = { &a, &b, &c };
+	static const int levels[] = { 8000, 2000, 3000 };
+
+	// two near equal talkers, the louder one changing every frame,
+	// told apart by the sign of their tones
+	static const int close_levels[] = { 4400, -4000, 4000, -4400 };
+	int loudest, swaps;
+
+	// only the loudest of three speakers is mixed
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_SLINEAR, "speakers,,max_speakers=1"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_SLINEAR, "speakers,,max_speakers=1"));
+	CHECK(!member_join(&c, "Stub/c", AST_FORMAT_SLINEAR, "speakers,,max_speakers=1"));
+	CHECK(!member_join(&d, "Stub/d", AST_FORMAT_SLINEAR, "speakers,,max_speakers=1"));
+
+	talk_levels(talkers, levels, 3, 1, 200);
+	probe_reset(&d);
+	talk_levels(talkers, levels, 3, 1, 600);
+	loudest = d.probe.peak > 7500 && d.probe.peak < 8500;
+
+	// the mixed speaker keeps the floor rather than swapping every tick
+	talk_levels(talkers, close_levels, 2, 2, 200);
+	probe_reset(&d);
+	talk_levels(talkers, close_levels, 2, 2, 600);
+	swaps = d.probe.swaps;
+
+	member_leave(&d);
+	member_leave(&c);
+	member_leave(&b);
+	member_leave(&a);
+
+	CHECK(loudest);
+	CHECK(swaps <= 2);
+
+	return 0;
+}
+
+static int test_two_speakers(void)
+{
+	struct test_member a, b;
+	struct test_member *talkers[] = { &a, &b };
+
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "two"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_SLINEAR, "two"));
+
+	talk(talkers, 2, 200);
+	probe_reset(&a);
+	probe_reset(&b);
+	talk(talkers, 2, 600);
+
+	member_leave(&b);
+	member_leave(&a);
+
+	// each speaker hears the other one
+	CHECK(a.probe.peak > 6000);
+	CHECK(b.probe.peak > 6000);
+
+	return 0;
+}
+
+static int test_manager_events(void)
+{
+	struct test_member a, b;
+
+	stub_manager_reset();
+
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "ami,R"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ULAW, "ami"));
+	usleep(100000);
+
+	CHECK(stub_manager_count("ConferenceJoin") == 2);
+	CHECK(stub_manager_find("ConferenceJoin", "Channel: Stub/b"));
+
+	// the dtmf of a member with the R flag is relayed
+	stub_channel_queue_dtmf(a.chan, '5');
+	usleep(100000);
+	CHECK(stub_manager_find("ConferenceDTMF", "Key: 5"));
+
+	member_leave(&b);
+	member_leave(&a);
+
+	CHECK(stub_manager_count("ConferenceLeave") == 2);
+	CHECK(stub_manager_find("ConferenceLeave", "Count: 0"));
+
+	return 0;
+}
+
+static int test_max_users(void)
+{
+	struct test_member a, b;
+
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "full"));
+	usleep(100000);
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ULAW, "full,,max_users=1"));
+
+	// the member is turned away from a full conference without hanging up
+	pthread_join(b.thread, NULL);
+	CHECK(b.result == 0);
+	CHECK(stub_channel_getvar(b.chan, "KONFERENCE") && !strcmp(stub_channel_getvar(b.chan, "KONFERENCE"), "MAXUSERS"));
+	stub_channel_free(b.chan);
+
+	member_leave(&a);
+
+	return 0;
+}
+
+static int test_cli(void)
+{
+	struct test_member a, b;
+	char out[4096];
+
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "cli"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ALAW, "cli"));
+	usleep(100000);
+
+	CHECK(stub_cli_capture("konference list", out, sizeof(out)) == RESULT_SUCCESS);
+	CHECK(strstr(out, "cli"));
+	CHECK(stub_cli_capture("konference list cli", out, sizeof(out)) == RESULT_SUCCESS);
+	CHECK(strstr(out, "Stub/a") && strstr(out, "Stub/b"));
+	CHECK(stub_cli_capture("konference stats", out, sizeof(out)) == RESULT_SUCCESS);
+	CHECK(strstr(out, "cli"));
+
+	// a kicked member leaves and the dialplan can tell why
+	CHECK(stub_cli_capture("konference kickchannel Stub/b", out, sizeof(out)) == RESULT_SUCCESS);
+	pthread_join(b.thread, NULL);
+	CHECK(stub_channel_getvar(b.chan, "KONFERENCE") && !strcmp(stub_channel_getvar(b.chan, "KONFERENCE"), "KICKED"));
+	stub_channel_free(b.chan);
+
+	member_leave(&a);
+
+	return 0;
+}
+
+static int test_listen_volume(void)
+{
+	struct test_member a, b, c, d;
+	struct test_member *talkers[] = { &a };
+	char out[4096], name[64];
+	char *line;
+	int members, cost, shared;
+	unsigned int in_overruns, in_underruns, out_overruns, encode_hits = 0, encode_misses = 0;
+
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "volume"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ULAW, "volume"));
+	CHECK(!member_join(&c, "Stub/c", AST_FORMAT_ULAW, "volume"));
+	CHECK(!member_join(&d, "Stub/d", AST_FORMAT_ULAW, "volume"));
+	usleep(100000);
+
+	// two listeners at the same louder volume share one conversion per tick
+	// ( the first step up is a gain of one, the second doubles )
+	CHECK(stub_cli_capture("konference listenvolume Stub/b up", out, sizeof(out)) == RESULT_SUCCESS);
+	CHECK(stub_cli_capture("konference listenvolume Stub/b up", out, sizeof(out)) == RESULT_SUCCESS);
+	CHECK(stub_cli_capture("konference listenvolume Stub/c up", out, sizeof(out)) == RESULT_SUCCESS);
+	CHECK(stub_cli_capture("konference listenvolume Stub/c up", out, sizeof(out)) == RESULT_SUCCESS);
+
+	talk(talkers, 1, 400);
+
+	CHECK(stub_cli_capture("konference stats", out, sizeof(out)) == RESULT_SUCCESS);
+
+	for (line = strtok(out, "\n"); line; line = strtok(NULL, "\n"))
+	{
+		if (sscanf(line, "%63s %d %u %u %u %d %u %u", name, &members, &in_overruns, &in_underruns, &out_overruns, &cost, &encode_hits, &encode_misses) == 8 && !strcmp(name, "volume"))
+			break;
+	}
+
+	shared = b.probe.peak == c.probe.peak && b.probe.peak > d.probe.peak * 3 / 2;
+
+	// d's tick entry fills the hole b leaves, with d's own volume
+	member_leave(&b);
+	probe_reset(&c);
+	probe_reset(&d);
+	talk(talkers, 1, 400);
+
+	member_leave(&d);
+	member_leave(&c);
+	member_leave(&a);
+
+	CHECK(shared);
+	CHECK(c.probe.peak > d.probe.peak * 3 / 2);
+
+	// per tick one conversion for b and c, the speaker's own frame for d
+	CHECK(encode_misses >= 10 && encode_hits >= 2 * encode_misses);
+
+	return 0;
+}
+
+static int test_encode_formats(void)
+{
+	struct test_member a, b, c, d;
+	struct test_member *talkers[] = { &a };
+	char out[4096], format[64];
+	char *line;
+	int members, cost, ulaw = 0, alaw = 0, slinear = 0, gsm = 0;
+
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "encode"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ULAW, "encode"));
+	CHECK(!member_join(&c, "Stub/c", AST_FORMAT_ALAW, "encode"));
+	CHECK(!member_join(&d, "Stub/d", AST_FORMAT_SLINEAR, "encode"));
+	usleep(100000);
+
+	talk(talkers, 1, 400);
+
+	// the write formats present are listed with their members and encode cost
+	CHECK(stub_cli_capture("konference stats encode", out, sizeof(out)) == RESULT_SUCCESS);
+
+	for (line = strtok(out, "\n"); line; line = strtok(NULL, "\n"))
+	{
+		if (sscanf(line, "%63s %d %d", format, &members, &cost) != 3)
+			continue;
+		if (!strcmp(format, "ulaw"))
+			ulaw = members;
+		else if (!strcmp(format, "alaw"))
+			alaw = members;
+		else if (!strcmp(format, "slinear"))
+			slinear = members;
+		else if (!strcmp(format, "gsm"))
+			gsm = members;
+	}
+
+	member_leave(&d);
+	member_leave(&c);
+	member_leave(&b);
+	member_leave(&a);
+
+	CHECK(ulaw == 2 && alaw == 1 && slinear == 1 && !gsm);
+
+	// every listener hears the speaker in its own format
+	CHECK(b.probe.peak > 4000 && c.probe.peak > 4000 && d.probe.peak > 4000);
+
+	return 0;
+}
+
+// read the pool statistics of the translator paths from ulaw to the conference format
+static int path_stats(int *idle, unsigned int *built, unsigned int *reused)
+{
+	char out[8192], source[64], dest[64];
+	char *line;
+
+	if (stub_cli_capture("konference stats", out, sizeof(out)) != RESULT_SUCCESS)
+		return -1;
+
+	for (line = strtok(out, "\n"); line; line = strtok(NULL, "\n"))
+	{
+		if (sscanf(line, "%63s %63s %d %u %u", source, dest, idle, built, reused) == 5
+			&& !strcmp(source, "ulaw") && !strcmp(dest, ast_getformatname(AST_FORMAT_CONFERENCE)))
+			return 0;
+	}
+
+	return -1;
+}
+
+static int test_trans_paths(void)
+{
+	struct test_member m[4];
+	int idle, idle_after, i;
+	unsigned int built, built_after, reused, reused_after;
+
+	// the pool is warmed when the module is loaded
+	CHECK(!path_stats(&idle, &built, &reused));
+	CHECK(built >= 4 && idle >= 4);
+
+	for (i = 0; i < 4; ++i)
+		CHECK(!member_join(&m[i], "Stub/a", AST_FORMAT_ULAW, "paths"));
+	usleep(100000);
+
+	for (i = 0; i < 4; ++i)
+		member_leave(&m[i]);
+
+	// the members took their paths from the pool and returned them
+	CHECK(!path_stats(&idle_after, &built_after, &reused_after));
+	CHECK(built_after == built && idle_after == idle && reused_after >= reused + 4);
+
+	return 0;
+}
+
+static int test_join_sounds(void)
+{
+	struct test_member m[5];
+	struct test_member *talkers[] = { &m[0] };
+	int opens, reads, talker, i, res = 0;
+
+	// reload the module with sounds of a tone, decoded once when it is loaded
+	stub_sound_frames = 10;
+	stub_sound_level = 8000;
+	usleep(100000);
+	stub_unload_module();
+	CHECK(!stub_load_module());
+
+	opens = stub_stream_opens;
+	reads = stub_file_reads;
+
+	CHECK(!member_join(&m[0], "Stub/a", AST_FORMAT_ULAW, "sounds"));
+	usleep(100000);
+
+	// every member hears the join sound in the conference audio
+	for (i = 1; i < 4; ++i)
+	{
+		CHECK(!member_join(&m[i], "Stub/b", i == 1 ? AST_FORMAT_ALAW : AST_FORMAT_SLINEAR, "sounds"));
+	}
+	usleep(300000);
+
+	for (i = 0; i < 4; ++i)
+	{
+		if (m[i].probe.peak < 4000)
+			res = -1;
+	}
+
+	// a lone talker hears the join sound too, without its own voice
+	talk(talkers, 1, 200);
+	probe_reset(&m[0]);
+	CHECK(!member_join(&m[4], "Stub/c", AST_FORMAT_ULAW, "sounds"));
+	talk(talkers, 1, 400);
+	talker = m[0].probe.peak;
+
+	for (i = 4; i >= 0; --i)
+		member_leave(&m[i]);
+
+	// let the mixer remove the empty conference before the module is unloaded
+	usleep(100000);
+
+	// no sound file was opened for a member or read again
+	opens = stub_stream_opens - opens;
+	reads = stub_file_reads - reads;
+
+	stub_sound_frames = 0;
+	stub_sound_level = 0;
+	stub_unload_module();
+	CHECK(!stub_load_module());
+
+	CHECK(!res);
+	CHECK(talker >= 4000);
+	CHECK(!opens && !reads);
+
+	return 0;
+}
+
+static int test_announcements(void)
+{
+	struct test_member a, b, c;
+	struct test_member *talkers[] = { &a };
+	char out[4096];
+	int reads, ducked, talker, muted, stopped;
+
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "announce"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ULAW, "announce"));
+	CHECK(!member_join(&c, "Stub/c", AST_FORMAT_SLINEAR, "announce"));
+	talk(talkers, 1, 200);
+
+	// an unknown conference decodes nothing, an empty file plays nothing
+	reads = stub_file_reads;
+	CHECK(stub_cli_capture("konference play sound nowhere quiet duck", out, sizeof(out)) == RESULT_SUCCESS);
+	CHECK(stub_file_reads == reads);
+	CHECK(stub_cli_capture("konference play sound announce quiet duck", out, sizeof(out)) == RESULT_SUCCESS);
+
+	// recorded as a quiet two second announcement, it is decoded again for the conference
+	stub_sound_frames = 100;
+	stub_sound_level = 500;
+	reads = stub_file_reads;
+
+	CHECK(stub_cli_capture("konference play sound announce quiet duck", out, sizeof(out)) == RESULT_SUCCESS);
+	talk(talkers, 1, 200);
+	probe_reset(&a);
+	probe_reset(&b);
+	probe_reset(&c);
+	talk(talkers, 1, 1000);
+	ducked = b.probe.peak > 1000 && b.probe.peak < 3000 && c.probe.peak > 1000 && c.probe.peak < 3000;
+
+	// the talker hears the announcement, not itself
+	talker = a.probe.peak > 250 && a.probe.peak < 1000;
+
+	// recorded silent and played again, it mutes the conference audio
+	stub_sound_level = 0;
+	talk(talkers, 1, 1000);
+	CHECK(stub_cli_capture("konference play sound announce quiet mute", out, sizeof(out)) == RESULT_SUCCESS);
+	talk(talkers, 1, 200);
+	probe_reset(&b);
+	probe_reset(&c);
+	talk(talkers, 1, 1000);
+	muted = b.probe.peak < 500 && c.probe.peak < 500;
+
+	// stopped, the conference audio is back
+	CHECK(stub_cli_capture("konference stop sounds announce", out, sizeof(out)) == RESULT_SUCCESS);
+	talk(talkers, 1, 200);
+	probe_reset(&b);
+	probe_reset(&c);
+	talk(talkers, 1, 400);
+	stopped = b.probe.peak > 6000 && c.probe.peak > 6000;
+
+	reads = stub_file_reads - reads;
+	stub_sound_frames = 0;
+
+	member_leave(&c);
+	member_leave(&b);
+	member_leave(&a);
+
+	CHECK(ducked);
+	CHECK(talker);
+	CHECK(muted);
+	CHECK(stopped);
+	CHECK(reads == 2);
+
+	return 0;
+}
+
+#if	AST_CONF_SOUND_READERS
+static int test_sound_prefetch(void)
+{
+	struct test_member a, b;
+	char out[4096];
+	long frames;
+	int opens, reads, stalled, heard;
+
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "prefetch"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ULAW, "prefetch"));
+	usleep(200000);
+
+	// a one second sound on a disk that takes 300 milliseconds to open it
+	stub_sound_frames = 50;
+	stub_sound_level = 8000;
+	stub_sound_open_delay = 300;
+	opens = stub_stream_opens;
+	reads = stub_file_reads;
+
+	probe_reset(&a);
+	CHECK(stub_cli_capture("konference play sound Stub/a beep", out, sizeof(out)) == RESULT_SUCCESS);
+
+	// the member's output goes on while the file opens
+	usleep(200000);
+	ast_channel_lock(a.chan);
+	frames = a.probe.frames;
+	ast_channel_unlock(a.chan);
+	stalled = frames < 5;
+
+	usleep(1300000);
+	heard = a.probe.peak > 4000;
+
+	opens = stub_stream_opens - opens;
+	reads = stub_file_reads - reads;
+
+	CHECK(stub_cli_capture("konference stats", out, sizeof(out)) == RESULT_SUCCESS);
+	CHECK(strstr(out, "Sound Readers"));
+	CHECK(stub_cli_capture("konference stats prefetch", out, sizeof(out)) == RESULT_SUCCESS);
+	CHECK(strstr(out, "Sound Underruns"));
+
+	stub_sound_frames = 0;
+	stub_sound_level = 0;
+	stub_sound_open_delay = 0;
+
+	member_leave(&b);
+	member_leave(&a);
+
+	CHECK(!stalled);
+	CHECK(heard);
+	CHECK(!opens && reads == 1);
+
+	return 0;
+}
+#endif
+
+#if	AST_CONF_SHARED_MOH
+static int test_shared_moh(void)
+{
+	static const char *files[] = { "one.sln", "two.sln" };
+	const char *data_dir = ast_config_AST_DATA_DIR;
+	char dir[] = "/tmp/konference_mohXXXXXX", path[256];
+	struct test_member a, b, c;
+	int reads, alone, joined, left, shared, i;
+	FILE *f;
+
+	// a default class of two files in a data directory of its own
+	CHECK(mkdtemp(dir));
+	snprintf(path, sizeof(path), "%s/moh", dir);
+	CHECK(!mkdir(path, 0700));
+
+	for (i = 0; i < 2; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/moh/%s", dir, files[i]);
+		CHECK((f = fopen(path, "w")));
+		fclose(f);
+	}
+
+	// reload the module, so the class isn't cached
+	ast_config_AST_DATA_DIR = dir;
+	usleep(100000);
+	stub_unload_module();
+	CHECK(!stub_load_module());
+
+	stub_sound_frames = 50;
+	stub_sound_level = 8000;
+	reads = stub_file_reads;
+
+	// alone, the member hears the shared ring without a generator on its channel
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "moh"));
+	usleep(300000);
+	alone = a.probe.peak > 4000 && !ast_test_flag(a.chan, AST_FLAG_MOH);
+
+	// the music stops while another member is in the conference
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ULAW, "moh"));
+	usleep(200000);
+	probe_reset(&a);
+	usleep(300000);
+	joined = a.probe.frames > 0 && a.probe.peak == 0;
+
+	member_leave(&b);
+	usleep(100000);
+	probe_reset(&a);
+	usleep(300000);
+	left = a.probe.peak > 4000;
+
+	// another lone member at another format shares the decoded class
+	CHECK(!member_join(&c, "Stub/c", AST_FORMAT_ALAW, "moh2"));
+	usleep(300000);
+	shared = c.probe.peak > 4000 && !ast_test_flag(c.chan, AST_FLAG_MOH);
+
+	reads = stub_file_reads - reads;
+
+	member_leave(&c);
+	member_leave(&a);
+	usleep(100000);
+
+	stub_sound_frames = 0;
+	stub_sound_level = 0;
+	ast_config_AST_DATA_DIR = data_dir;
+	stub_unload_module();
+	CHECK(!stub_load_module());
+
+	for (i = 0; i < 2; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/moh/%s", dir, files[i]);
+		unlink(path);
+	}
+	snprintf(path, sizeof(path), "%s/moh", dir);
+	rmdir(path);
+	rmdir(dir);
+
+	CHECK(alone);
+	CHECK(joined);
+	CHECK(left);
+	CHECK(shared);
+	CHECK(reads == 2);
+
+	return 0;
+}
+#endif
+
+#if	AST_CONF_DEDICATED_MIXER_COST
+static int test_dedicated_mixer(void)
+{
+	struct test_member a, b, fillers[AST_CONF_MIXER_THREADS];
+	struct test_member *talkers[] = { &a };
+	char name[32];
+	int moved, moved_back, round, i;
+
+	// a speaker and a listener whose codec is costly to encode, in a conference
+	// sharing its mixer with another one whatever the number of mixers
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "dedicated"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_GSM, "dedicated"));
+
+	for (i = 0; i < AST_CONF_MIXER_THREADS; ++i)
+	{
+		snprintf(name, sizeof(name), "filler%d", i);
+		CHECK(!member_join(&fillers[i], "Stub/f", AST_FORMAT_ULAW, name));
+	}
+
+	talk(talkers, 1, 200);
+	probe_reset(&b);
+
+	// a few round trips, the mixers' ticks are out of phase differently each time
+	for (round = moved = moved_back = 0; round < 3; ++round)
+	{
+		// the encode cost moves the conference to a dedicated mixer
+		stub_log_watch("moved to a dedicated mixer");
+		stub_translate_delay = 3 * AST_CONF_DEDICATED_MIXER_COST;
+		for (i = 0; i < 150 && !stub_log_matches(); ++i)
+			talk(talkers, 1, 20);
+		moved += stub_log_matches();
+
+		// and back to a shared mixer once it is cheap again
+		stub_log_watch("moved to a shared mixer");
+		stub_translate_delay = 0;
+		for (i = 0; i < 150 && !stub_log_matches(); ++i)
+			talk(talkers, 1, 20);
+		moved_back += stub_log_matches();
+	}
+
+	talk(talkers, 1, 200);
+	stub_log_watch("");
+
+	for (i = 0; i < AST_CONF_MIXER_THREADS; ++i)
+		member_leave(&fillers[i]);
+	member_leave(&b);
+	member_leave(&a);
+
+	// the listener got one frame a tick across both moves
+	CHECK(moved == 3);
+	CHECK(moved_back == 3);
+	CHECK(b.probe.frames > 0);
+	CHECK(!b.probe.duplicated);
+	CHECK(!b.probe.dropped);
+
+	return 0;
+}
+#endif
+
+#if	AST_CONF_JITTER_BUFFER
+// the largest jitter buffer depth and the frames dropped by the members of a conference
+static int jitter_stats(const char *conference, int *max_depth, int *total_dropped)
+{
+	char command[80], out[4096], *line;
+	int id, jitter, depth, target, dropped;
+	unsigned int late;
+
+	*max_depth = *total_dropped = 0;
+
+	snprintf(command, sizeof(command), "konference stats %s", conference);
+	if (stub_cli_capture(command, out, sizeof(out)) != RESULT_SUCCESS || !(line = strstr(out, "Buffer Target")))
+		return -1;
+
+	for (line = strchr(line, '\n'); line && sscanf(line, "%d %d %d %d %u %d", &id, &jitter, &depth, &target, &late, &dropped) == 6; line = strchr(line + 1, '\n'))
+	{
+		*max_depth = depth > *max_depth ? depth : *max_depth;
+		*total_dropped += dropped;
+	}
+
+	return 0;
+}
+
+static int test_jitter_buffer(void)
+{
+	struct test_member a, b;
+	struct test_member *talkers[] = { &a };
+	short tone[160];
+	int max_depth, total_dropped, i;
+
+	for (i = 0; i < 160; ++i)
+		tone[i] = 8000 * sin(2 * M_PI * 400 * i / 8000);
+
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "jitter"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ULAW, "jitter"));
+	talk(talkers, 1, 200);
+
+	// a second of speech held up in the network arrives at once
+	for (i = 0; i < 50; ++i)
+		stub_channel_queue_voice(a.chan, tone, 160);
+
+	probe_reset(&b);
+	talk(talkers, 1, 1500);
+
+	CHECK(!jitter_stats("jitter", &max_depth, &total_dropped));
+
+	member_leave(&b);
+	member_leave(&a);
+
+	// the backlog is dropped down to the target, the listener hears the speaker throughout
+	CHECK(total_dropped >= 30);
+	CHECK(max_depth <= AST_CONF_JB_MAX_DEPTH + AST_CONF_JB_SLACK);
+	CHECK(b.probe.frames >= 60 && b.probe.peak > 6000);
+
+	return 0;
+}
+
+static int test_jitter_buffer_codec(void)
+{
+	struct test_member a, b;
+	struct test_member *talkers[] = { &a };
+	short tone[160];
+	int max_depth, total_dropped, backlog, i;
+
+	for (i = 0; i < 160; ++i)
+		tone[i] = 8000 * sin(2 * M_PI * 400 * i / 8000);
+
+	// a gsm speaker, whose frames have no energy estimate
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_GSM, "jittergsm"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ULAW, "jittergsm"));
+	talk(talkers, 1, 200);
+
+	for (i = 0; i < 50; ++i)
+		stub_channel_queue_voice(a.chan, tone, 160);
+
+	// the burst is taken for speech and dropped a frame a tick, not at once
+	usleep(100000);
+	CHECK(!jitter_stats("jittergsm", &backlog, &total_dropped));
+
+	talk(talkers, 1, 1500);
+	CHECK(!jitter_stats("jittergsm", &max_depth, &total_dropped));
+
+	member_leave(&b);
+	member_leave(&a);
+
+	CHECK(backlog > AST_CONF_JB_MAX_DEPTH + AST_CONF_JB_SLACK);
+	CHECK(total_dropped >= 30);
+	CHECK(max_depth <= AST_CONF_JB_MAX_DEPTH + AST_CONF_JB_SLACK);
+
+	return 0;
+}
+#endif
+
+#ifndef	AC_USE_G722
+static int test_g711(void)
+{
+	static const format_t formats[] = { AST_FORMAT_ULAW, AST_FORMAT_ALAW };
+	static const int indexes[] = { AC_ULAW_INDEX, AC_ALAW_INDEX };
+	short samples[160];
+	unsigned char codes[160];
+	struct ast_frame f;
+	int i, n, base;
+
+	memset(&f, 0, sizeof(f));
+	f.frametype = AST_FRAME_VOICE;
+
+	// the built in codecs against the translators, over every sample and code
+	for (i = 0; i < 2; ++i)
+	{
+		struct ast_trans_pvt *encoder = ast_translator_build_path(formats[i], AST_FORMAT_SLINEAR);
+		struct ast_trans_pvt *decoder = ast_translator_build_path(AST_FORMAT_SLINEAR, formats[i]);
+		ast_conf_sharedframe *sf;
+		struct ast_frame *ref;
+
+		CHECK(encoder && decoder);
+
+		for (base = -32768; base < 32768; base += 160)
+		{
+			for (n = 0; n < 160; ++n)
+				samples[n] = base + n < 32768 ? base + n : 32767;
+
+			f.subclass.codec = AST_FORMAT_SLINEAR;
+			f.samples = 160;
+			f.datalen = sizeof(samples);
+			f.data.ptr = samples;
+
+			CHECK((sf = encode_g711_frame(&f, indexes[i], f.delivery)));
+			CHECK((ref = ast_translate(encoder, &f, 0)));
+			CHECK(sf->fr.subclass.codec == formats[i] && sf->fr.samples == 160 && sf->fr.datalen == 160);
+			CHECK(!memcmp(sf->data, ref->data.ptr, 160));
+			release_shared_frame(&sf->fr);
+		}
+
+		for (base = 0; base < 256; base += 160)
+		{
+			for (n = 0; n < 160; ++n)
+				codes[n] = (base + n) & 0xff;
+
+			f.subclass.codec = formats[i];
+			f.samples = 160;
+			f.datalen = sizeof(codes);
+			f.data.ptr = codes;
+
+			CHECK((sf = decode_g711_frame(&f, indexes[i])));
+			CHECK((ref = ast_translate(decoder, &f, 0)));
+			CHECK(sf->fr.subclass.codec == AST_FORMAT_SLINEAR && sf->fr.samples == 160 && sf->fr.datalen == 320);
+			CHECK(!memcmp(sf->data, ref->data.ptr, 320));
+			release_shared_frame(&sf->fr);
+		}
+
+		ast_translator_free_path(encoder);
+		ast_translator_free_path(decoder);
+	}
+
+	return 0;
+}
+#endif
+
+static int test_vad_members(void)
+{
+	struct test_member a, b;
+	struct test_member *talkers[] = { &a };
+
+	stub_manager_reset();
+
+	// telephone members, the vad lets the speaker's frames through
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "vad,T"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ALAW, "vad,T"));
+
+	talk(talkers, 1, 400);
+	probe_reset(&a);
+	probe_reset(&b);
+	talk(talkers, 1, 600);
+
+	member_leave(&b);
+	member_leave(&a);
+
+	CHECK(b.probe.frames >= 20 && b.probe.peak > 6000);
+	CHECK(a.probe.peak == 0);
+#if	(SILDET == 1 || SILDET == 2) && !(defined(SPEAKER_SCOREBOARD) && defined(CACHE_CONTROL_BLOCKS))
+	// the member thread reports the speaker
+	CHECK(stub_manager_find("ConferenceState", "State: speaking"));
+#endif
+
+	return 0;
+}
+
+#if	(SILDET == 1 || SILDET == 2) && AST_CONF_VAD_GATE
+static int test_vad_gate(void)
+{
+	struct test_member a, b;
+	short hiss[160];
+	char out[4096], name[64];
+	char *line;
+	int members, cost, i, t;
+	unsigned int in_overruns, in_underruns, out_overruns, encode_hits, encode_misses, vad_frames = 0, vad_gated = 0;
+
+	for (i = 0; i < 160; ++i)
+		hiss[i] = rand() % 64 - 32;
+
+	// ( a speex vad takes the steady tone for noise, so only the hissing line has the vad flag )
+	CHECK(!member_join(&a, "Stub/a", AST_FORMAT_ULAW, "gate,T"));
+	CHECK(!member_join(&b, "Stub/b", AST_FORMAT_ULAW, "gate,a"));
+	usleep(100000);
+
+	// the speaker talks while the other line hisses
+	for (t = 0; t < 50; ++t)
+	{
+		struct test_member *talkers[] = { &a };
+
+		stub_channel_queue_voice(b.chan, hiss, 160);
+		talk(talkers, 1, 20);
+	}
+
+	CHECK(stub_cli_capture("konference stats", out, sizeof(out)) == RESULT_SUCCESS);
+
+	for (line = strtok(out, "\n"); line; line = strtok(NULL, "\n"))
+	{
+		if (sscanf(line, "%63s %d %u %u %u %d %u %u %u %u", name, &members, &in_overruns, &in_underruns, &out_overruns, &cost, &encode_hits, &encode_misses, &vad_frames, &vad_gated) == 10 && !strcmp(name, "gate"))
+			break;
+	}
+
+	member_leave(&b);
+	member_leave(&a);
+
+	// the hiss is gated once the vad's hangover is over, the speech never is
+	CHECK(vad_frames >= 40);
+	CHECK(vad_gated >= 10 && vad_gated <= 50);
+	CHECK(b.probe.peak > 6000);
+
+	return 0;
+}
+#endif
+
+#if	SILDET == 1
+#define VAD_TEST_INSTANCES 21
+
+static int test_vad_batch(void)
+{
+	VadInst *single[VAD_TEST_INSTANCES], *batch[VAD_TEST_INSTANCES];
+	int16_t samples[VAD_TEST_INSTANCES][320];
+	int16_t *frames[VAD_TEST_INSTANCES];
+	int vads[VAD_TEST_INSTANCES];
+	int i, n, t, rate, length, result = 0;
+
+	for (i = 0; i < VAD_TEST_INSTANCES; ++i)
+	{
+		CHECK(!WebRtcVad_Create(&single[i]) && !WebRtcVad_Init(single[i]) && !WebRtcVad_set_mode(single[i], i % 4));
+		CHECK(!WebRtcVad_Create(&batch[i]) && !WebRtcVad_Init(batch[i]) && !WebRtcVad_set_mode(batch[i], i % 4));
+		frames[i] = samples[i];
+	}
+
+	// silence, noise, tones and clipped signals, with the instances changing between them
+	// ( narrowband first, then wideband through the same instances )
+	srand(1);
+	for (t = 0; t < 2000 && !result; ++t)
+	{
+		rate = t < 1000 ? 8000 : 16000;
+		length = rate / 50;
+
+		for (i = 0; i < VAD_TEST_INSTANCES; ++i)
+		{
+			for (n = 0; n < length; ++n)
+			{
+				switch ((i + t / 50) % 5)
+				{
+					case 0:
+						samples[i][n] = 0;
+						break;
+					case 1:
+						samples[i][n] = rand() % 200 - 100;
+						break;
+					case 2:
+						samples[i][n] = 12000 * sin((t * length + n) * (0.1 + i * 0.003)) + rand() % 500;
+						break;
+					case 3:
+						samples[i][n] = rand() & 1 ? 32767 : -32768;
+						break;
+					default:
+						samples[i][n] = rand() % 65536 - 32768;
+						break;
+				}
+			}
+		}
+
+		// the batch makes the same decisions as one instance at a time
+		if (WebRtcVad_ProcessBatch(batch, VAD_TEST_INSTANCES, rate, frames, length, vads))
+			result = -1;
+
+		for (i = 0; i < VAD_TEST_INSTANCES; ++i)
+		{
+			if (vads[i] != WebRtcVad_Process(single[i], rate, samples[i], length))
+				result = -1;
+		}
+	}
+
+	for (i = 0; i < VAD_TEST_INSTANCES; ++i)
+	{
+		WebRtcVad_Free(single[i]);
+		WebRtcVad_Free(batch[i]);
+	}
+
+	CHECK(!result);
+
+	return 0;
+}
+#endif
+
+#if	SILDET == 2
+static int test_speex_fft(void)
+{
+	static const int sizes[] = { 320, 640, 240, 100 };
+	float in[640], out[640], ref[640];
+	int s, i;
+
+	// the preprocessor fft against smallft, forward and back, including sizes it hands to smallft
+	srand(1);
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+	{
+		int n = sizes[s];
+		struct drft_lookup drft;
+		void *table = spx_fft_init(n);
+		float peak = 0, error = 0;
+
+		drft_init(&drft, n);
+
+		for (i = 0; i < n; ++i)
+			in[i] = out[i] = ref[i] = rand() % 65536 - 32768;
+
+		spx_fft(table, out);
+		drft_forward(&drft, ref);
+
+		for (i = 0; i < n; ++i)
+		{
+			peak = fmaxf(peak, fabsf(ref[i]));
+			error = fmaxf(error, fabsf(out[i] - ref[i]));
+		}
+		CHECK(error < peak * 1e-6);
+
+		spx_ifft(table, out);
+
+		for (i = 0; i < n; ++i)
+			CHECK(fabsf(out[i] / n - in[i]) < 0.1);
+
+		drft_clear(&drft);
+		spx_fft_destroy(table);
+	}
+
+	return 0;
+}
+
+static int test_speex_fixed(void)
+{
+	static const int rates[] = { 8000, 16000 };
+	int r, i, frame;
+
+	// the fixed point preprocessor against the float one on voiced bursts over noise
+	for (r = 0; r < sizeof(rates) / sizeof(rates[0]); ++r)
+	{
+		int rate = rates[r], length = rate / 50, on = 1, agree = 0;
+		SpeexPreprocessState *st = speex_preprocess_state_init(length, rate);
+		SpeexPreprocessState *fx = speex_preprocess_state_init_fixed(length, rate);
+		short a[320], b[320];
+		double signal = 0, error = 0;
+
+		CHECK(fx);
+
+		speex_preprocess_ctl(st, SPEEX_PREPROCESS_SET_VAD, &on);
+		speex_preprocess_ctl(st, SPEEX_PREPROCESS_SET_DENOISE, &on);
+		speex_preprocess_ctl(fx, SPEEX_PREPROCESS_SET_VAD, &on);
+		speex_preprocess_ctl(fx, SPEEX_PREPROCESS_SET_DENOISE, &on);
+
+		srand(1);
+		for (frame = 0; frame < 500; ++frame)
+		{
+			for (i = 0; i < length; ++i)
+			{
+				int t = frame * length + i;
+				double voice = (frame / 25) % 2 ? 3000 * (sin(2 * M_PI * 150 * t / rate) + 0.5 * sin(2 * M_PI * 450 * t / rate) + 0.3 * sin(2 * M_PI * 1050 * t / rate)) : 0;
+
+				a[i] = b[i] = voice + rand() % 200 - 100;
+			}
+
+			agree += speex_preprocess(st, a, NULL) == speex_preprocess(fx, b, NULL);
+
+			// after the noise estimate settles
+			if (frame >= 50)
+			{
+				for (i = 0; i < length; ++i)
+				{
+					signal += (double)a[i] * a[i];
+					error += (double)(a[i] - b[i]) * (a[i] - b[i]);
+				}
+			}
+		}
+
+		speex_preprocess_state_destroy(st);
+		speex_preprocess_state_destroy(fx);
+
+		CHECK(agree >= 490);
+		CHECK(10 * log10(signal / (error + 1)) > 25);
+	}
+
+	return 0;
+}
+#endif
+
+static const struct
+{
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "mix_minus", test_mix_minus },
+	{ "two_speakers", test_two_speakers },
+	{ "max_speakers", test_max_speakers },
+	{ "manager_events", test_manager_events },
+	{ "max_users", test_max_users },
+	{ "cli", test_cli },
+	{ "listen_volume", test_listen_volume },
+	{ "encode_formats", test_encode_formats },
+	{ "trans_paths", test_trans_paths },
+	{ "join_sounds", test_join_sounds },
+	{ "announcements", test_announcements },
+#if	AST_CONF_SOUND_READERS
+	{ "sound_prefetch", test_sound_prefetch },
+#endif
+#if	AST_CONF_SHARED_MOH
+	{ "shared_moh", test_shared_moh },
+#endif
+#if	AST_CONF_JITTER_BUFFER
+	{ "jitter_buffer", test_jitter_buffer },
+	{ "jitter_buffer_codec", test_jitter_buffer_codec },
+#endif
+#if	AST_CONF_DEDICATED_MIXER_COST
+	{ "dedicated_mixer", test_dedicated_mixer },
+#endif
+#ifndef	AC_USE_G722
+	{ "g711", test_g711 },
+#endif
+	{ "vad_members", test_vad_members },
+#if	(SILDET == 1 || SILDET == 2) && AST_CONF_VAD_GATE
+	{ "vad_gate", test_vad_gate },
+#endif
+#if	SILDET == 1
+	{ "vad_batch", test_vad_batch },
+#endif
+#if	SILDET == 2
+	{ "speex_fft", test_speex_fft },
+	{ "speex_fixed", test_speex_fixed },
+#endif
+};
+
+int main(int argc, char *argv[])
+{
+	int i, failed = 0;
+
+	stub_log_level = LOG_ERROR;
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	if (stub_load_module())
+	{
+		fprintf(stderr, "unable to load module\n");
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i)
+	{
+		failure = NULL;
+
+		if (tests[i].run())
+		{
+			printf("FAIL %s: %s\n", tests[i].name, failure);
+			failed++;
+		}
+		else
+		{
+			printf("PASS %s\n", tests[i].name);
+		}
+	}
+
+	stub_unload_module();
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,368 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * Copyright (C) 2002, 2003 Junghanns.NET GmbH
+ * Copyright (C) 2003, 2004 HorizonLive.com, Inc.
+ * Copyright (C) 2005, 2005 Vipadia Limited
+ * Copyright (C) 2005, 2006 HorizonWimba, Inc.
+ * Copyright (C) 2007 Wimba, Inc.
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#include "asterisk/autoconfig.h"
+#include "trans.h"
+
+//
+// a pool of translator paths for each format pair
+//
+// joining members and new conferences take an idle path from the pool instead
+// of building one, and paths return to it when the member or conference is
+// deleted; a returned path drops the samples buffered by its steps and restarts
+// its timing, while the state of the codecs themselves carries over
+//
+
+#if	ASTERISK_SRC_VERSION < 1000
+#define AST_CONF_FORMAT_ID(format) ((long long)(format))
+#else
+#define AST_CONF_FORMAT_ID(format) ((long long)(format)->id)
+#endif
+
+typedef struct ast_conf_path ast_conf_path;
+typedef struct ast_conf_path_list ast_conf_path_list;
+
+struct ast_conf_path_list
+{
+	// next format pair
+	ast_conf_path_list *next;
+
+	// format pair
+	long long dest;
+	long long source;
+
+	// idle paths
+	ast_conf_path *idle;
+	int count;
+
+	// statistics
+	unsigned int built;
+	unsigned int reused;
+};
+
+struct ast_conf_path
+{
+	// next path in the idle list or hash bucket
+	ast_conf_path *next;
+
+	// translator path and its format pair
+	struct ast_trans_pvt *pvt;
+	ast_conf_path_list *list;
+};
+
+//
+// static variables
+//
+
+static ast_mutex_t path_lock;
+
+// format pairs
+static ast_conf_path_list *path_lists;
+
+// paths handed out, hashed by address
+static ast_conf_path *busy_paths[AST_CONF_PATH_BUCKETS];
+
+static inline int path_bucket(const struct ast_trans_pvt *pvt)
+{
+	return ((unsigned long)pvt >> 4) % AST_CONF_PATH_BUCKETS;
+}
+
+// called with the path lock held
+static ast_conf_path_list* get_path_list(long long dest, long long source)
+{
+	ast_conf_path_list *list;
+
+	for (list = path_lists; list; list = list->next)
+	{
+		if (list->dest == dest && list->source == source)
+			return list;
+	}
+
+	if (!(list = ast_calloc(1, sizeof(ast_conf_path_list))))
+	{
+		return NULL;
+	}
+
+	list->dest = dest;
+	list->source = source;
+	list->next = path_lists;
+	path_lists = list;
+
+	return list;
+}
+
+static void reset_path(struct ast_trans_pvt *pvt)
+{
+	struct ast_trans_pvt *step;
+
+	for (step = pvt; step; step = step->next)
+	{
+		step->samples = 0;
+		step->datalen = 0;
+		step->nextin = step->nextout = ast_tv(0, 0);
+	}
+}
+
+// called with the path lock held, returns -1 if the list is full
+static int put_idle_path(ast_conf_path *path)
+{
+	ast_conf_path_list *list = path->list;
+
+	if (list->count >= AST_CONF_PATH_IDLE)
+	{
+		return -1;
+	}
+
+	path->next = list->idle;
+	list->idle = path;
+	list->count++;
+
+	return 0;
+}
+
+struct ast_trans_pvt* trans_build_path(ast_conf_format dest, ast_conf_format source)
+{
+	ast_conf_path_list *list;
+	ast_conf_path *path = NULL;
+	struct ast_trans_pvt *pvt;
+	int built = 0, bucket;
+
+	ast_mutex_lock(&path_lock);
+
+	if ((list = get_path_list(AST_CONF_FORMAT_ID(dest), AST_CONF_FORMAT_ID(source))) && (path = list->idle))
+	{
+		list->idle = path->next;
+		list->count--;
+		list->reused++;
+	}
+
+	ast_mutex_unlock(&path_lock);
+
+	if (!path)
+	{
+		// build the path outside the lock
+		if (!(pvt = ast_translator_build_path(dest, source)))
+		{
+			return NULL;
+		}
+
+		if (!list || !(path = ast_calloc(1, sizeof(ast_conf_path))))
+		{
+			// not pooled, trans_free_path() frees it
+			return pvt;
+		}
+
+		path->pvt = pvt;
+		path->list = list;
+		built = 1;
+	}
+
+	// remember the path's format pair until it is freed
+	bucket = path_bucket(path->pvt);
+
+	ast_mutex_lock(&path_lock);
+
+	path->list->built += built;
+	path->next = busy_paths[bucket];
+	busy_paths[bucket] = path;
+
+	ast_mutex_unlock(&path_lock);
+
+	return path->pvt;
+}
+
+void trans_free_path(struct ast_trans_pvt* pvt)
+{
+	ast_conf_path **link, *path;
+
+	if (!pvt)
+	{
+		return;
+	}
+
+	ast_mutex_lock(&path_lock);
+
+	for (link = &busy_paths[path_bucket(pvt)]; (path = *link) && path->pvt != pvt; link = &path->next)
+		;
+
+	if (path)
+	{
+		*link = path->next;
+
+		reset_path(pvt);
+
+		if (!put_idle_path(path))
+		{
+			ast_mutex_unlock(&path_lock);
+			return;
+		}
+	}
+
+	ast_mutex_unlock(&path_lock);
+
+	ast_translator_free_path(pvt);
+	ast_free(path);
+}
+
+//
+// manage path functions
+//
+
+// called by conference.c:init_conference()
+int init_trans_paths(void)
+{
+	// the conference's listener paths and the members' paths for each format
+#if	ASTERISK_SRC_VERSION < 1000
+	static const ast_conf_format formats[] = {
+		AST_FORMAT_ULAW,
+		AST_FORMAT_ALAW,
+		AST_FORMAT_GSM,
+#ifdef	AC_USE_SPEEX
+		AST_FORMAT_SPEEX,
+#endif
+#ifdef	AC_USE_G729A
+		AST_FORMAT_G729A,
+#endif
+#ifdef	AC_USE_G722
+		AST_FORMAT_SLINEAR,
+		AST_FORMAT_G722,
+#endif
+	};
+	const ast_conf_format conference = AST_FORMAT_CONFERENCE;
+#else
+	const ast_conf_format formats[] = {
+		&ast_format_ulaw,
+		&ast_format_alaw,
+		&ast_format_gsm,
+#ifdef	AC_USE_SPEEX
+		&ast_format_speex,
+#endif
+#ifdef	AC_USE_G729A
+		&ast_format_g729a,
+#endif
+#ifdef	AC_USE_G722
+		&ast_format_slinear,
+		&ast_format_g722,
+#endif
+	};
+	const ast_conf_format conference = &ast_format_conference;
+#endif
+	int i, n;
+
+	ast_mutex_init(&path_lock);
+
+	for (i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i)
+	{
+		for (n = 0; n < 2; ++n)
+		{
+			ast_conf_format dest = n ? conference : formats[i];
+			ast_conf_format source = n ? formats[i] : conference;
+			ast_conf_path_list *list;
+			int count;
+
+			if (!(list = get_path_list(AST_CONF_FORMAT_ID(dest), AST_CONF_FORMAT_ID(source))))
+			{
+				return -1;
+			}
+
+			for (count = 0; count < AST_CONF_PATH_PREWARM; ++count)
+			{
+				ast_conf_path *path;
+
+				if (!(path = ast_calloc(1, sizeof(ast_conf_path))))
+				{
+					return -1;
+				}
+
+				// formats without a translator are skipped
+				if (!(path->pvt = ast_translator_build_path(dest, source)))
+				{
+					ast_free(path);
+					break;
+				}
+
+				path->list = list;
+				put_idle_path(path);
+
+				list->built++;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// called by conference.c:dealloc_conference()
+void dealloc_trans_paths(void)
+{
+	ast_conf_path_list *list;
+	ast_conf_path *path;
+	int i;
+
+	// paths still handed out are left to their users
+	for (i = 0; i < AST_CONF_PATH_BUCKETS; ++i)
+	{
+		while ((path = busy_paths[i]))
+		{
+			busy_paths[i] = path->next;
+			ast_free(path);
+		}
+	}
+
+	while ((list = path_lists))
+	{
+		path_lists = list->next;
+
+		while ((path = list->idle))
+		{
+			list->idle = path->next;
+			ast_translator_free_path(path->pvt);
+			ast_free(path);
+		}
+
+		ast_free(list);
+	}
+
+	ast_mutex_destroy(&path_lock);
+}
+
+void trans_path_stats(int fd)
+{
+	ast_conf_path_list *list;
+
+	ast_cli(fd, "%-20.20s %-20.20s %-20.20s %-20.20s %-20.20s\n", "Translator Path", "To", "Idle", "Built", "Reused");
+
+	ast_mutex_lock(&path_lock);
+
+	for (list = path_lists; list; list = list->next)
+	{
+		if (!list->built)
+			continue;
+#if	ASTERISK_SRC_VERSION < 1000
+		ast_cli(fd, "%-20.20s %-20.20s %-20d %-20u %-20u\n", ast_getformatname(list->source), ast_getformatname(list->dest),
+			list->count, list->built, list->reused);
+#else
+		struct ast_format source = { .id = list->source }, dest = { .id = list->dest };
+		ast_cli(fd, "%-20.20s %-20.20s %-20d %-20u %-20u\n", ast_getformatname(&source), ast_getformatname(&dest),
+			list->count, list->built, list->reused);
+#endif
+	}
+
+	ast_mutex_unlock(&path_lock);
+}
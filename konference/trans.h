@@ -0,0 +1,72 @@
+/*
+ * app_konference
+ *
+ * A channel independent conference application for Asterisk
+ *
+ * Copyright (C) 2002, 2003 Junghanns.NET GmbH
+ * Copyright (C) 2003, 2004 HorizonLive.com, Inc.
+ * Copyright (C) 2005, 2005 Vipadia Limited
+ * Copyright (C) 2005, 2006 HorizonWimba, Inc.
+ * Copyright (C) 2007 Wimba, Inc.
+ *
+ * This program may be modified and distributed under the
+ * terms of the GNU General Public License. You should have received
+ * a copy of the GNU General Public License along with this
+ * program; if not, write to the Free Software Foundation, Inc.
+ * 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef _KONFERENCE_TRANS_H
+#define _KONFERENCE_TRANS_H
+
+//
+// includes
+//
+
+#include "app_conference.h"
+
+//
+// defines
+//
+
+// paths built for each conference and member format pair when the module is loaded
+#ifndef	AST_CONF_PATH_PREWARM
+#define AST_CONF_PATH_PREWARM 32
+#endif
+
+// idle paths kept for each format pair
+#ifndef	AST_CONF_PATH_IDLE
+#define AST_CONF_PATH_IDLE 1024
+#endif
+
+// hash table size of the paths handed out
+#define AST_CONF_PATH_BUCKETS 997
+
+// translator path format arguments
+#if	ASTERISK_SRC_VERSION == 104 || ASTERISK_SRC_VERSION == 106
+typedef int ast_conf_format;
+#elif	ASTERISK_SRC_VERSION < 1000
+typedef format_t ast_conf_format;
+#else
+typedef struct ast_format* ast_conf_format;
+#endif
+
+//
+// function declarations
+//
+
+// get a translator path from the pool, building one if none is idle
+struct ast_trans_pvt* trans_build_path(ast_conf_format dest, ast_conf_format source);
+// reset a translator path and return it to the pool
+void trans_free_path(struct ast_trans_pvt* path);
+
+// called by conference.c:init_conference()
+int init_trans_paths(void);
+// called by conference.c:dealloc_conference()
+void dealloc_trans_paths(void);
+
+// cli function
+void trans_path_stats(int fd);
+
+#endif